@@ -0,0 +1,133 @@
+/**
+ * @file qpybufferpool.h
+ * @brief Opt-in recycling allocator for QPySharedArray storage and bookkeeping blocks.
+ *
+ * Applications that create and drop many arrays of similar size (e.g. one per video frame)
+ * can enable the pool to reuse buffers instead of returning them to the heap. Buffers are
+ * grouped into power-of-two size classes; every thread keeps a small cache of each class and
+ * falls back to a process-wide depot. Small bookkeeping blocks (array Data objects and the
+ * shared_ptr control blocks of owners) are recycled through per-thread free lists.
+ */
+
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <cstddef>
+#include <memory>
+
+namespace qtpyt {
+
+namespace detail {
+struct OwnerState;
+}
+
+/**
+ * @struct QPyBufferPoolStats
+ * @brief Counters reported by QPyBufferPool::stats().
+ */
+struct QPyBufferPoolStats {
+    quint64 hits = 0;           ///< buffer requests served from a cache
+    quint64 misses = 0;         ///< buffer requests that had to allocate
+    quint64 recycled = 0;       ///< buffers returned to a cache
+    quint64 freed = 0;          ///< buffers released to the heap because the caches were full
+    quint64 smallHits = 0;      ///< bookkeeping blocks served from a free list
+    quint64 smallMisses = 0;    ///< bookkeeping blocks that had to allocate
+    qint64 depotBytes = 0;      ///< bytes currently held in the process-wide depot
+};
+
+/**
+ * @class QPyBufferPool
+ * @brief Process-wide switch and statistics for the QPySharedArray buffer pool.
+ *
+ * The pool is disabled by default. While it is enabled, owned QPySharedArray storage and the
+ * bookkeeping blocks are taken from the pool. Blocks released while the pool is disabled are freed.
+ */
+class QPyBufferPool {
+public:
+    /**
+     * @brief Enable or disable pooling for subsequent allocations.
+     * @param enabled True to enable.
+     */
+    static void setEnabled(bool enabled);
+
+    /**
+     * @brief Whether pooling is enabled.
+     */
+    static bool isEnabled();
+
+    /**
+     * @brief Limit the bytes kept in the process-wide depot (default 256 MiB).
+     * @param bytes Upper bound; 0 disables the depot so only thread caches are used.
+     */
+    static void setMaxDepotBytes(qint64 bytes);
+
+    /**
+     * @brief Largest request served by the pool; larger buffers are allocated directly.
+     */
+    static qint64 maxPooledBytes();
+
+    /**
+     * @brief Size of the class a request of \p bytes is rounded up to.
+     * @return Class size in bytes, or \p bytes itself when it is not pooled.
+     */
+    static qint64 sizeClassBytes(qint64 bytes);
+
+    /**
+     * @brief Snapshot of the pool counters.
+     */
+    static QPyBufferPoolStats stats();
+
+    /**
+     * @brief Reset the hit/miss counters (depotBytes is not a counter and is kept).
+     */
+    static void resetStats();
+
+    /**
+     * @brief Free every cached buffer of the calling thread and of the depot.
+     */
+    static void trim();
+};
+
+namespace detail {
+
+/**
+ * @brief Take a buffer of at least \p bytes from the pool.
+ * @param bytes Requested size.
+ * @param outPtr Receives the 64-byte aligned buffer address.
+ * @param outCapacity Receives the usable size (the size class).
+ * @return Owner that returns the buffer to the pool, or null when the pool is disabled or
+ *         \p bytes exceeds QPyBufferPool::maxPooledBytes().
+ */
+std::shared_ptr<OwnerState> acquirePooledBuffer(qint64 bytes, void** outPtr, qint64* outCapacity);
+
+/**
+ * @brief Allocate a small bookkeeping block, reusing one from the calling thread if possible.
+ * Uses the heap directly while the pool is disabled.
+ */
+void* poolAllocateSmall(std::size_t bytes);
+
+/**
+ * @brief Return a block obtained from poolAllocateSmall(); \p bytes must match the request.
+ */
+void poolFreeSmall(void* p, std::size_t bytes) noexcept;
+
+/**
+ * @brief Standard allocator over poolAllocateSmall(), used for shared_ptr control blocks.
+ */
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U> PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) { return static_cast<T*>(poolAllocateSmall(n * sizeof(T))); }
+    void deallocate(T* p, std::size_t n) noexcept { poolFreeSmall(p, n * sizeof(T)); }
+
+    template <typename U> bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+    template <typename U> bool operator!=(const PoolAllocator<U>&) const noexcept { return false; }
+};
+
+} // namespace detail
+} // namespace qtpyt
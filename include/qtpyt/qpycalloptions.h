@@ -0,0 +1,68 @@
+/// \file qpycalloptions.h
+/// \brief Scheduling options for asynchronous Python calls.
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace qtpyt {
+
+    /// \brief Scheduling class of an asynchronous call.
+    enum class QPyPriority {
+        /// \brief Batch work. Runs when no other work is queued, and never on every worker at once.
+        Background,
+        /// \brief Default class, scheduled in submission order per worker.
+        Normal,
+        /// \brief Latency-critical work (UI). Runs before any queued Normal or Background task.
+        Interactive
+    };
+
+    /// \struct QPyCallOptions
+    /// \brief Priority and deadline attached to a call submitted to the thread pool.
+    /// \details
+    /// Calls with a deadline, and all Interactive calls, are kept in an earliest-deadline-first
+    /// lane that workers drain before anything else. Background calls that waited longer than
+    /// the aging threshold of the pool are promoted ahead of Normal ones, so they are delayed
+    /// but never starved. A call that finishes after its deadline still delivers its result
+    /// and is counted in `QPySchedulerStats::deadlineMisses`.
+    struct QPyCallOptions {
+        /// \brief Scheduling class.
+        QPyPriority priority = QPyPriority::Normal;
+        /// \brief Deadline relative to submission; zero means none.
+        /// Interactive calls without a deadline use the pool's interactive budget.
+        std::chrono::microseconds deadline{0};
+        /// \brief Longest time the call may run once started; zero means unlimited.
+        /// A call that runs longer is interrupted by the watchdog and ends as TimedOut.
+        std::chrono::microseconds timeout{0};
+        /// \brief Default of streamBuffer.
+        static constexpr std::size_t DefaultStreamBuffer = 1024;
+
+        /// \brief Results of a generator call buffered before the generator is paused; zero
+        /// means unbounded. The consumer has to take results (`QPyFuture::takeResult()`/
+        /// `waitForResult()`) for the generator to make progress. Calls with a notifier do not
+        /// buffer: every value goes to IQPyFutureNotifier::notifyResultAvailable() instead.
+        std::size_t streamBuffer = DefaultStreamBuffer;
+
+        /// \brief Options for a latency-critical call, optionally with an explicit deadline.
+        static QPyCallOptions interactive(std::chrono::microseconds deadline = std::chrono::microseconds{0}) {
+            return {QPyPriority::Interactive, deadline, std::chrono::microseconds{0}};
+        }
+
+        /// \brief Options for a batch call.
+        static QPyCallOptions background() {
+            return {QPyPriority::Background, std::chrono::microseconds{0}, std::chrono::microseconds{0}};
+        }
+
+        /// \brief Options for a Normal generator call that pauses after \p buffer untaken results.
+        static QPyCallOptions streaming(std::size_t buffer) {
+            return {QPyPriority::Normal, std::chrono::microseconds{0}, std::chrono::microseconds{0}, buffer};
+        }
+
+        /// \brief Options for a Normal call limited to \p timeout of running time.
+        static QPyCallOptions withTimeout(std::chrono::microseconds timeout) {
+            return {QPyPriority::Normal, std::chrono::microseconds{0}, timeout};
+        }
+    };
+
+} // namespace qtpyt
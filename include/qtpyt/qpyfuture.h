@@ -1,45 +1,134 @@
 #pragma once
 
+#include <QFuture>
 #include <QMetaType>
 #include <QObject>
 #include <QVariant>
+#include <QList>
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
 
+#include "qpycalloptions.h"
 #include "qpymodulebase.h"
 
 class QPyFutureImpl;
 namespace qtpyt {
     class QPyModule;
-    enum class QPyFutureState { NotStarted, Running, Finished, Canceled, Error };
+    enum class QPyFutureState { NotStarted, Running, Finished, Canceled, Error, TimedOut };
 
     class IQPyFutureNotifier  {
       public:
         virtual void notifyStarted() = 0;
         virtual void notifyFinished(const QVariant& value) = 0;
+        /// Called from the worker for every value yielded by a generator or async generator.
+        /// The value is handed over: it is not buffered for QPyFuture::takeResult() as well.
         virtual void notifyResultAvailable(const QVariant& value)  = 0;
+        /// Also called, with a "timed out" message, when a call exceeds its timeout.
         virtual void notifyErrorOccurred(const QString& errorMessage) = 0;
+        /// Called once when the call ends as Canceled, from the thread that cancelled a queued
+        /// call or from the worker that ran it.
+        virtual void notifyCanceled() {}
         virtual  ~IQPyFutureNotifier() = default;
     };
 
     class QPyFuture {
     public:
         QPyFuture(QPyModule module, QSharedPointer<IQPyFutureNotifier> notifier, const QString& functionName,  const QByteArray& returnType,
-            QVariantList&& arguments);
+            QVariantList&& arguments, const QPyCallOptions& options = {});
         QPyFuture(QPyModule module, QSharedPointer<IQPyFutureNotifier> notifier, QString  functionName,  const QByteArray& returnType,
-                                 const QVector<int>& types, void** a);
+                                 const QVector<int>& types, void** a, const QPyCallOptions& options = {});
         QPyFuture(const QPyFuture& other);
         QPyFuture& operator=(const QPyFuture& other);
 
+        /**
+         * @brief Block until the call has completed.
+         *
+         * Off the GUI thread this is a futex wait on the completion flag. On the GUI thread a
+         * local event loop runs until the call completes, so queued signals and calls from
+         * Python into Qt objects are still served.
+         */
         void waitForFinished() const;
 
+        /**
+         * @brief A QFuture that completes with this call, for QFutureWatcher and QtFuture::whenAll.
+         *
+         * It carries the call's first result (if any). An Error becomes a std::runtime_error
+         * exception and Canceled/TimedOut cancel the QFuture.
+         */
+        [[nodiscard]] QFuture<QVariant> toQFuture() const;
+
+        /**
+         * @brief Chain a Python call that takes this call's result.
+         *
+         * The stage runs \p functionName of \p module with the Python object returned by this
+         * call as its only argument. It runs directly on the worker that completes this call,
+         * without going through the Qt event loop or converting the intermediate value to
+         * QVariant. If this call has already finished, the stage is submitted to the pool.
+         * For that, the Python result is kept alive as long as this future.
+         * If this call fails or times out, the stage ends as Error ("previous stage failed: ...")
+         * without running; if it is canceled, the stage is canceled too.
+         * The stage inherits this call's options.
+         * @return The future of the stage.
+         */
+        [[nodiscard]] QPyFuture then(const QPyModule& module, const QString& functionName,
+                                     const QPyRegisteredType& returnType = QMetaType::Void,
+                                     QSharedPointer<IQPyFutureNotifier> notifier = nullptr) const;
+
+        /// @brief Same as above, calling a function of the module this call runs in.
+        [[nodiscard]] QPyFuture then(const QString& functionName,
+                                     const QPyRegisteredType& returnType = QMetaType::Void,
+                                     QSharedPointer<IQPyFutureNotifier> notifier = nullptr) const;
+
+        /**
+         * @brief Run \p fn once the call has completed, whatever its final state.
+         *
+         * Without a \p context, \p fn runs on the thread that completes the call (a pool worker
+         * holding the GIL, or the caller if the call has already completed) and must not block.
+         * With a \p context it is posted to the context's thread, and dropped if the context has
+         * been destroyed by then.
+         * @return This future, so that continuations can be chained.
+         */
+        const QPyFuture& then(std::function<void(const QPyFuture&)> fn, QObject* context = nullptr) const;
+
+        /// @brief Run \p fn with the error message if the call ends as Error or TimedOut.
+        /// Threading is the same as for then().
+        const QPyFuture& onFailed(std::function<void(const QString&)> fn, QObject* context = nullptr) const;
+
+        /// @brief Run \p fn once every future in \p futures has completed (immediately for an
+        /// empty list). Threading is the same as for then().
+        static void whenAll(const QList<QPyFuture>& futures, std::function<void(const QList<QPyFuture>&)> fn,
+                            QObject* context = nullptr);
+
+        /// @brief Run \p fn with the first future in \p futures to complete. Never called for an
+        /// empty list. Threading is the same as for then().
+        static void whenAny(const QList<QPyFuture>& futures, std::function<void(const QPyFuture&)> fn,
+                            QObject* context = nullptr);
+
         QPyFuture(QPyFuture&& other) noexcept;
         QPyFuture& operator=(QPyFuture&& other);
         void operator()() const {
             this->run();
         }
         void run() const;
+        /// Number of buffered results: one for a plain call, the values yielded so far and not
+        /// taken for a generator call.
         [[nodiscard]] int resultCount() const;
         [[nodiscard]] QVariant resultAsVariant(int index) const;
+
+        /**
+         * @brief Take the oldest buffered result, if any, without blocking.
+         *
+         * Generator and async-generator functions without a notifier deliver every yielded value
+         * as a result while they run. Taking results frees room in the buffer; the generator is
+         * paused (with the GIL released) while the call's `streamBuffer` is full.
+         */
+        [[nodiscard]] std::optional<QVariant> takeResult() const;
+
+        /// @brief Block until a result can be taken, or return std::nullopt once the call has
+        /// completed and all results have been taken. Not meant for the GUI thread.
+        [[nodiscard]] std::optional<QVariant> waitForResult() const;
         template <typename T> T resultAs(int index) {
             if (index < 0 || index >= this->resultCount()) {
                 qWarning() << "QPyFuture::resultAs: index out of range:" << index;
@@ -49,11 +138,40 @@ namespace qtpyt {
             return var.value<T>();
         }
         [[nodiscard]] QPyFutureState state() const;
+        /// True once the final state is set and the notifier has been called.
+        [[nodiscard]] bool isCompleted() const;
+
+        /**
+         * @brief Cancel the call.
+         *
+         * A call that has not started is dropped by the worker that dequeues it. A running call
+         * gets \c qpyasync.CancelledError raised asynchronously in its thread (at the next
+         * bytecode boundary) and \c qpyasync.cancelled() starts returning True, so cooperative
+         * loops can stop early. A coroutine awaited on a worker loop has its asyncio task
+         * canceled instead (\c asyncio.CancelledError at its current \c await), and
+         * \c qpyasync.cancelled() answers for it too. Either way the state becomes Canceled and
+         * the notifier's notifyCanceled() is called.
+         * @return false if the call had already completed.
+         */
+        bool cancel();
 
         [[nodiscard]] QPyModule* callablePtr() const;
+        /// Identity of the module the task calls into (QPyModuleBase::moduleId()).
+        [[nodiscard]] quintptr moduleId() const;
         [[nodiscard]] QString errorMessage() const;
 
+        /// Scheduling options the call was created with.
+        [[nodiscard]] const QPyCallOptions& options() const;
+        /// Time the call was created, which is when it was submitted.
+        [[nodiscard]] std::chrono::steady_clock::time_point createdAt() const;
+        /// Absolute deadline the scheduler works to: the one in the options, or the pool's
+        /// interactive budget for Interactive calls without one.
+        [[nodiscard]] std::optional<std::chrono::steady_clock::time_point> deadline() const;
+
     private:
+        friend class QPyFutureAwaiter;
+
+        explicit QPyFuture(std::shared_ptr<QPyFutureImpl> impl);
 
         std::shared_ptr<QPyFutureImpl> m_impl;
     };
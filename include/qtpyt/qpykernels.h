@@ -0,0 +1,223 @@
+/**
+ * @file qpykernels.h
+ * @brief Vectorized and multithreaded numeric kernels over contiguous arrays and QPySharedArray.
+ *
+ * The kernels are compiled for several instruction sets (AVX-512 and AVX2 on x86-64 with GCC
+ * or Clang, plus the baseline target of the build, which is NEON on AArch64) and the best one
+ * supported by the CPU is selected at run time. Large arrays are partitioned across
+ * QThreadPool::globalInstance().
+ * The same kernels are available to Python as the \c qt_interop.kernels module.
+ *
+ * Supported element types: quint8, qint32, qint64, float and double.
+ */
+
+#pragma once
+
+#include "qpysharedarray.h"
+
+#include <QtCore/QtGlobal>
+
+#include <stdexcept>
+#include <utility>
+
+namespace qtpyt {
+
+/**
+ * @brief Instruction set used by the kernels.
+ */
+enum class QPySimdLevel {
+    Scalar,   ///< baseline code generation of the build (SSE2 on x86-64)
+    Neon,     ///< AArch64 Advanced SIMD
+    Avx2,     ///< x86-64 AVX2 + FMA
+    Avx512    ///< x86-64 AVX-512 F/BW/DQ/VL
+};
+
+/**
+ * @brief Elementwise binary operation.
+ */
+enum class QPyKernelOp {
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Min,
+    Max
+};
+
+/**
+ * @brief Mean and (population) variance of an array.
+ */
+struct QPyMoments {
+    double mean = 0.0;
+    double variance = 0.0;
+};
+
+namespace kernels {
+
+/**
+ * @brief Best instruction set supported by this CPU and build.
+ */
+QPySimdLevel detectedSimdLevel();
+
+/**
+ * @brief Instruction set the kernels currently dispatch to.
+ */
+QPySimdLevel simdLevel();
+
+/**
+ * @brief Restrict dispatch to \p level (clamped to detectedSimdLevel()); mostly useful for benchmarks.
+ */
+void setSimdLevel(QPySimdLevel level);
+
+/**
+ * @brief Name of \p level as used by the Python module ("scalar", "neon", "avx2", "avx512").
+ */
+const char* simdLevelName(QPySimdLevel level);
+
+/**
+ * @brief Maximum number of threads a single kernel call uses; 1 disables partitioning.
+ * Defaults to QThreadPool::globalInstance()->maxThreadCount() + 1 (the caller participates).
+ */
+void setMaxThreads(int threads);
+int maxThreads();
+
+/**
+ * @brief Element count from which a call is split across threads (default 256 Ki).
+ */
+void setParallelThreshold(qsizetype elements);
+qsizetype parallelThreshold();
+
+/**
+ * @brief out[i] = a[i] op b[i]. \p out may alias \p a or \p b.
+ */
+template <typename T>
+void binary(QPyKernelOp op, const T* a, const T* b, T* out, qsizetype n);
+
+/**
+ * @brief out[i] = a[i] op s. \p out may alias \p a.
+ */
+template <typename T>
+void binaryScalar(QPyKernelOp op, const T* a, T s, T* out, qsizetype n);
+
+/**
+ * @brief Sum of the elements, accumulated in double (integers exactly up to 2^53).
+ */
+template <typename T>
+double sum(const T* a, qsizetype n);
+
+/**
+ * @brief Smallest and largest element.
+ * @throws std::invalid_argument if \p n is 0.
+ */
+template <typename T>
+std::pair<T, T> minMax(const T* a, qsizetype n);
+
+/**
+ * @brief Mean and population variance, computed per partition and merged (Chan et al.).
+ * @throws std::invalid_argument if \p n is 0.
+ */
+template <typename T>
+QPyMoments moments(const T* a, qsizetype n);
+
+/**
+ * @brief Inclusive prefix sum: out[i] = a[0] + ... + a[i]. \p out may alias \p a.
+ */
+template <typename T>
+void inclusiveScan(const T* a, T* out, qsizetype n);
+
+/**
+ * @brief Clamp every element to [lo, hi] in place.
+ */
+template <typename T>
+void clamp(T* a, qsizetype n, T lo, T hi);
+
+/**
+ * @brief dst[i] = To(src[i] * scale + offset), saturated to the range of \p To for integer targets.
+ * With scale 1 and offset 0 this is a plain cast.
+ */
+template <typename From, typename To>
+void convert(const From* src, To* dst, qsizetype n, double scale = 1.0, double offset = 0.0);
+
+#define QTPYT_KERNELS_EXTERN(T)                                                             \
+    extern template void binary<T>(QPyKernelOp, const T*, const T*, T*, qsizetype);         \
+    extern template void binaryScalar<T>(QPyKernelOp, const T*, T, T*, qsizetype);          \
+    extern template double sum<T>(const T*, qsizetype);                                     \
+    extern template std::pair<T, T> minMax<T>(const T*, qsizetype);                         \
+    extern template QPyMoments moments<T>(const T*, qsizetype);                             \
+    extern template void inclusiveScan<T>(const T*, T*, qsizetype);                         \
+    extern template void clamp<T>(T*, qsizetype, T, T);
+
+QTPYT_KERNELS_EXTERN(quint8)
+QTPYT_KERNELS_EXTERN(qint32)
+QTPYT_KERNELS_EXTERN(qint64)
+QTPYT_KERNELS_EXTERN(float)
+QTPYT_KERNELS_EXTERN(double)
+#undef QTPYT_KERNELS_EXTERN
+
+#define QTPYT_CONVERT_EXTERN(From)                                                          \
+    extern template void convert<From, quint8>(const From*, quint8*, qsizetype, double, double); \
+    extern template void convert<From, qint32>(const From*, qint32*, qsizetype, double, double); \
+    extern template void convert<From, qint64>(const From*, qint64*, qsizetype, double, double); \
+    extern template void convert<From, float>(const From*, float*, qsizetype, double, double);   \
+    extern template void convert<From, double>(const From*, double*, qsizetype, double, double);
+
+QTPYT_CONVERT_EXTERN(quint8)
+QTPYT_CONVERT_EXTERN(qint32)
+QTPYT_CONVERT_EXTERN(qint64)
+QTPYT_CONVERT_EXTERN(float)
+QTPYT_CONVERT_EXTERN(double)
+#undef QTPYT_CONVERT_EXTERN
+
+// ---- QPySharedArray convenience overloads ----------------------------------------------
+
+/**
+ * @brief a[i] = a[i] op b[i] in place.
+ * @throws std::invalid_argument if the sizes differ.
+ */
+template <typename T>
+void apply(QPyKernelOp op, QPySharedArray<T>& a, const QPySharedArray<T>& b) {
+    if (a.size() != b.size())
+        throw std::invalid_argument("qtpyt::kernels::apply: array sizes differ");
+    T* p = a.data();
+    binary<T>(op, p, b.constData(), p, a.size());
+}
+
+/**
+ * @brief a[i] = a[i] op s in place.
+ */
+template <typename T>
+void apply(QPyKernelOp op, QPySharedArray<T>& a, T s) {
+    T* p = a.data();
+    binaryScalar<T>(op, p, s, p, a.size());
+}
+
+template <typename T>
+double sum(const QPySharedArray<T>& a) { return sum<T>(a.constData(), a.size()); }
+
+template <typename T>
+std::pair<T, T> minMax(const QPySharedArray<T>& a) { return minMax<T>(a.constData(), a.size()); }
+
+template <typename T>
+QPyMoments moments(const QPySharedArray<T>& a) { return moments<T>(a.constData(), a.size()); }
+
+template <typename T>
+void inclusiveScan(QPySharedArray<T>& a) {
+    T* p = a.data();
+    inclusiveScan<T>(p, p, a.size());
+}
+
+template <typename T>
+void clamp(QPySharedArray<T>& a, T lo, T hi) { clamp<T>(a.data(), a.size(), lo, hi); }
+
+/**
+ * @brief Convert \p src into a new array of \p To.
+ */
+template <typename To, typename From>
+QPySharedArray<To> converted(const QPySharedArray<From>& src, double scale = 1.0, double offset = 0.0) {
+    QPySharedArray<To> dst(src.size());
+    convert<From, To>(src.constData(), dst.data(), src.size(), scale, offset);
+    return dst;
+}
+
+} // namespace kernels
+} // namespace qtpyt
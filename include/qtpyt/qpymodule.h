@@ -7,8 +7,6 @@
 /// `QPyFuture`.
 ///
 /// Threading model:\n
-/// \- Instances track the creating thread id and expect interactions to respect
-///   the underlying Qt/Python thread constraints.\n
 /// \- Asynchronous calls are scheduled via qtpyt thread facilities (see `qpythreadpool.h`).
 ///
 /// \note `PYBIND11_NO_KEYWORDS` is defined to avoid keyword argument collisions in pybind11.
@@ -73,16 +71,39 @@ public:
         return callAsyncVariant(notifier, functionName, returnType, std::move(varArgs));
     }
 
+    /// \brief Asynchronously calls a Python function by name with a priority and/or deadline.
+    /// \details Same as the overload without options; \p options decides how the pool
+    /// schedules the call (see `QPyCallOptions`).
+    /// \tparam Args Arguments.
+    /// \param options Priority class and deadline of the call.
+    /// \param notifier Optional notifier used to observe completion/progress.
+    /// \param functionName Name of the Python callable to invoke.
+    /// \param returnType Expected return type information for marshalling.
+    /// \param args Arguments forwarded and converted into a `QVariantList`.
+    /// \return `QPyFuture` on successful scheduling; `std::nullopt` on failure.
+    template<typename... Args>
+    std::optional<QPyFuture> callAsync(const QPyCallOptions &options,
+                                       const QSharedPointer<IQPyFutureNotifier> &notifier,
+                                       const QString &functionName,
+                                       const QPyRegisteredType &returnType,
+                                       Args... args) const {
+        QVariantList varArgs;
+        (varArgs.push_back(QVariant::fromValue(args)), ...);
+        return callAsyncVariant(notifier, functionName, returnType, std::move(varArgs), options);
+    }
+
     /// \brief Asynchronously calls a Python function by name with explicit arguments.
     /// \param notifier Optional notifier used to observe completion/progress.
     /// \param functionName Name of the Python callable to invoke.
     /// \param returnType Expected return type information for marshalling.
     /// \param args Argument list; moved into the call to avoid copies.
+    /// \param options Priority class and deadline of the call.
     /// \return `QPyFuture` on successful scheduling; `std::nullopt` on failure.
     std::optional<QPyFuture> callAsyncVariant(const QSharedPointer<IQPyFutureNotifier> &notifier,
                                        const QString &functionName,
                                        const QPyRegisteredType &returnType,
-                                       QVariantList &&args) const;
+                                       QVariantList &&args,
+                                       const QPyCallOptions &options = {}) const;
 
 
     /// \brief Creates a typed async function wrapper bound to this module.
@@ -116,39 +137,12 @@ public:
     /// \param slotName Name of the slot/function to bind.
     /// \param returnType Expected return type; defaults to `void`.
     /// \param notifier Optional notifier used to observe completion/progress.
+    /// \param options Scheduling options of the calls made by asynchronous connections.
     /// \return A `QPySlot` bound to \p slotName.
     QPySlot makeSlot(const QString &slotName,
                      const QPyRegisteredType &returnType = QMetaType::Void,
-                     const QSharedPointer<IQPyFutureNotifier> &notifier = nullptr);
-
-protected:
-    /// \brief Returns the thread id associated with this module instance.
-    /// \return An implementation\-defined thread id value.
-    auto getThreadId() const;
-
-    /// \brief Captures/sets the current thread id as the module's associated thread.
-    void setThreadId();
-
-private:
-    /// \brief Marks the module as wanting to cancel outstanding work.
-    /// \details Used internally to coordinate cancellation state.
-    void addWantsToCancel();
-
-private:
-    /// \brief Human\-readable cancel reason, if cancellation is requested.
-    QString m_cancelReason;
-
-    /// \brief True if cancellation has been triggered.
-    bool m_cancelled{false};
-
-    /// \brief True when execution is complete.
-    bool m_finished{false};
-
-    /// \brief True when cancellation has been requested but not yet applied.
-    bool m_wantsToCancel{false};
-
-    /// \brief Thread id captured for thread\-affinity/validation logic.
-    qulonglong m_threadId{0};
+                     const QSharedPointer<IQPyFutureNotifier> &notifier = nullptr,
+                     const QPyCallOptions &options = {});
 };
 
 } // namespace qtpyt
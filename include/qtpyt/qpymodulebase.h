@@ -22,6 +22,9 @@
 #include <qtpyt/qpyannotation.h>
 #include <QRunnable>
 #include <QVariant>
+#include <chrono>
+
+class QPyFutureImpl;
 
 namespace qtpyt {
 
@@ -132,17 +135,25 @@ namespace qtpyt {
         /// \return True if the underlying module/callable state is valid for use.
         [[nodiscard]] bool isValid() const;
 
+        /// \brief Identity of the underlying Python module, shared by all copies of this wrapper.
+        /// \return A value that is equal for copies and stable for the lifetime of the module.
+        [[nodiscard]] quintptr moduleId() const { return reinterpret_cast<quintptr>(m_internal.get()); }
+
         /// \brief Calls a Python function by name with explicit Qt arguments.
         /// \param function Name of the Python callable to invoke.
         /// \param returnType Conversion target used to convert the Python return value.
         /// \param args Positional arguments.
         /// \param kwargs Keyword arguments (name \-\> value).
+        /// \param timeout Longest running time; zero means unlimited. When it passes, the watchdog
+        /// raises `qpyasync.CancelledError` in the calling thread and the call returns a
+        /// "timed out" error. Intended for calls made from pool workers and other non-GUI threads.
         /// \return Converted return value on success; `std::nullopt` on conversion failure.
         /// \throws std::runtime_error if the function cannot be found or invoked.
         [[nodiscard]] std::pair<std::optional<QVariant>, QString> call(const QString &function,
                                                                  const QPyRegisteredType &returnType,
                                                                  const QVariantList &args,
-                                                                       const QVariantMap &kwargs = {});
+                                                                       const QVariantMap &kwargs = {},
+                                                                       std::chrono::microseconds timeout = {});
 
         /// \brief Selects which function name is considered the "current" callable.
         /// \details Affects `pythonCallable()`, `call(tuple, dict)`, and `makeFunction()`.
@@ -316,6 +327,9 @@ namespace qtpyt {
         QPyModuleImpl* getInternal();
 
     private:
+        /// Chained Python stages pass results between calls without converting them to Qt.
+        friend class ::QPyFutureImpl;
+
         /// \brief Builds/initializes the module from literal Python source code.
         /// \param source Python code to execute.
         /// \throws std::runtime_error on compilation/execution failure.
@@ -0,0 +1,373 @@
+/**
+ * @file qpyrecord.h
+ * @brief Compile-time field description of record (struct) types for QPySharedArray.
+ *
+ * A QPySharedArray of a described record type is exported to Python with a PEP 3118 struct
+ * format such as \c "<T{q:timestamp:d:price:i:volume:b:side:3x}", so NumPy
+ * (\c numpy.asarray(view)) sees a structured dtype with named fields and the exact layout
+ * of the C++ type, padding included.
+ *
+ * @code
+ * struct Tick {
+ *     qint64 timestamp;
+ *     double price;
+ *     qint32 volume;
+ *     char side;
+ * };
+ * QTPYT_RECORD(Tick, timestamp, price, volume, side)
+ *
+ * qtpyt::init();
+ * qtpyt::registerRecordArray<Tick>("QPySharedArray<Tick>");
+ * @endcode
+ *
+ * Fields may be arithmetic types, std::complex, fixed-size arrays (C arrays or std::array)
+ * of those, or other described records. The macro works for Q_GADGET types as well: the
+ * gadget meta-object lists properties but not member offsets, so it cannot describe the
+ * memory layout by itself.
+ *
+ * The same header provides the PEP 3118 format strings of all element types (namespace
+ * qtpyt::pep3118), which the library uses for its own conversions.
+ */
+
+#pragma once
+
+#include <QtCore/qfloat16.h>
+#include <QtCore/QMetaType>
+#include <QtCore/QVariant>
+
+#include <array>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <type_traits>
+
+#include "qpysharedarray.h"
+
+namespace qtpyt {
+
+/**
+ * @brief Field description of a record type; specialized by QTPYT_RECORD.
+ *
+ * A specialization provides \c isRecord = true and a static \c visit(v) that calls
+ * \c v.template field<FieldType>(name, offset) for every field in declaration order.
+ */
+template <typename T, typename = void>
+struct QPyRecord {
+    static constexpr bool isRecord = false;
+};
+
+namespace pep3118 {
+
+// -----------------------------
+// PEP 3118 format generation
+// -----------------------------
+
+
+constexpr const char* native_byte_order_prefix() {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && defined(__ORDER_BIG_ENDIAN__)
+#  if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    return "<";
+#  elif (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    return ">";
+#  else
+    return "=";
+#  endif
+#elif defined(_WIN32)
+    return "<"; // Windows is little-endian on supported architectures
+#else
+    return "="; // safest fallback
+#endif
+}
+
+template <typename T>
+std::string integral_code() {
+    static_assert(std::is_integral_v<T>, "integral_code<T> requires integral T");
+    if constexpr (std::is_same_v<T, bool>) {
+        return "?";
+    } else if constexpr (sizeof(T) == 1) {
+        return std::is_signed_v<T> ? "b" : "B";
+    } else if constexpr (sizeof(T) == 2) {
+        return std::is_signed_v<T> ? "h" : "H";
+    } else if constexpr (sizeof(T) == 4) {
+        return std::is_signed_v<T> ? "i" : "I";
+    } else if constexpr (sizeof(T) == 8) {
+        return std::is_signed_v<T> ? "q" : "Q";
+    } else {
+        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
+                      "Unsupported integer size");
+        return "";
+    }
+}
+
+template <typename T>
+std::string float_code() {
+    static_assert(std::is_floating_point_v<T>, "float_code<T> requires floating-point T");
+    if constexpr (sizeof(T) == 4) return "f";
+    if constexpr (sizeof(T) == 8) return "d";
+    // long double is messy across platforms; PEP 3118 uses 'g' for long double.
+    if constexpr (std::is_same_v<T, long double>) return "g";
+    static_assert(sizeof(T) == 4 || sizeof(T) == 8 || std::is_same_v<T, long double>,
+                  "Unsupported float size for PEP 3118 mapping");
+    return "";
+}
+
+template <typename T>
+std::string complex_code() {
+    static_assert(std::is_same_v<T, std::complex<float>> ||
+                  std::is_same_v<T, std::complex<double>> ||
+                  std::is_same_v<T, std::complex<long double>>,
+                  "Unsupported complex type for PEP 3118 mapping");
+
+    if constexpr (std::is_same_v<T, std::complex<float>>)       return "Zf";
+    if constexpr (std::is_same_v<T, std::complex<double>>)      return "Zd";
+    if constexpr (std::is_same_v<T, std::complex<long double>>) return "Zg";
+    return "";
+}
+
+template <typename T, typename Enable = void>
+struct format {
+    // Default: refuse unless trivially copyable AND user chooses to expose as bytes.
+    static std::string code() {
+        static_assert(std::is_void_v<Enable>,
+                      "pep3118::format<T> not specialized for this type");
+        return "";
+    }
+};
+
+template <typename T>
+struct format<T, std::enable_if_t<std::is_integral_v<T>>> {
+    static std::string code() { return integral_code<T>(); }
+};
+
+// Floating specialization
+template <typename T>
+struct format<T, std::enable_if_t<std::is_floating_point_v<T>>> {
+    static std::string code() { return float_code<T>(); }
+};
+
+template <typename T>
+struct format<T, std::enable_if_t<
+    std::is_same_v<T, std::complex<float>> ||
+    std::is_same_v<T, std::complex<double>> ||
+    std::is_same_v<T, std::complex<long double>>
+>> {
+    static std::string code() { return complex_code<T>(); }
+};
+
+// IEEE 754 half precision ("e", NumPy float16)
+template <>
+struct format<qfloat16> {
+    static std::string code() { return "e"; }
+};
+
+// Raw bytes
+template <>
+struct format<std::byte> {
+    static std::string code() { return "B"; }
+};
+
+// Code of a record field: scalars, nested records and fixed-size arrays ("(4,2)d").
+template <typename F>
+std::string field_code();
+
+template <typename F>
+struct array_field {
+    static constexpr bool value = false;
+};
+
+template <typename E, std::size_t N>
+struct array_field<std::array<E, N>> {
+    static constexpr bool value = true;
+    using element = E;
+    static std::string shape() { return std::to_string(N); }
+};
+
+template <typename E, std::size_t N>
+struct array_field<E[N]> {
+    static constexpr bool value = true;
+    using element = std::remove_all_extents_t<E>;
+    static std::string shape() {
+        std::string s = std::to_string(N);
+        if constexpr (std::rank_v<E> > 0)
+            s += "," + array_field<E>::shape();
+        return s;
+    }
+};
+
+// Builds "T{...}" from QPyRecord<T>::visit; gaps between fields and trailing padding become "Nx".
+// Field codes carry no byte-order prefix, the prefix of the enclosing format applies.
+struct record_builder {
+    std::string out;
+    std::size_t position = 0;
+
+    void pad(std::size_t offset) {
+        if (offset > position)
+            out += (offset - position == 1 ? std::string() : std::to_string(offset - position)) + "x";
+        position = offset;
+    }
+
+    template <typename F>
+    void field(const char* name, std::size_t offset) {
+        pad(offset);
+        out += field_code<F>();
+        out += ':';
+        out += name;
+        out += ':';
+        position = offset + sizeof(F);
+    }
+};
+
+template <typename T>
+std::string record_code() {
+    record_builder b;
+    b.out = "T{";
+    qtpyt::QPyRecord<T>::visit(b);
+    b.pad(sizeof(T));
+    b.out += '}';
+    return b.out;
+}
+
+template <typename T>
+struct format<T, std::enable_if_t<qtpyt::QPyRecord<T>::isRecord>> {
+    static std::string code() { return record_code<T>(); }
+};
+
+template <typename F>
+std::string field_code() {
+    if constexpr (array_field<F>::value)
+        return "(" + array_field<F>::shape() + ")" + format<typename array_field<F>::element>::code();
+    else
+        return format<F>::code();
+}
+
+} // namespace pep3118
+
+namespace detail {
+
+/**
+ * @struct RecordArrayStorage
+ * @brief Storage of one QPySharedArray value of a record type, for the Python exporter.
+ */
+struct RecordArrayStorage {
+    void* data = nullptr;                      ///< first element
+    qsizetype count = 0;                       ///< element count
+    bool readonly = false;                     ///< the array is read-only
+    std::atomic<int>* exports = nullptr;       ///< live export counter of the storage
+    std::shared_ptr<ChangeTracker> changes;    ///< change tracking state, if enabled
+    std::shared_ptr<OwnerState> anchor;        ///< keeps the storage alive
+};
+
+/**
+ * @struct RecordArrayType
+ * @brief Layout and accessors of a QPySharedArray<T> record type, independent of T.
+ */
+struct RecordArrayType {
+    std::string code;                                   ///< element format without byte-order prefix
+    qsizetype itemsize = 0;                             ///< sizeof(T)
+    QPyArrayExportMode (*exportMode)() = nullptr;       ///< sharedArrayExportMode<T>
+    RecordArrayStorage (*storage)(const void* array) = nullptr; ///< storage of a QPySharedArray<T>
+    QVariant (*wrap)(void* data, qsizetype count, bool readonly, std::shared_ptr<OwnerState> owner) = nullptr;
+    QVariant (*copy)(const void* data, qsizetype count) = nullptr;
+};
+
+/**
+ * @brief Add the Python conversions of the array metatype \p typeId.
+ * @note Python must be initialized (qtpyt::init()).
+ */
+void registerRecordArrayType(int typeId, RecordArrayType type);
+
+template <typename T>
+struct RecordArrayAccess {
+    using Data = typename QPySharedArray<T>::Data;
+
+    static RecordArrayStorage storage(const void* array) {
+        const auto& a = *static_cast<const QPySharedArray<T>*>(array);
+        RecordArrayStorage s;
+        s.data = const_cast<T*>(a.constData());
+        s.count = a.size();
+        s.readonly = a.isReadOnly();
+        s.exports = &a.d_->m_exports;
+        s.changes = a.d_->m_changes;
+        a.d_->ref.ref();
+        s.anchor = make_owner(a.d_.data(), [](void* p) {
+            auto* d = static_cast<Data*>(p);
+            if (!d->ref.deref())
+                delete d;
+        });
+        return s;
+    }
+
+    static QVariant wrap(void* data, qsizetype count, bool readonly, std::shared_ptr<OwnerState> owner) {
+        auto a = QPySharedArray<T>::wrapWithOwner(static_cast<T*>(data), count, false, std::move(owner));
+        if (readonly)
+            a.setReadOnly(true);
+        return QVariant::fromValue(a);
+    }
+
+    static QVariant copy(const void* data, qsizetype count) {
+        QPySharedArray<T> a(count);
+        if (count > 0)
+            std::memcpy(a.data(), data, size_t(count) * sizeof(T));
+        return QVariant::fromValue(a);
+    }
+};
+
+} // namespace detail
+
+/**
+ * @brief Register QPySharedArray<T> of the record type \p T with the Python conversions.
+ *
+ * Arrays are passed to Python like the built-in element types, as memoryviews or ndarrays
+ * (see setSharedArrayExportMode()) sharing the C++ storage. Contiguous 1-D buffers with the
+ * same \c "T{...}" layout, such as structured NumPy arrays, are accepted back without a copy.
+ * Call once per type after qtpyt::init().
+ *
+ * @param typeName Name of the metatype, e.g. \c "QPySharedArray<Tick>".
+ * @return Metatype id of QPySharedArray<T>.
+ */
+template <typename T>
+int registerRecordArray(const char* typeName) {
+    static_assert(QPyRecord<T>::isRecord, "registerRecordArray requires a type described with QTPYT_RECORD");
+    const int id = qRegisterMetaType<QPySharedArray<T>>(typeName);
+    detail::RecordArrayType type;
+    type.code = pep3118::record_code<T>();
+    type.itemsize = qsizetype(sizeof(T));
+    type.exportMode = &sharedArrayExportMode<T>;
+    type.storage = &detail::RecordArrayAccess<T>::storage;
+    type.wrap = &detail::RecordArrayAccess<T>::wrap;
+    type.copy = &detail::RecordArrayAccess<T>::copy;
+    detail::registerRecordArrayType(id, std::move(type));
+    return id;
+}
+
+} // namespace qtpyt
+
+// Preprocessor iteration over the field list (up to 256 fields).
+#define QTPYT_RECORD_PARENS ()
+#define QTPYT_RECORD_EXPAND(...) QTPYT_RECORD_EXPAND4(QTPYT_RECORD_EXPAND4(QTPYT_RECORD_EXPAND4(QTPYT_RECORD_EXPAND4(__VA_ARGS__))))
+#define QTPYT_RECORD_EXPAND4(...) QTPYT_RECORD_EXPAND3(QTPYT_RECORD_EXPAND3(QTPYT_RECORD_EXPAND3(QTPYT_RECORD_EXPAND3(__VA_ARGS__))))
+#define QTPYT_RECORD_EXPAND3(...) QTPYT_RECORD_EXPAND2(QTPYT_RECORD_EXPAND2(QTPYT_RECORD_EXPAND2(QTPYT_RECORD_EXPAND2(__VA_ARGS__))))
+#define QTPYT_RECORD_EXPAND2(...) QTPYT_RECORD_EXPAND1(QTPYT_RECORD_EXPAND1(QTPYT_RECORD_EXPAND1(QTPYT_RECORD_EXPAND1(__VA_ARGS__))))
+#define QTPYT_RECORD_EXPAND1(...) __VA_ARGS__
+#define QTPYT_RECORD_FOR_EACH(Type, ...) __VA_OPT__(QTPYT_RECORD_EXPAND(QTPYT_RECORD_FOR_EACH_HELPER(Type, __VA_ARGS__)))
+#define QTPYT_RECORD_FOR_EACH_HELPER(Type, member, ...)                                          \
+    QTPYT_RECORD_FIELD(Type, member)                                                             \
+    __VA_OPT__(QTPYT_RECORD_FOR_EACH_AGAIN QTPYT_RECORD_PARENS (Type, __VA_ARGS__))
+#define QTPYT_RECORD_FOR_EACH_AGAIN() QTPYT_RECORD_FOR_EACH_HELPER
+#define QTPYT_RECORD_FIELD(Type, member) v.template field<decltype(Type::member)>(#member, offsetof(Type, member));
+
+/**
+ * @brief Describe the fields of \p Type (in declaration order) for record exports.
+ * Use at global namespace scope after the definition of \p Type.
+ */
+#define QTPYT_RECORD(Type, ...)                                                                  \
+    template <>                                                                                  \
+    struct qtpyt::QPyRecord<Type> {                                                              \
+        static_assert(std::is_standard_layout_v<Type> && std::is_trivially_copyable_v<Type>,     \
+                      "QTPYT_RECORD requires a standard-layout, trivially copyable type");       \
+        static constexpr bool isRecord = true;                                                   \
+        template <typename V>                                                                    \
+        static void visit(V&& v) { QTPYT_RECORD_FOR_EACH(Type, __VA_ARGS__) }                    \
+    };
@@ -0,0 +1,365 @@
+/**
+ * @file qpyringbuffer.h
+ * @brief Lock-free ring buffer for streaming samples from C++ producers to a Python consumer.
+ *
+ * Producers push elements without touching the interpreter. The consumer (typically a Python
+ * task on a QPyThreadPool worker) drains the buffer in contiguous spans; Python receives
+ * them as zero-copy memoryviews, two of them when the readable region wraps around the end
+ * of the storage.
+ *
+ * @code
+ * qtpyt::QPyRingBuffer<float> ring(1 << 16);
+ * // acquisition thread
+ * ring.push(samples, count);
+ * // Python (ring passed as an argument, see qt_interop.RingBuffer):
+ * //   first, second = ring.read()
+ * //   process(first); process(second)
+ * //   ring.consume(len(first) + len(second))
+ * @endcode
+ */
+
+#pragma once
+
+#include "qpysharedarray.h"
+
+#include <QtCore/QtGlobal>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+
+namespace qtpyt {
+
+/**
+ * @brief Number of threads allowed to push into a QPyRingBuffer concurrently.
+ */
+enum class QPyRingMode {
+    SingleProducer,   ///< one producer thread (SPSC): no atomic read-modify-write on push
+    MultiProducer     ///< any number of producer threads (MPSC); one extra 64-bit word per element
+};
+
+namespace detail {
+
+/**
+ * @struct QPyRingState
+ * @brief Element-type independent state shared by QPyRingBuffer handles and Python readers.
+ *
+ * Positions are free-running 64-bit counters; the slot of position p is p & mask.
+ * The consumer side (readable(), consume(), waitForData()) must be used by one thread at a time.
+ */
+struct QPyRingState {
+    static constexpr std::size_t CacheLine = 64;
+
+    // written by producers
+    alignas(CacheLine) std::atomic<quint64> head{0};      ///< end of the published region
+    alignas(CacheLine) std::atomic<quint64> reserve{0};   ///< end of the reserved region (MPSC)
+    quint64 cachedTail = 0;                               ///< producer's last view of tail (SPSC)
+    std::atomic<quint64> dropped{0};                      ///< elements rejected because the buffer was full
+    // written by the consumer
+    alignas(CacheLine) std::atomic<quint64> tail{0};      ///< first unread position
+    std::atomic<int> waiters{0};
+
+    char* base = nullptr;
+    quint64 capacity = 0;
+    quint64 mask = 0;
+    qsizetype itemsize = 0;
+    QPyRingMode mode = QPyRingMode::SingleProducer;
+
+    /// MPSC: end position of the reservation starting at each slot, stored once it is written
+    std::unique_ptr<std::atomic<quint64>[]> published;
+
+    std::mutex waitMutex;
+    std::condition_variable waitCondition;
+
+    virtual ~QPyRingState() = default;
+
+    quint64 size() const {
+        const quint64 t = tail.load(std::memory_order_acquire);
+        return head.load(std::memory_order_acquire) - t;
+    }
+
+    /**
+     * @brief Readable region as up to two (element offset, element count) pieces.
+     */
+    struct Span {
+        quint64 firstOffset = 0;
+        quint64 firstSize = 0;
+        quint64 secondSize = 0;    ///< the second piece always starts at offset 0
+        quint64 size() const { return firstSize + secondSize; }
+    };
+
+    Span readable(quint64 maxElements = ~quint64(0)) const {
+        const quint64 t = tail.load(std::memory_order_relaxed);
+        const quint64 n = std::min(head.load(std::memory_order_acquire) - t, maxElements);
+        Span s;
+        s.firstOffset = t & mask;
+        s.firstSize = std::min(n, capacity - s.firstOffset);
+        s.secondSize = n - s.firstSize;
+        return s;
+    }
+
+    void consume(quint64 n) {
+        const quint64 t = tail.load(std::memory_order_relaxed);
+        const quint64 available = head.load(std::memory_order_acquire) - t;
+        if (n > available)
+            throw std::out_of_range("QPyRingBuffer: consume() past the readable region");
+        tail.store(t + n, std::memory_order_release);
+    }
+
+    /**
+     * @brief Block until at least \p minElements are readable or \p timeoutMs expires (< 0 waits forever).
+     * @return true if the data is available.
+     */
+    bool waitForData(quint64 minElements, int timeoutMs) {
+        auto ready = [&] { return size() >= minElements; };
+        if (ready())
+            return true;
+        waiters.fetch_add(1, std::memory_order_seq_cst);
+        bool ok;
+        {
+            std::unique_lock<std::mutex> lock(waitMutex);
+            if (timeoutMs < 0) {
+                waitCondition.wait(lock, ready);
+                ok = true;
+            } else {
+                ok = waitCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs), ready);
+            }
+        }
+        waiters.fetch_sub(1, std::memory_order_relaxed);
+        return ok;
+    }
+
+    /**
+     * @brief MPSC: mark the reservation [pos, end) as written and move head over every written
+     * reservation it reaches. A producer never waits for another one: whoever completes the
+     * reservation at head also publishes the completed reservations behind it.
+     */
+    void publish(quint64 pos, quint64 end) {
+        // seq_cst on both sides: either this producer sees the head reach pos, or the producer
+        // that moves head there sees this flag
+        published[pos & mask].store(end, std::memory_order_seq_cst);
+        quint64 h = head.load(std::memory_order_seq_cst);
+        for (;;) {
+            // a flag left from an earlier lap ends at or before h
+            const quint64 e = published[h & mask].load(std::memory_order_seq_cst);
+            if (e <= h)
+                return;
+            if (head.compare_exchange_strong(h, e, std::memory_order_seq_cst))
+                h = e;
+        }
+    }
+
+    // Called by producers after publishing; costs one load when nobody waits.
+    void notifyConsumer() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (waiters.load(std::memory_order_relaxed) > 0) {
+            std::lock_guard<std::mutex> lock(waitMutex);
+            waitCondition.notify_all();
+        }
+    }
+};
+
+template <typename T>
+struct QPyRingStorage : QPyRingState {
+    QPySharedArray<T> array;
+};
+
+} // namespace detail
+
+/**
+ * @class QPyRingBuffer
+ * @brief Bounded lock-free FIFO of trivially copyable elements on QPySharedArray storage.
+ *
+ * Handles are cheap to copy and share the same buffer. push() never blocks and never allocates:
+ * when the buffer is full the elements that do not fit are rejected and counted in
+ * droppedCount(). In QPyRingMode::SingleProducer mode only one thread may push; in
+ * QPyRingMode::MultiProducer mode producers reserve space with a CAS and flag their reservation
+ * once it is written. The consumer sees elements in reservation order: a preempted producer
+ * delays the elements reserved after it, but no producer ever waits for another one.
+ * There is always a single consumer.
+ *
+ * @tparam T Element type (trivially copyable).
+ */
+template <typename T>
+class QPyRingBuffer {
+    static_assert(std::is_trivially_copyable_v<T>, "QPyRingBuffer requires trivially copyable T");
+
+public:
+    using value_type = T;
+
+    /**
+     * @brief Elements readable by the consumer, split at the end of the storage.
+     */
+    struct Span {
+        const T* first = nullptr;
+        qsizetype firstSize = 0;
+        const T* second = nullptr;
+        qsizetype secondSize = 0;
+        qsizetype size() const { return firstSize + secondSize; }
+    };
+
+    /// Null handle (needed by QMetaType); isNull() returns true.
+    QPyRingBuffer() = default;
+
+    /**
+     * @brief Allocate a buffer for at least \p capacity elements (rounded up to a power of two).
+     * @throws std::invalid_argument if \p capacity is not positive.
+     */
+    explicit QPyRingBuffer(qsizetype capacity, QPyRingMode mode = QPyRingMode::SingleProducer) {
+        if (capacity <= 0)
+            throw std::invalid_argument("QPyRingBuffer: capacity must be positive");
+        quint64 cap = 1;
+        while (cap < quint64(capacity))
+            cap <<= 1;
+        auto s = std::make_shared<detail::QPyRingStorage<T>>();
+        s->array = QPySharedArray<T>(qsizetype(cap));
+        s->base = reinterpret_cast<char*>(s->array.data());
+        s->capacity = cap;
+        s->mask = cap - 1;
+        s->itemsize = qsizetype(sizeof(T));
+        s->mode = mode;
+        if (mode == QPyRingMode::MultiProducer) {
+            s->published.reset(new std::atomic<quint64>[size_t(cap)]);
+            for (quint64 i = 0; i < cap; ++i)
+                s->published[size_t(i)].store(0, std::memory_order_relaxed);
+        }
+        s_ = std::move(s);
+    }
+
+    bool isNull() const { return !s_; }
+    qsizetype capacity() const { return s_ ? qsizetype(s_->capacity) : 0; }
+    QPyRingMode mode() const { return s_ ? s_->mode : QPyRingMode::SingleProducer; }
+
+    /// Elements currently readable.
+    qsizetype size() const { return s_ ? qsizetype(s_->size()) : 0; }
+    bool isEmpty() const { return size() == 0; }
+
+    /// Total number of elements push() rejected because the buffer was full.
+    quint64 droppedCount() const { return s_ ? s_->dropped.load(std::memory_order_relaxed) : 0; }
+
+    /**
+     * @brief Append \p value.
+     * @return false if the buffer is full.
+     */
+    bool push(const T& value) { return push(&value, 1) == 1; }
+
+    /**
+     * @brief Append up to \p n elements from \p src.
+     * @return Number of elements written; the rest are dropped.
+     */
+    qsizetype push(const T* src, qsizetype n) {
+        if (!s_ || n <= 0)
+            return 0;
+        detail::QPyRingState& s = *s_;
+        const quint64 want = quint64(n);
+        quint64 pos;
+        quint64 count;
+        if (s.mode == QPyRingMode::SingleProducer) {
+            pos = s.head.load(std::memory_order_relaxed);
+            quint64 free = s.capacity - (pos - s.cachedTail);
+            if (free < want) {
+                s.cachedTail = s.tail.load(std::memory_order_acquire);
+                free = s.capacity - (pos - s.cachedTail);
+            }
+            count = std::min(free, want);
+            if (count) {
+                copyIn(pos, src, count);
+                s.head.store(pos + count, std::memory_order_release);
+            }
+        } else {
+            pos = s.reserve.load(std::memory_order_relaxed);
+            do {
+                const quint64 free = s.capacity - (pos - s.tail.load(std::memory_order_acquire));
+                count = std::min(free, want);
+                if (!count)
+                    break;
+            } while (!s.reserve.compare_exchange_weak(pos, pos + count, std::memory_order_acq_rel,
+                                                      std::memory_order_relaxed));
+            if (count) {
+                copyIn(pos, src, count);
+                s.publish(pos, pos + count);
+            }
+        }
+        if (count < want)
+            s.dropped.fetch_add(want - count, std::memory_order_relaxed);
+        if (count)
+            s.notifyConsumer();
+        return qsizetype(count);
+    }
+
+    /**
+     * @brief Readable elements (at most \p maxElements) without consuming them.
+     * The pointers stay valid until consume() releases the elements.
+     */
+    Span readable(qsizetype maxElements = std::numeric_limits<qsizetype>::max()) const {
+        Span span;
+        if (!s_ || maxElements <= 0)
+            return span;
+        const auto r = s_->readable(quint64(maxElements));
+        const T* base = reinterpret_cast<const T*>(s_->base);
+        span.first = base + r.firstOffset;
+        span.firstSize = qsizetype(r.firstSize);
+        span.second = base;
+        span.secondSize = qsizetype(r.secondSize);
+        return span;
+    }
+
+    /**
+     * @brief Release \p n elements returned by readable() to the producers.
+     * @throws std::out_of_range if fewer than \p n elements are readable.
+     */
+    void consume(qsizetype n) {
+        if (s_ && n > 0)
+            s_->consume(quint64(n));
+    }
+
+    /**
+     * @brief Copy up to \p maxElements into \p dst and consume them.
+     * @return Number of elements copied.
+     */
+    qsizetype pop(T* dst, qsizetype maxElements) {
+        const Span span = readable(maxElements);
+        if (span.firstSize)
+            std::memcpy(dst, span.first, size_t(span.firstSize) * sizeof(T));
+        if (span.secondSize)
+            std::memcpy(dst + span.firstSize, span.second, size_t(span.secondSize) * sizeof(T));
+        consume(span.size());
+        return span.size();
+    }
+
+    /**
+     * @brief Block the consumer until \p minElements are readable or \p timeoutMs expires (< 0 waits forever).
+     */
+    bool waitForData(qsizetype minElements = 1, int timeoutMs = -1) {
+        return s_ && s_->waitForData(quint64(std::max<qsizetype>(minElements, 0)), timeoutMs);
+    }
+
+    /// Backing storage (capacity() elements, indexed by position modulo capacity).
+    QPySharedArray<T> storage() const {
+        return s_ ? static_cast<detail::QPyRingStorage<T>*>(s_.get())->array : QPySharedArray<T>();
+    }
+
+    /// Type-erased shared state, used by the Python bindings.
+    std::shared_ptr<detail::QPyRingState> state() const { return s_; }
+
+private:
+    void copyIn(quint64 pos, const T* src, quint64 count) {
+        T* base = reinterpret_cast<T*>(s_->base);
+        const quint64 offset = pos & s_->mask;
+        const quint64 first = std::min(count, s_->capacity - offset);
+        std::memcpy(base + offset, src, size_t(first) * sizeof(T));
+        if (count > first)
+            std::memcpy(base, src + first, size_t(count - first) * sizeof(T));
+    }
+
+    std::shared_ptr<detail::QPyRingState> s_;
+};
+
+} // namespace qtpyt
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <QtCore/QSharedPointer>
+#include <QtCore/QSharedData>
 #include <QtCore/QByteArray>
 #include <QtCore/QtGlobal>
 
@@ -18,13 +19,45 @@
 #include <type_traits>
 #include <utility>
 #include <algorithm>
+#include <atomic>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <QMap>
 #include <QVariant>
+#include <QString>
+
+#include "qpybufferpool.h"
 
 namespace qtpyt {
 
+/**
+ * @brief Access mode of a file mapped with QPySharedArray::mapFile().
+ */
+enum class QPyMapMode {
+    ReadOnly,     ///< read-only view; the Python buffer is read-only too
+    ReadWrite,    ///< writes go through to the file
+    CopyOnWrite   ///< private writable mapping; the file is never modified
+};
+
+/**
+ * @brief Python type that QPySharedArray values are converted to.
+ *
+ * @note memoryview cannot index or list the complex formats ("Zf", "Zd"); complex arrays
+ * should be exported in NumPy mode, or read as \c view.cast('B').cast('f') (interleaved
+ * real and imaginary parts).
+ */
+enum class QPyArrayExportMode {
+    MemoryView,   ///< memoryview over the storage (default, needs no NumPy)
+    NumPy         ///< numpy.ndarray over the storage; memoryview if NumPy cannot be imported
+};
+
 namespace detail {
 
+template <typename T>
+inline std::atomic<QPyArrayExportMode> arrayExportMode{QPyArrayExportMode::MemoryView};
+
 /**
  * @struct OwnerState
  * @brief Helper that holds a void pointer and a deleter to manage external lifetime.
@@ -43,11 +76,141 @@ struct OwnerState {
 
 
 inline std::shared_ptr<OwnerState> make_owner(void* estate, void (*deleter)(void*)) {
-    return std::make_shared<OwnerState>(estate, deleter);
+    // Owners are created for every wrapped or exported buffer; recycle their control blocks.
+    return std::allocate_shared<OwnerState>(PoolAllocator<OwnerState>(), estate, deleter);
 }
 
+/**
+ * @brief Map \p bytes of \p path starting at \p offset into memory.
+ *
+ * @param path File to map.
+ * @param offset Byte offset of the mapping.
+ * @param bytes Mapping length; a negative value maps up to the end of the file.
+ * @param mode Access mode.
+ * @param outPtr Receives the address of the first mapped byte.
+ * @param outBytes Receives the mapped length.
+ * @return Owner that unmaps and closes the file when released.
+ * @throws std::runtime_error if the file cannot be opened or mapped.
+ */
+std::shared_ptr<OwnerState> mapFileRegion(const QString& path, qint64 offset, qint64 bytes, QPyMapMode mode,
+                                          void** outPtr, qint64* outBytes);
+
+/**
+ * @brief Create a shared-memory segment of \p bytes and map it read-write.
+ *
+ * A non-empty \p name creates a named POSIX segment (shm_open) that other processes can attach to;
+ * an empty name creates an anonymous segment (memfd_create where available) that is shared by
+ * passing its file descriptor. The descriptor is close-on-exec: it survives fork() and can be
+ * sent over a Unix socket, but must have FD_CLOEXEC cleared (or be dup2()'ed) before exec.
+ *
+ * @param name Segment name; a leading '/' is added when missing.
+ * @param bytes Segment size.
+ * @param unlinkOnRelease Remove the segment name when the mapping is released.
+ * @param outPtr Receives the address of the mapping.
+ * @param outFd If not null, receives the segment descriptor; the caller closes it.
+ * @return Owner that unmaps (and optionally unlinks) the segment when released.
+ * @throws std::runtime_error on failure or on platforms without POSIX shared memory.
+ */
+std::shared_ptr<OwnerState> createSharedMemoryRegion(const QString& name, qint64 bytes, bool unlinkOnRelease,
+                                                     void** outPtr, int* outFd);
+
+/**
+ * @brief Attach to an existing named shared-memory segment.
+ * @param name Segment name; a leading '/' is added when missing.
+ * @param bytes Length to map; a negative value maps the whole segment.
+ * @param mode Access mode.
+ * @param outPtr Receives the address of the mapping.
+ * @param outBytes Receives the mapped length.
+ * @return Owner that unmaps the segment when released.
+ * @throws std::runtime_error on failure or on platforms without POSIX shared memory.
+ */
+std::shared_ptr<OwnerState> attachSharedMemoryRegion(const QString& name, qint64 bytes, QPyMapMode mode,
+                                                     void** outPtr, qint64* outBytes);
+
+/**
+ * @brief Reserve a zero-filled anonymous region whose pages are committed on first touch.
+ * @param bytes Region size.
+ * @param hugePages Ask the kernel to back the region with transparent huge pages.
+ * @param outPtr Receives the address of the region.
+ * @return Owner that releases the region.
+ * @throws std::runtime_error if the region cannot be allocated.
+ */
+std::shared_ptr<OwnerState> allocateAnonymousRegion(qint64 bytes, bool hugePages, void** outPtr);
+
+template <typename T>
+struct SharedArrayAccess; ///< grants the Python buffer exporter access to the array storage
+
+template <typename T>
+struct RecordArrayAccess; ///< the same for record types registered with registerRecordArray()
+
+/**
+ * @class ChangeTracker
+ * @brief Per-block modification stamps of a QPySharedArray (see QPySharedArray::enableChangeTracking()).
+ *
+ * Every block of blockElements() elements remembers the epoch of its last modification.
+ * changedRanges() reports the blocks stamped at or after a version and starts a new epoch;
+ * consecutive queries overlap by one epoch, so a write that races with a query is reported by
+ * the next one as well. Marking is lock-free and stamps never move backwards.
+ */
+class ChangeTracker {
+public:
+    ChangeTracker(qsizetype blockElements, qsizetype count);
+    ChangeTracker(const ChangeTracker& o);
+    ChangeTracker& operator=(const ChangeTracker&) = delete;
+
+    qsizetype blockElements() const { return qsizetype(1) << m_shift; }
+    quint64 version() const { return m_epoch.load(std::memory_order_acquire); }
+
+    /// Stamp the blocks covering [from, from + count) with the current epoch.
+    void mark(qsizetype from, qsizetype count) {
+        if (count <= 0 || from < 0)
+            return;
+        const quint64 epoch = m_epoch.load(std::memory_order_acquire);
+        const qsizetype last = std::min<qsizetype>((from + count - 1) >> m_shift, m_blocks - 1);
+        for (qsizetype b = from >> m_shift; b <= last; ++b) {
+            // a marker that read the epoch before a query must not lower a newer stamp
+            auto& stamp = m_stamps[size_t(b)];
+            quint64 current = stamp.load(std::memory_order_relaxed);
+            while (current < epoch && !stamp.compare_exchange_weak(current, epoch, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    /// Follow a resize from \p oldCount to \p count elements; new elements count as changed.
+    void resize(qsizetype oldCount, qsizetype count);
+
+    /**
+     * @brief Element ranges of the first \p count elements changed at or after \p since.
+     * Adjacent blocks are merged. Starts a new epoch and stores the version to pass next time in \p next;
+     * that version still covers the epoch closed here, see the class description.
+     */
+    std::vector<std::pair<qsizetype, qsizetype>> ranges(quint64 since, qsizetype count, quint64* next);
+
+private:
+    std::atomic<quint64> m_epoch{1};
+    int m_shift = 0;
+    qsizetype m_blocks = 0;
+    std::unique_ptr<std::atomic<quint64>[]> m_stamps;
+};
+
 } // namespace detail
 
+/**
+ * @brief Half-open element range [begin, end) reported by QPySharedArray::changedRanges().
+ */
+struct QPyChangedRange {
+    qsizetype begin = 0;
+    qsizetype end = 0;
+};
+
+/**
+ * @brief Result of QPySharedArray::changedRanges().
+ */
+struct QPyChangeSet {
+    std::vector<QPyChangedRange> ranges;  ///< changed ranges in ascending order
+    quint64 version = 0;                  ///< pass to the next changedRanges() call
+};
+
 
 class external; ///< forward declaration for external usage in other headers
 
@@ -76,20 +239,20 @@ public:
     /**
      * @brief Construct an empty QPySharedArray.
      */
-    QPySharedArray() : d_(QSharedPointer<Data>::create()) {}
+    QPySharedArray() : d_(new Data) {}
 
     /**
      * @brief Construct with \p n default-initialized elements.
      * @param n Number of elements to reserve/resize to.
      */
-    explicit QPySharedArray(size_type n) : d_(QSharedPointer<Data>::create()) { resize(n); }
+    explicit QPySharedArray(size_type n) : d_(new Data) { resize(n); }
 
     /**
      * @brief Wrap an external buffer as a QPySharedArray view.
      *
      * @param externalPtr Pointer to external element data.
      * @param n Number of elements pointed to by \p externalPtr.
-     * @param takeOwnership If true, the array will delete[] \p externalPtr when owning Data is destroyed.
+     * @param takeOwnership If true, the array will delete[] \p externalPtr when the last Data referencing it is destroyed.
      * @return QPySharedArray<T> view over the external data.
      */
     static QPySharedArray wrap(T* externalPtr, size_type n, bool takeOwnership = false) {
@@ -121,6 +284,108 @@ public:
         return a;
     }
 
+    /**
+     * @brief Map a file region and present it as an array without reading it into memory.
+     *
+     * The mapping is shared by all copies of the array and by every Python buffer exported
+     * from it; it is released together with the last of them.
+     * Operations that reallocate (resize(), reserve()) copy the data into owned storage.
+     *
+     * @param path File to map.
+     * @param offset Byte offset of the first element; must be a multiple of alignof(T).
+     * @param count Number of elements to map; -1 maps up to the end of the file.
+     * @param mode Access mode. ReadOnly arrays are exported to Python as read-only buffers.
+     * @return QPySharedArray<T> view over the mapped file.
+     * @throws std::runtime_error if the file cannot be mapped.
+     */
+    static QPySharedArray mapFile(const QString& path, qint64 offset = 0, size_type count = -1,
+                                  QPyMapMode mode = QPyMapMode::ReadOnly) {
+        static_assert(std::is_trivially_copyable_v<T>, "mapFile requires trivially copyable T");
+        if (offset < 0 || offset % qint64(alignof(T)) != 0)
+            throw std::runtime_error("QPySharedArray::mapFile: offset is not aligned to the element type");
+        void* ptr = nullptr;
+        qint64 bytes = 0;
+        auto owner = detail::mapFileRegion(path, offset, count < 0 ? -1 : Data::byteCount(count),
+                                           mode, &ptr, &bytes);
+        QPySharedArray a = wrapWithOwner(static_cast<T*>(ptr), size_type(bytes / qint64(sizeof(T))), false,
+                                         std::move(owner));
+        if (mode == QPyMapMode::ReadOnly)
+            a.setReadOnly(true);
+        return a;
+    }
+
+    /**
+     * @brief Create an array backed by a shared-memory segment.
+     *
+     * A named segment can be attached from another process with attachSharedMemory(), or from
+     * Python with \c multiprocessing.shared_memory.SharedMemory(name) (without the leading '/').
+     * The elements are zero-initialized.
+     *
+     * @param name Segment name; empty creates an anonymous segment (see \p outFd).
+     * @param count Number of elements; must be positive.
+     * @param unlinkOnRelease Remove the segment name when this process releases the mapping.
+     * @param outFd If not null, receives a close-on-exec descriptor of the segment. Send it to
+     *        another process or clear FD_CLOEXEC before exec'ing a child that uses it. The caller
+     *        closes it.
+     * @return QPySharedArray<T> over the segment.
+     * @throws std::runtime_error if the segment cannot be created.
+     */
+    static QPySharedArray createSharedMemory(const QString& name, size_type count, bool unlinkOnRelease = true,
+                                             int* outFd = nullptr) {
+        static_assert(std::is_trivially_copyable_v<T>, "createSharedMemory requires trivially copyable T");
+        if (count <= 0)
+            throw std::runtime_error("QPySharedArray::createSharedMemory: count must be positive");
+        void* ptr = nullptr;
+        auto owner = detail::createSharedMemoryRegion(name, Data::byteCount(count), unlinkOnRelease,
+                                                      &ptr, outFd);
+        return wrapWithOwner(static_cast<T*>(ptr), count, false, std::move(owner));
+    }
+
+    /**
+     * @brief Attach to a named shared-memory segment created by this or another process.
+     * @param name Segment name.
+     * @param count Number of elements; -1 maps the whole segment.
+     * @param mode Access mode. ReadOnly arrays are exported to Python as read-only buffers.
+     * @return QPySharedArray<T> over the segment.
+     * @throws std::runtime_error if the segment cannot be attached.
+     */
+    static QPySharedArray attachSharedMemory(const QString& name, size_type count = -1,
+                                             QPyMapMode mode = QPyMapMode::ReadWrite) {
+        static_assert(std::is_trivially_copyable_v<T>, "attachSharedMemory requires trivially copyable T");
+        void* ptr = nullptr;
+        qint64 bytes = 0;
+        auto owner = detail::attachSharedMemoryRegion(name, count < 0 ? -1 : Data::byteCount(count),
+                                                      mode, &ptr, &bytes);
+        QPySharedArray a = wrapWithOwner(static_cast<T*>(ptr), size_type(bytes / qint64(sizeof(T))), false,
+                                         std::move(owner));
+        if (mode == QPyMapMode::ReadOnly)
+            a.setReadOnly(true);
+        return a;
+    }
+
+    /**
+     * @brief Allocate a large zero-initialized array outside of QByteArray.
+     *
+     * The storage is reserved with an anonymous mapping, so no page is committed before it is
+     * first written; this keeps multi-gigabyte arrays cheap to create and avoids heap
+     * fragmentation. Resizing beyond the allocated count copies into owned storage.
+     *
+     * @param count Number of elements; must be positive.
+     * @param transparentHugePages Advise the kernel to use transparent huge pages (Linux only,
+     *        ignored elsewhere).
+     * @return QPySharedArray<T> over the new region.
+     * @throws std::length_error if the byte size does not fit into qsizetype.
+     * @throws std::runtime_error if the region cannot be allocated.
+     */
+    static QPySharedArray allocateLarge(size_type count, bool transparentHugePages = false) {
+        static_assert(std::is_trivially_copyable_v<T>, "allocateLarge requires trivially copyable T");
+        if (count <= 0)
+            throw std::runtime_error("QPySharedArray::allocateLarge: count must be positive");
+        void* ptr = nullptr;
+        auto owner = detail::allocateAnonymousRegion(Data::byteCount(count), transparentHugePages, &ptr);
+        return wrapWithOwner(static_cast<T*>(ptr), count, false, std::move(owner));
+    }
+
     /**
      * @brief Check whether the array is empty.
      * @return True if size() == 0.
@@ -147,9 +412,30 @@ public:
 
     /**
      * @brief Mutable access to element data; detaches if necessary (copy-on-write).
+     * A read-only array over external storage (a ReadOnly mapFile() or attachSharedMemory(),
+     * which the OS maps without write access) moves to a private, writable copy first.
+     * With change tracking enabled the whole array is marked as changed; use mutableRange()
+     * to mark only the part that is written.
      * @return Pointer to first element.
      */
-    T* data() { detach(); return d_->ptr(); }
+    T* data() {
+        detachForWrite();
+        if (Q_UNLIKELY(d_->m_changes))
+            d_->m_changes->mark(0, d_->m_size);
+        return d_->ptr();
+    }
+
+    /**
+     * @brief Mutable pointer to element \p from for writing \p count elements.
+     * Detaches like data(), but marks only [from, from + count) as changed.
+     */
+    T* mutableRange(size_type from, size_type count) {
+        Q_ASSERT(from >= 0 && count >= 0 && from + count <= size());
+        detachForWrite();
+        if (Q_UNLIKELY(d_->m_changes))
+            d_->m_changes->mark(from, count);
+        return d_->ptr() + from;
+    }
 
     /**
      * @brief Const element access with bounds assertion.
@@ -163,7 +449,7 @@ public:
      * @param i Element index (0-based).
      * @return Reference to element.
      */
-    T& operator[](size_type i) { Q_ASSERT(i >= 0 && i < size()); return data()[i]; }
+    T& operator[](size_type i) { Q_ASSERT(i >= 0 && i < size()); return *mutableRange(i, 1); }
 
     /**
      * @brief Clear the array (resize to 0).
@@ -177,7 +463,10 @@ public:
     void resize(size_type n) {
         if (n == d_->m_size) return;
         detach();
+        const size_type old = d_->m_size;
         d_->resize(n);
+        if (d_->m_changes)
+            d_->m_changes->resize(old, n);
     }
 
     /**
@@ -191,15 +480,21 @@ public:
     }
 
     /**
-     * @brief Detach from shared data (copy the Data object).
+     * @brief Detach from shared data (copy the Data object if it is shared).
      *
      * This implements Qt-like detach semantics: subsequent modifications will
-     * operate on a private copy of the data.
+     * operate on a private copy of the data. Buffers exported to Python hold a
+     * reference too, so writing after an export detaches from the exported storage.
      */
     void detach() {
-                d_ = QSharedPointer<Data>::create(*d_);
+        d_.detach();
     }
 
+    /**
+     * @brief True if no other array or Python export shares the storage, so writes do not copy.
+     */
+    bool isDetached() const { return d_->ref.loadRelaxed() == 1; }
+
     /**
      * @brief Query whether the underlying storage is read-only.
      * When set to true, the corresponding memoryview in Python will be read-only.
@@ -219,6 +514,75 @@ public:
         d_->m_readonly = r;
     }
 
+    /**
+     * @brief Number of Python buffer views currently exported from the shared storage.
+     *
+     * Every memoryview handed to Python holds a reference to the storage and is counted
+     * here until it is released. Like any write, resize() and reserve() detach from storage
+     * that is exported, so the views keep the elements they were created over.
+     * @return Active export count.
+     */
+    int exportCount() const {
+        return d_->m_exports.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Start recording which elements change.
+     *
+     * The array is divided into blocks of \p blockElements elements (rounded up to a power of
+     * two; 0 selects 64 KiB worth of elements). Mutating accessors (operator[], mutableRange(),
+     * data(), resize()) stamp the blocks they touch; writes through other pointers, including
+     * Python buffers, are reported with markChanged(). Copies that share the storage share the
+     * tracking state, and so do detached copies of external storage (mapFile(),
+     * createSharedMemory(), allocateLarge(), wrap()), which keep writing the same memory; a copy
+     * detached into storage of its own continues with its own state.
+     */
+    void enableChangeTracking(size_type blockElements = 0) {
+        if (blockElements <= 0)
+            blockElements = std::max<size_type>(1, size_type(65536 / sizeof(T)));
+        d_->m_changes = std::make_shared<detail::ChangeTracker>(blockElements, d_->m_size);
+    }
+
+    void disableChangeTracking() { d_->m_changes.reset(); }
+
+    bool isTrackingChanges() const { return bool(d_->m_changes); }
+
+    /**
+     * @brief Current change version; 0 when tracking is disabled.
+     */
+    quint64 changeVersion() const { return d_->m_changes ? d_->m_changes->version() : 0; }
+
+    /**
+     * @brief Record that [from, from + count) was modified without a mutating accessor.
+     */
+    void markChanged(size_type from, size_type count = 1) {
+        if (d_->m_changes)
+            d_->m_changes->mark(from, count);
+    }
+
+    /**
+     * @brief Element ranges changed at or after \p sinceVersion, at block granularity.
+     *
+     * Pass the returned version to the next call to get the later changes; version 0 reports the
+     * whole array. Without tracking the whole array is reported with version 0.
+     * The mutating accessors stamp a block before the caller writes it, so a block written
+     * while this call runs may be reported before the new data is there. The next call reports
+     * it again: blocks changed just before a call show up in two consecutive results.
+     */
+    QPyChangeSet changedRanges(quint64 sinceVersion) const {
+        QPyChangeSet set;
+        if (!d_->m_changes) {
+            if (d_->m_size > 0)
+                set.ranges.push_back({0, d_->m_size});
+            return set;
+        }
+        const auto r = d_->m_changes->ranges(sinceVersion, d_->m_size, &set.version);
+        set.ranges.reserve(r.size());
+        for (const auto& [b, e] : r)
+            set.ranges.push_back({b, e});
+        return set;
+    }
+
     /**
      * @brief Convert to QVariant for easy use with Qt APIs.
      * @return QVariant holding a copy of this QPySharedArray.
@@ -228,12 +592,24 @@ public:
     }
 
 private:
+    template <typename U> friend struct detail::SharedArrayAccess;
+    template <typename U> friend struct detail::RecordArrayAccess;
+
+    // detach() for the accessors that hand out writable memory; read-only external storage
+    // may not be mapped writable, so it is never written through
+    void detachForWrite() {
+        detach();
+        if (Q_UNLIKELY(d_->m_readonly && d_->aliasesExternal())) {
+            d_->ensureOwnedStorage(d_->m_capacity);
+            d_->m_readonly = false;
+        }
+    }
 
     /**
      * @brief Internal storage object that holds either owned bytes or an external view.
      *
      */
-    struct Data {
+    struct Data : public QSharedData {
 
         QByteArray owned;                             ///< owned bytes (when not external)
         T* extPtr = nullptr;                          ///< external pointer when m_external is true
@@ -242,32 +618,59 @@ private:
         size_type m_capacity = 0;                     ///< capacity in elements
 
         bool m_external{false};                       ///< true when using extPtr
-        bool m_takeOwnership{false};                  ///< if true, delete[] extPtr on destruction
+        bool m_takeOwnership{false};                  ///< if true, extPtr is delete[]d together with owner
         bool m_readonly{false};                       ///< read-only flag
+        bool m_pooled{false};                         ///< extPtr is a QPyBufferPool block held by owner
+
+        std::atomic<int> m_exports{0};                ///< live Python buffer exports of this Data
 
         std::shared_ptr<detail::OwnerState> owner;    ///< optional owner that keeps external source alive
+        std::shared_ptr<detail::ChangeTracker> m_changes; ///< block stamps while change tracking is on
 
         Data() = default;
 
         /**
          * @brief Copy constructor: copies view/owner semantics for external buffers.
+         *
+         * Pooled storage is private to its Data, so it is copied into a new block.
+         * Exports are not copied: they belong to the Data instance that Python references.
+         * Change tracking state is shared while the copy still aliases the same external
+         * storage (mapped files, shared memory, wrapped buffers), so writes through either
+         * copy reach the stamps a Python export reads; otherwise it is cloned, so versions
+         * stay valid across a detach.
          */
         Data(const Data& o)
-            : owned(o.owned),
+            : QSharedData(o),
+              owned(o.owned),
               extPtr(o.extPtr),
               m_size(o.m_size),
               m_capacity(o.m_capacity),
               m_external(o.m_external),
               m_takeOwnership(o.m_takeOwnership),
-              owner(o.owner)
-        {}
-
-        ~Data() {
-            if (m_external && m_takeOwnership && extPtr) {
-                delete[] extPtr;
+              m_readonly(o.m_readonly),
+              owner(o.owner),
+              m_changes(o.m_changes && !o.aliasesExternal() ? std::make_shared<detail::ChangeTracker>(*o.m_changes)
+                                                             : o.m_changes)
+        {
+            if (o.m_pooled) {
+                m_external = false;
+                extPtr = nullptr;
+                owner.reset();
+                m_capacity = 0;
+                ensureOwnedStorage(o.m_capacity, o.extPtr);
             }
         }
 
+        ~Data() = default;
+
+        // Data objects churn with every array; recycled through the pool's free lists while
+        // QPyBufferPool is enabled, plain heap blocks otherwise.
+        static void* operator new(std::size_t n) { return detail::poolAllocateSmall(n); }
+        static void operator delete(void* p, std::size_t n) { detail::poolFreeSmall(p, n); }
+
+        /// True if copies of this Data keep pointing at the same external elements.
+        bool aliasesExternal() const { return m_external && !m_pooled; }
+
         /**
          * @brief Pointer to element storage (owned or external).
          * @return Pointer to first element.
@@ -287,6 +690,15 @@ private:
          * @param keepAlive Optional owner shared_ptr to keep external owner alive.
          */
         void resetToExternal(T* p, size_type n, bool takeOwn, std::shared_ptr<detail::OwnerState> keepAlive) {
+            if (takeOwn && p) {
+                // The buffer is shared by every Data copy, so it is released with the last owner reference.
+                using Holder = std::pair<T*, std::shared_ptr<detail::OwnerState>>;
+                keepAlive = detail::make_owner(new Holder(p, std::move(keepAlive)), [](void* h) {
+                    auto* holder = static_cast<Holder*>(h);
+                    delete[] holder->first;
+                    delete holder;
+                });
+            }
             owned.clear();
             owned.squeeze();
             m_external = true;
@@ -294,34 +706,80 @@ private:
             m_size = n;
             m_capacity = n;
             m_takeOwnership = takeOwn;
+            m_pooled = false;
             owner = std::move(keepAlive);
         }
 
+        /**
+         * @brief Byte size of \p cap elements, checked against the QByteArray size limit.
+         * @throws std::length_error if the storage cannot be represented.
+         */
+        static qsizetype byteCount(size_type cap) {
+            constexpr qsizetype maxBytes = std::numeric_limits<qsizetype>::max() / 2;
+            if (cap < 0 || cap > maxBytes / qsizetype(sizeof(T)))
+                throw std::length_error("QPySharedArray: requested size exceeds the addressable storage");
+            return cap * qsizetype(sizeof(T));
+        }
+
+        /**
+         * @brief Take a QPyBufferPool block for \p cap elements and copy m_size elements of \p src.
+         * @return False if the pool is disabled or the request is too large for it.
+         */
+        bool adoptPooledStorage(size_type cap, const T* src) {
+            void* p = nullptr;
+            qint64 capBytes = 0;
+            auto block = detail::acquirePooledBuffer(byteCount(cap), &p, &capBytes);
+            if (!block)
+                return false;
+            if (src && m_size > 0)
+                std::memcpy(p, src, size_t(m_size) * sizeof(T));
+            owned = QByteArray();
+            m_external = true;
+            m_pooled = true;
+            m_takeOwnership = false;
+            extPtr = static_cast<T*>(p);
+            owner = std::move(block);
+            m_capacity = size_type(capBytes / qint64(sizeof(T)));
+            return true;
+        }
+
         /**
          * @brief Ensure owned storage for at least \p cap elements.
          *
          * If currently external, this will allocate a QByteArray, copy existing data
-         * and drop the external view and its owner.
+         * and drop the external view and its owner. While QPyBufferPool is enabled the
+         * storage is a pool block instead of a QByteArray.
          *
          * @param cap Desired capacity in elements.
+         * @param src Elements to preserve; defaults to the current storage.
          */
-        void ensureOwnedStorage(size_type cap) {
-            if (!m_external) {
-                if (owned.size() < cap * (int)sizeof(T))
-                    owned.resize(int(cap * sizeof(T)));
+        void ensureOwnedStorage(size_type cap, const T* src = nullptr) {
+            const qsizetype bytes = byteCount(cap);
+            // leaving storage that other copies still alias: stop sharing their stamps
+            if (aliasesExternal() && m_changes)
+                m_changes = std::make_shared<detail::ChangeTracker>(*m_changes);
+            const T* current = static_cast<const Data*>(this)->ptr();
+            if (!src)
+                src = current;
+            if (QPyBufferPool::isEnabled() && adoptPooledStorage(cap, src))
+                return;
+            if (!m_external && src == current) {
+                if (owned.size() < bytes)
+                    owned.resize(bytes);
                 m_capacity = cap;
                 return;
             }
 
             // external -> allocate owned and copy
             QByteArray b;
-            b.resize(int(cap * sizeof(T)));
-            if (extPtr && m_size > 0)
-                std::memcpy(b.data(), extPtr, size_t(m_size) * sizeof(T));
+            b.resize(bytes);
+            if (src && m_size > 0)
+                std::memcpy(b.data(), src, size_t(m_size) * sizeof(T));
             owned = std::move(b);
 
             // drop external view; owner may still exist but no longer needed
             m_external = false;
+            m_pooled = false;
             extPtr = nullptr;
             m_takeOwnership = false;
             owner.reset();
@@ -340,22 +798,46 @@ private:
         /**
          * @brief Resize logical element count to \p n.
          *
-         * When increasing beyond capacity, capacity grows (at least doubled).
+         * When increasing beyond capacity, capacity grows (at least doubled, unless doubling
+         * would exceed the addressable storage).
          * If storage is owned, the underlying QByteArray is resized appropriately.
          *
          * @param n New size in elements.
          */
         void resize(size_type n) {
-            if (n > m_capacity) reserve(std::max(n, m_capacity * 2));
+            if (n > m_capacity) {
+                const size_type doubled = m_capacity <= std::numeric_limits<size_type>::max() / 4 / qsizetype(sizeof(T))
+                                              ? m_capacity * 2 : n;
+                reserve(std::max(n, doubled));
+            }
             m_size = n;
             if (!m_external) {
                 // keep QByteArray m_size consistent (so data() is valid)
-                owned.resize(int(m_capacity * sizeof(T)));
+                const qsizetype bytes = byteCount(m_capacity);
+                if (owned.size() != bytes)
+                    owned.resize(bytes);
             }
         }
     };
 
-    QSharedPointer<Data> d_; ///< shared data pointer
+    QExplicitlySharedDataPointer<Data> d_; ///< shared data pointer
 };
 
+/**
+ * @brief Select how QPySharedArray<T> values are passed to Python from now on.
+ *
+ * In QPyArrayExportMode::NumPy mode Python receives ndarrays that share the C++ storage, which
+ * saves a \c numpy.frombuffer call per crossing. NumPy is imported on the first such conversion.
+ */
+template <typename T>
+void setSharedArrayExportMode(QPyArrayExportMode mode) {
+    detail::arrayExportMode<T>.store(mode, std::memory_order_relaxed);
+}
+
+/// Current export mode of QPySharedArray<T>.
+template <typename T>
+QPyArrayExportMode sharedArrayExportMode() {
+    return detail::arrayExportMode<T>.load(std::memory_order_relaxed);
+}
+
 } // namespace qtpyt
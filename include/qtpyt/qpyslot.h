@@ -24,7 +24,8 @@ namespace qtpyt {
         static QMetaObject::Connection connectPythonFunctionAsync(QObject *sender, const char *signal,
                                                                   QPyModule module,
                                                                   const QSharedPointer<IQPyFutureNotifier> &notifier,
-                                                                  const QString &slot, const QPyRegisteredType &returnType = QMetaType::Void);
+                                                                  const QString &slot, const QPyRegisteredType &returnType = QMetaType::Void,
+                                                                  const QPyCallOptions &options = {});
         static QMetaObject::Connection connectPythonFunctionAsync(QObject *sender, const char *signal,
                                                                   QPyModule module, QSharedPointer<IQPyFutureNotifier> notifier,
                                                                   const char *slot,
@@ -100,7 +101,7 @@ namespace qtpyt {
             QObjectPrivate::connect(sender, signalIndex, slotObject, type);
         }
         QPySlot(QPyModule module, QSharedPointer<IQPyFutureNotifier> notifier, const QString& slotName,
-            const QPyRegisteredType& returnType);
+            const QPyRegisteredType& returnType, const QPyCallOptions& options = {});
 
         QMetaObject::Connection connectAsyncToSignal(QObject *sender, const char *signal, Qt::ConnectionType type = Qt::AutoConnection) const;
         QMetaObject::Connection connectToSignal(QObject* sender, const char* signal, Qt::ConnectionType type = Qt::AutoConnection) const;
@@ -219,5 +220,6 @@ namespace qtpyt {
         QSharedPointer<IQPyFutureNotifier> m_notifier;
         QString m_slotName;
         QPyRegisteredType m_returnType;
+        QPyCallOptions m_options;
     };
 } // namespace qtpyt
\ No newline at end of file
@@ -0,0 +1,165 @@
+/**
+ * @file qpysnapshot.h
+ * @brief Publishing immutable versions of a QPySharedArray to concurrent readers.
+ *
+ * One writer thread fills a back buffer and publishes it; any number of readers (C++ threads,
+ * Python tasks receiving the array as an argument) acquire the latest published version
+ * without locks. A published buffer is never written again: once it is replaced, it is
+ * retired and released together with the last reader copy or Python export that uses it.
+ *
+ * @code
+ * qtpyt::QPySnapshotPublisher<float> frames(width * height);
+ * // render thread
+ * auto& back = frames.beginWrite();
+ * render(back.data());
+ * frames.publish();
+ * // any thread
+ * QPySharedArray<float> frame = frames.acquire();   // read-only, consistent
+ * module.callAsync("analyze", frame);
+ * @endcode
+ */
+
+#pragma once
+
+#include "qpysharedarray.h"
+
+#include <QtCore/QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+namespace qtpyt {
+
+/**
+ * @class QPySnapshotPublisher
+ * @brief Lock-free publish/acquire of QPySharedArray versions (multi-buffering with slot pins).
+ *
+ * The publisher rotates through a few slots. acquire() pins the current slot for the time it
+ * takes to copy the array handle (an atomic reference increment), so readers never wait for
+ * the writer and the writer never waits for readers that hold on to a version: beginWrite()
+ * reuses a slot only if nobody else references its storage and otherwise gives the slot a
+ * fresh buffer, leaving the old one to its readers.
+ *
+ * beginWrite() and publish() must be called from one thread at a time.
+ *
+ * @tparam T Element type.
+ */
+template <typename T>
+class QPySnapshotPublisher {
+public:
+    static constexpr int SlotCount = 4;
+
+    /**
+     * @brief Create a publisher whose initial version (0) is a zero-filled array of \p size elements.
+     */
+    explicit QPySnapshotPublisher(qsizetype size = 0) : m_size(size) {
+        Slot& first = m_slots[0];
+        first.array = QPySharedArray<T>(size);
+        if (size > 0)
+            std::memset(static_cast<void*>(first.array.data()), 0, size_t(size) * sizeof(T));
+        first.array.setReadOnly(true);
+    }
+
+    QPySnapshotPublisher(const QPySnapshotPublisher&) = delete;
+    QPySnapshotPublisher& operator=(const QPySnapshotPublisher&) = delete;
+
+    /**
+     * @brief Latest published version as a read-only array. Lock-free; callable from any thread.
+     * @param version If not null, receives the version number of the returned array.
+     */
+    QPySharedArray<T> acquire(quint64* version = nullptr) const {
+        for (;;) {
+            const int i = m_current.load(std::memory_order_seq_cst);
+            const Slot& slot = m_slots[size_t(i)];
+            slot.pins.fetch_add(1, std::memory_order_seq_cst);
+            // The slot may have been retired between the two loads; only copy it while it is current.
+            if (m_current.load(std::memory_order_seq_cst) == i) {
+                QPySharedArray<T> result = slot.array;
+                if (version)
+                    *version = slot.version;
+                slot.pins.fetch_sub(1, std::memory_order_release);
+                return result;
+            }
+            slot.pins.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    /// Version number of the latest published array.
+    quint64 version() const { return m_version.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Back buffer for the next version; readers do not see it until publish().
+     *
+     * The returned array is not shared with anyone and may be resized. Its contents are
+     * unspecified (a recycled older version) unless \p copyCurrent is true, which copies the
+     * latest published version into it for incremental updates.
+     */
+    QPySharedArray<T>& beginWrite(bool copyCurrent = false) {
+        const int current = m_current.load(std::memory_order_seq_cst);
+        if (m_writeSlot < 0)
+            m_writeSlot = pickFreeSlot(current);
+        Slot& slot = m_slots[size_t(m_writeSlot)];
+        if (!slot.array.isDetached() || slot.array.size() != m_size) {
+            // still referenced by a reader or an export: retire it and start a new buffer
+            slot.array = QPySharedArray<T>(m_size);
+        } else {
+            slot.array.setReadOnly(false);
+        }
+        if (copyCurrent) {
+            const QPySharedArray<T>& src = m_slots[size_t(current)].array;
+            if (slot.array.size() != src.size())
+                slot.array.resize(src.size());
+            if (src.size() > 0)
+                std::memcpy(static_cast<void*>(slot.array.data()), src.constData(), size_t(src.size()) * sizeof(T));
+        }
+        return slot.array;
+    }
+
+    /**
+     * @brief Make the buffer returned by beginWrite() the current version.
+     * @return The new version number.
+     * @throws std::logic_error if beginWrite() was not called.
+     */
+    quint64 publish() {
+        if (m_writeSlot < 0)
+            throw std::logic_error("QPySnapshotPublisher::publish: beginWrite() was not called");
+        Slot& slot = m_slots[size_t(m_writeSlot)];
+        slot.array.setReadOnly(true);
+        m_size = slot.array.size();
+        slot.version = m_version.load(std::memory_order_relaxed) + 1;
+        m_current.store(m_writeSlot, std::memory_order_seq_cst);
+        m_version.store(slot.version, std::memory_order_release);
+        m_writeSlot = -1;
+        return slot.version;
+    }
+
+private:
+    struct alignas(64) Slot {
+        mutable std::atomic<int> pins{0};
+        QPySharedArray<T> array;
+        quint64 version = 0;
+    };
+
+    // A slot other than the current one that no reader is copying right now. Pins are held
+    // only for the duration of a handle copy, so the loop practically never repeats.
+    int pickFreeSlot(int current) const {
+        for (;;) {
+            for (int j = 1; j < SlotCount; ++j) {
+                const int candidate = (current + j) % SlotCount;
+                if (m_slots[size_t(candidate)].pins.load(std::memory_order_seq_cst) == 0)
+                    return candidate;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    std::array<Slot, SlotCount> m_slots;
+    std::atomic<int> m_current{0};
+    std::atomic<quint64> m_version{0};
+    int m_writeSlot = -1;       ///< slot handed out by beginWrite(), writer thread only
+    qsizetype m_size = 0;       ///< size of new back buffers
+};
+
+} // namespace qtpyt
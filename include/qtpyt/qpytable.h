@@ -0,0 +1,247 @@
+/**
+ * @file qpytable.h
+ * @brief Named columns of QPySharedArray data exchanged through the Arrow C Data Interface.
+ *
+ * A QPyTable is passed to Python as \c qt_interop.Table, which implements the Arrow PyCapsule
+ * protocol (\c __arrow_c_schema__, \c __arrow_c_array__, \c __arrow_c_stream__), so
+ * \c pyarrow.table(t), \c polars.from_arrow(t) or \c pandas (through pyarrow) read the columns
+ * without copying. Python objects implementing the protocol are converted back to QPyTable
+ * the same way. No Arrow library is needed on the C++ side.
+ *
+ * Columns hold fixed-width primitive types (8 to 64-bit integers, qfloat16, float, double)
+ * with an optional validity bitmap (one bit per row, least significant bit first, 1 = valid).
+ */
+
+#pragma once
+
+#include "qpysharedarray.h"
+
+#include <QtCore/QList>
+#include <QtCore/QMetaType>
+#include <QtCore/QString>
+#include <QtCore/QtGlobal>
+#include <QtCore/qfloat16.h>
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+// Arrow C Data Interface and C Stream Interface structures, as defined by the Arrow specification.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+
+#endif // ARROW_C_DATA_INTERFACE
+
+#ifndef ARROW_C_STREAM_INTERFACE
+#define ARROW_C_STREAM_INTERFACE
+
+struct ArrowArrayStream {
+    int (*get_schema)(struct ArrowArrayStream*, struct ArrowSchema* out);
+    int (*get_next)(struct ArrowArrayStream*, struct ArrowArray* out);
+    const char* (*get_last_error)(struct ArrowArrayStream*);
+    void (*release)(struct ArrowArrayStream*);
+    void* private_data;
+};
+
+#endif // ARROW_C_STREAM_INTERFACE
+
+namespace qtpyt {
+
+namespace detail {
+
+/**
+ * @brief Arrow format string of a column element type.
+ */
+template <typename T>
+constexpr const char* arrowFormat() {
+    if constexpr (std::is_same_v<T, qfloat16>) {
+        return "e";
+    } else if constexpr (std::is_same_v<T, float>) {
+        return "f";
+    } else if constexpr (std::is_same_v<T, double>) {
+        return "g";
+    } else if constexpr (std::is_same_v<T, std::byte>) {
+        return "C";
+    } else {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>,
+                      "QPyTable columns hold integer, qfloat16, float or double elements "
+                      "(Arrow booleans are bit-packed; store them as quint8)");
+        constexpr bool s = std::is_signed_v<T>;
+        if constexpr (sizeof(T) == 1) return s ? "c" : "C";
+        else if constexpr (sizeof(T) == 2) return s ? "s" : "S";
+        else if constexpr (sizeof(T) == 4) return s ? "i" : "I";
+        else return s ? "l" : "L";
+    }
+}
+
+} // namespace detail
+
+/**
+ * @struct QPyTableColumn
+ * @brief Type-erased column of a QPyTable.
+ */
+struct QPyTableColumn {
+    QString name;
+    std::string format;                          ///< Arrow format string ("i", "g", ...)
+    qsizetype itemsize = 0;                      ///< element size in bytes
+    const void* data = nullptr;                  ///< first element
+    const quint8* validity = nullptr;            ///< validity bitmap, null if every row is valid
+    qint64 nullCount = 0;                        ///< number of null rows
+    std::shared_ptr<detail::OwnerState> anchor;  ///< keeps data and validity alive
+};
+
+/**
+ * @class QPyTable
+ * @brief Ordered, named columns of equal length that share storage with QPySharedArray.
+ *
+ * Adding a column keeps a reference to the array storage, so later writes to the array in C++
+ * detach from the table (copy-on-write) and the table keeps the data it was given.
+ */
+class QPyTable {
+public:
+    QPyTable() = default;
+
+    /// Number of rows; 0 for a table without columns.
+    qsizetype rowCount() const { return m_rows; }
+    qsizetype columnCount() const { return m_columns.size(); }
+    QStringList columnNames() const;
+
+    /// Index of the column called \p name, or -1.
+    qsizetype indexOf(const QString& name) const;
+
+    /**
+     * @brief Column \p index.
+     * @throws std::out_of_range if the index is invalid.
+     */
+    const QPyTableColumn& columnAt(qsizetype index) const;
+
+    /**
+     * @brief Append column \p name referencing \p data without copying.
+     *
+     * @param validity Optional validity bitmap of at least (rows + 7) / 8 bytes; empty means
+     *        no nulls.
+     * @throws std::invalid_argument if the name is taken, the length differs from the other
+     *         columns or the bitmap is too short.
+     */
+    template <typename T>
+    void addColumn(const QString& name, const QPySharedArray<T>& data,
+                   const QPySharedArray<quint8>& validity = QPySharedArray<quint8>()) {
+        QPyTableColumn c;
+        c.name = name;
+        c.format = detail::arrowFormat<T>();
+        c.itemsize = qsizetype(sizeof(T));
+        c.data = data.constData();
+        if (!validity.isEmpty()) {
+            if (validity.size() < (data.size() + 7) / 8)
+                throw std::invalid_argument("QPyTable::addColumn: validity bitmap is too short");
+            c.validity = validity.constData();
+        }
+        using Holder = std::pair<QPySharedArray<T>, QPySharedArray<quint8>>;
+        c.anchor = detail::make_owner(new Holder(data, validity), [](void* p) { delete static_cast<Holder*>(p); });
+        addColumn(std::move(c), data.size());
+    }
+
+    /**
+     * @brief Append a type-erased column with \p rows rows (null count is computed from the bitmap).
+     */
+    void addColumn(QPyTableColumn column, qsizetype rows);
+
+    /**
+     * @brief Column \p name as a zero-copy QPySharedArray<T>.
+     * @throws std::invalid_argument if there is no such column or its type is not \p T.
+     */
+    template <typename T>
+    QPySharedArray<T> column(const QString& name) const {
+        const QPyTableColumn& c = columnAt(requireIndex(name));
+        if (c.format != detail::arrowFormat<T>())
+            throw std::invalid_argument("QPyTable::column: column '" + name.toStdString() + "' has Arrow type '" +
+                                        c.format + "'");
+        QPySharedArray<T> a = QPySharedArray<T>::wrapWithOwner(static_cast<T*>(const_cast<void*>(c.data)), m_rows,
+                                                               false, c.anchor);
+        a.setReadOnly(true);
+        return a;
+    }
+
+    /// False if row \p row of column \p index is null.
+    bool isValid(qsizetype index, qsizetype row) const {
+        const QPyTableColumn& c = columnAt(index);
+        return !c.validity || (c.validity[row >> 3] >> (row & 7)) & 1;
+    }
+
+    /**
+     * @brief Export as a struct array (format "+s", one child per column).
+     *
+     * \p outArray and \p outSchema are owned by the caller afterwards and must be released with
+     * their release callbacks. The buffers are not copied; the table storage stays alive until
+     * the array is released.
+     */
+    void exportToArrow(ArrowArray* outArray, ArrowSchema* outSchema) const;
+
+    /**
+     * @brief Export as a stream with a single record batch.
+     */
+    void exportToArrowStream(ArrowArrayStream* out) const;
+
+    /**
+     * @brief Take ownership of a struct array (or a single primitive array, which becomes a
+     * one-column table) without copying the buffers.
+     *
+     * \p array is moved from (its release callback is cleared) and released when the last
+     * column referencing it is gone; \p schema is only read and is not released.
+     * @throws std::runtime_error for unsupported types (nested, variable-size, dictionary, ...).
+     */
+    static QPyTable importFromArrow(ArrowArray* array, const ArrowSchema* schema);
+
+    /**
+     * @brief Read every batch of \p stream and release it. A single batch is imported without
+     * copying; several batches are concatenated.
+     * @throws std::runtime_error if the stream reports an error or contains unsupported types.
+     */
+    static QPyTable importFromArrowStream(ArrowArrayStream* stream);
+
+private:
+    qsizetype requireIndex(const QString& name) const {
+        const qsizetype i = indexOf(name);
+        if (i < 0)
+            throw std::invalid_argument("QPyTable: no column named '" + name.toStdString() + "'");
+        return i;
+    }
+
+    QList<QPyTableColumn> m_columns;
+    qsizetype m_rows = 0;
+};
+
+} // namespace qtpyt
+
+Q_DECLARE_METATYPE(qtpyt::QPyTable)
@@ -0,0 +1,204 @@
+/// \file qpytask.h
+/// \brief C\+\+20 coroutine support: `co_await` on `QPyFuture` and the `QPyTask` coroutine type.
+/// \details
+/// Controller code can await Python calls without polling or notifier classes:
+/// \code
+/// qtpyt::QPyTask<int> sum(qtpyt::QPyModule m) {
+///     const QVariant a = co_await m.callAsync(nullptr, "fetch", QMetaType::Int, 1);
+///     const QVariant b = co_await m.callAsync(nullptr, "fetch", QMetaType::Int, 2);
+///     co_return a.toInt() + b.toInt();
+/// }
+/// \endcode
+/// A coroutine suspended on a call resumes on the thread that awaited it, through that thread's
+/// Qt event loop. A thread without an event dispatcher (a plain std::thread, or a program without
+/// QCoreApplication) is resumed directly on the pool worker that completes the call.
+
+#pragma once
+
+#include "qpyfuture.h"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace qtpyt {
+
+    /// \class QPyFutureAwaiter
+    /// \brief Awaiter of a `QPyFuture`, returned by `operator co_await`.
+    /// \details The value of the `co_await` expression is the call's first result (an invalid
+    /// `QVariant` for void calls). A call that ends as Error or TimedOut throws
+    /// `std::runtime_error` with its error message; a canceled call throws `std::runtime_error` too.
+    class QPyFutureAwaiter {
+    public:
+        explicit QPyFutureAwaiter(QPyFuture future) : m_future(std::move(future)) {}
+
+        [[nodiscard]] bool await_ready() const { return m_future.isCompleted(); }
+        /// Registers the resumption unless the call has completed meanwhile; returns false then,
+        /// so the coroutine goes on without ever being resumed from inside this call.
+        bool await_suspend(std::coroutine_handle<> handle) const;
+        QVariant await_resume() const;
+
+    private:
+        QPyFuture m_future;
+    };
+
+    /// \brief Makes `QPyFuture` awaitable.
+    inline QPyFutureAwaiter operator co_await(QPyFuture future) {
+        return QPyFutureAwaiter(std::move(future));
+    }
+
+    /// \brief Makes the result of `QPyModule::callAsync()` awaitable.
+    /// \throws std::runtime_error if the call could not be scheduled.
+    QPyFutureAwaiter operator co_await(std::optional<QPyFuture> future);
+
+    template <typename T = void>
+    class QPyTask;
+
+    namespace detail {
+        template <typename T>
+        using QPyTaskValue = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+        /// Log an exception that left a task nobody asked for the result of.
+        void warnUnobservedTaskError(const std::exception_ptr& error);
+
+        template <typename T>
+        struct QPyTaskState {
+            std::mutex mutex;
+            bool done = false;
+            std::optional<QPyTaskValue<T>> value;
+            std::exception_ptr error;
+            std::atomic<bool> errorObserved{false};   ///< result() has rethrown the error
+            std::coroutine_handle<> continuation;   ///< coroutine awaiting the task, if any
+
+            QPyTaskState() = default;
+            QPyTaskState(const QPyTaskState&) = delete;
+            QPyTaskState& operator=(const QPyTaskState&) = delete;
+            ~QPyTaskState() {
+                // fire-and-forget tasks have no other place to report a failure
+                if (error && !errorObserved.load(std::memory_order_relaxed))
+                    warnUnobservedTaskError(error);
+            }
+        };
+
+        template <typename T>
+        struct QPyTaskPromiseBase {
+            std::shared_ptr<QPyTaskState<T>> state = std::make_shared<QPyTaskState<T>>();
+
+            // Eager: the coroutine runs up to its first suspension when it is called.
+            std::suspend_never initial_suspend() noexcept { return {}; }
+
+            // The frame is destroyed right away; the result lives on in the shared state.
+            std::suspend_never final_suspend() noexcept {
+                std::coroutine_handle<> next;
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    state->done = true;
+                    next = std::exchange(state->continuation, {});
+                }
+                if (next)
+                    next.resume();
+                return {};
+            }
+
+            void unhandled_exception() noexcept { state->error = std::current_exception(); }
+        };
+
+        template <typename T>
+        struct QPyTaskPromise : QPyTaskPromiseBase<T> {
+            QPyTask<T> get_return_object();
+
+            template <typename U>
+            void return_value(U&& value) {
+                this->state->value.emplace(std::forward<U>(value));
+            }
+        };
+
+        template <>
+        struct QPyTaskPromise<void> : QPyTaskPromiseBase<void> {
+            QPyTask<void> get_return_object();
+
+            void return_void() { state->value.emplace(); }
+        };
+    } // namespace detail
+
+    /// \class QPyTask
+    /// \brief Coroutine type for C\+\+ code that awaits Python calls.
+    /// \details
+    /// The coroutine starts running when it is called and keeps running after the `QPyTask` is
+    /// dropped, so it can be used fire-and-forget from slots. Another coroutine can `co_await`
+    /// the task to get its value (at most one awaiter); exceptions thrown by the coroutine are
+    /// rethrown there or by `result()`, and logged with qWarning() if neither ever happens.
+    /// \tparam T Value returned with `co_return`, or `void`.
+    template <typename T>
+    class QPyTask {
+    public:
+        using promise_type = detail::QPyTaskPromise<T>;
+
+        /// \brief True once the coroutine has returned or thrown.
+        [[nodiscard]] bool isDone() const {
+            std::lock_guard<std::mutex> lock(m_state->mutex);
+            return m_state->done;
+        }
+
+        /// \brief Value of the finished coroutine; rethrows its exception.
+        /// \throws std::logic_error if the coroutine has not finished yet.
+        T result() const {
+            if (!isDone())
+                throw std::logic_error("QPyTask::result: the coroutine has not finished");
+            if (m_state->error) {
+                m_state->errorObserved.store(true, std::memory_order_relaxed);
+                std::rethrow_exception(m_state->error);
+            }
+            if constexpr (!std::is_void_v<T>)
+                return *m_state->value;
+        }
+
+        auto operator co_await() const {
+            struct Awaiter {
+                std::shared_ptr<detail::QPyTaskState<T>> state;
+
+                bool await_ready() const {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    return state->done;
+                }
+
+                bool await_suspend(std::coroutine_handle<> handle) const {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (state->done)
+                        return false;
+                    state->continuation = handle;
+                    return true;
+                }
+
+                T await_resume() const { return QPyTask(state).result(); }
+            };
+            return Awaiter{m_state};
+        }
+
+    private:
+        friend promise_type;
+
+        explicit QPyTask(std::shared_ptr<detail::QPyTaskState<T>> state) : m_state(std::move(state)) {}
+
+        std::shared_ptr<detail::QPyTaskState<T>> m_state;
+    };
+
+    namespace detail {
+        template <typename T>
+        QPyTask<T> QPyTaskPromise<T>::get_return_object() {
+            return QPyTask<T>(this->state);
+        }
+
+        inline QPyTask<void> QPyTaskPromise<void>::get_return_object() {
+            return QPyTask<void>(state);
+        }
+    } // namespace detail
+
+} // namespace qtpyt
@@ -2,19 +2,68 @@
 
 #include "qpymodule.h"
 #include "qpyfuture.h"
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <memory>
+#include <mutex>
 #include <thread>
 #include <vector>
 
-class QPyQueue;
 namespace qtpyt {
 
+    namespace detail {
+        class QPyAffinityHints;
+        template <typename T> class QPyPriorityLanes;
+    }
+
+    /**
+     * @struct QPySchedulerStats
+     * @brief Counters of the pool scheduler since it was created.
+     */
+    struct QPySchedulerStats {
+        quint64 interactive = 0;                     ///< completed Interactive calls
+        quint64 normal = 0;                          ///< completed Normal calls
+        quint64 background = 0;                      ///< completed Background calls
+        quint64 agedPromotions = 0;                  ///< Background calls run early because they aged
+        quint64 deadlineMisses = 0;                  ///< calls that finished after their deadline
+        quint64 timeouts = 0;                        ///< calls interrupted by the watchdog
+        std::chrono::microseconds worstLateness{0};  ///< largest overrun of a missed deadline
+    };
+
+    /**
+     * @class QPyThreadPool
+     * @brief Work-stealing pool that runs QPyFuture tasks on worker threads.
+     *
+     * Every worker owns a lock-free deque for tasks submitted from the worker itself and a
+     * bounded lock-free inbox for tasks submitted from other threads. An idle worker first drains its own queues
+     * and then steals from randomly chosen victims, so a slow task never strands the tasks
+     * queued behind it while other workers are idle. Tasks of a module are sent to the worker
+     * that last ran that module (a bounded, lock-free hint), which keeps its state warm.
+     *
+     * Idle workers spin briefly before parking, and a submission only signals the condition
+     * variable when no worker is spinning and some are parked, so steady streams of tasks are
+     * handed over without any lock or futex call.
+     *
+     * Calls are scheduled according to their QPyCallOptions: Interactive calls and calls with a
+     * deadline are taken earliest-deadline-first before anything else, Background calls only
+     * when nothing else is queued (or once they have aged), and never on all workers at once
+     * unless the pool has a single worker, which then runs them like any other call.
+     *
+     * With event loops enabled (the default), every worker can host an asyncio loop: a call to
+     * an `async def` function is scheduled as a task on the loop of the worker that ran it and
+     * completes its QPyFuture when the task ends, so calls that wait on I/O do not hold a worker.
+     * A worker runs its loop between tasks and, while it has nothing else to do, in slices of
+     * about a millisecond. Without event loops a coroutine is run to completion by asyncio.run().
+     */
     class QPyThreadPool {
     public:
-        static void initialize(size_t threadCount = std::thread::hardware_concurrency(), bool useSubInterpreters = true);
+        static void initialize(size_t threadCount = std::thread::hardware_concurrency(), bool useSubInterpreters = true,
+                               bool eventLoops = true);
         static QPyThreadPool& instance();
         static void saveMainThreadState();
         static void restoreMainThreadState();
@@ -27,15 +76,66 @@ namespace qtpyt {
 
         void submit(QPyFuture future);
 
+        /**
+         * @brief Submit several tasks at once.
+         *
+         * All tasks are enqueued first and the parked workers are then woken with a single
+         * notification round, instead of one per task. \p futures is left empty.
+         */
+        void submitBatch(std::vector<QPyFuture>&& futures);
+
         void shutdown();
 
+        /// Number of worker threads.
+        [[nodiscard]] size_t threadCount() const { return m_workers.size(); }
+
+        /// Completion and deadline counters of the scheduler.
+        [[nodiscard]] QPySchedulerStats schedulerStats() const;
+
     private:
-        explicit QPyThreadPool(size_t threadCount, bool useSubInterpreters);
+        struct Worker;
+
+        explicit QPyThreadPool(size_t threadCount, bool useSubInterpreters, bool eventLoops);
+        void workerLoop(size_t index);
+        QPyFuture* findTask(size_t index, bool& background);
+        void runTask(size_t index, QPyFuture* task, bool background);
+        void recordCompletion(const QPyFuture& task);
+        bool acquireBackgroundSlot();
+        void releaseBackgroundSlot();
+        void enqueue(QPyFuture* task);
+        void notifySubmitted(size_t count);
+        void wakeSleepers(size_t count);
+
         std::vector<std::thread> workers_;
-        std::vector<std::unique_ptr<QPyQueue>> tasks_;
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::unique_ptr<detail::QPyAffinityHints> m_affinity;
+        std::atomic<size_t> m_nextWorker{0};
+
+        // Urgent (EDF) and background lanes, with the cap on concurrently running background calls.
+        std::unique_ptr<detail::QPyPriorityLanes<QPyFuture*>> m_lanes;
+        std::atomic<size_t> m_backgroundRunning{0};
+        size_t m_maxBackground = 1;
+
+        std::array<std::atomic<quint64>, 3> m_completed{};
+        std::atomic<quint64> m_agedPromotions{0};
+        std::atomic<quint64> m_deadlineMisses{0};
+        std::atomic<quint64> m_timeouts{0};
+        std::atomic<qint64> m_worstLatenessUs{0};
         std::atomic<bool> stop_;
         bool m_initialized{false};
         bool m_subInterpretersUsed;
-        std::unordered_map<QPyModule*, int> m_threadCallableMap_;
+
+        // Tasks that found every inbox full.
+        std::mutex m_overflowMutex;
+        std::deque<QPyFuture*> m_overflow;
+        std::atomic<size_t> m_overflowSize{0};
+
+        // Parking of idle workers: a submit bumps the epoch and wakes sleepers unless a spinning
+        // worker will pick the task up.
+        std::mutex m_parkMutex;
+        std::condition_variable m_parkCondition;
+        std::atomic<quint64> m_wakeEpoch{0};
+        std::atomic<int> m_sleepers{0};
+        std::atomic<int> m_spinning{0};
     };
-}// namespace qtpyt
\ No newline at end of file
+}// namespace qtpyt
@@ -1,9 +1,12 @@
 #include "../include/qtpyt/globalinit.h"
+#include "../include/qtpyt/qpymodule.h"
 
 #include "pybind11/embed.h"
 #include <pybind11/complex.h>
 #include "conversions.h"
 #include "internal/sharedarrayinternal.h"
+#include "internal/qpyringbuffermodule.h"
+#include "internal/qpytablemodule.h"
 #include <qlogging.h>
 #include <QDebug>
 #include <QString>
@@ -34,6 +37,7 @@ namespace qtpyt {
                 qInfo() << "Platform:" << QString::fromStdString(platform.cast<std::string>());
             }
                 makeEmbeddedModule();
+                QPyModule::makeQPyAsyncModule();
                 registerSharedArray<int>("QPySharedArray<int>");
                 registerSharedArray<double>("QPySharedArray<double>");
                 registerSharedArray<float>("QPySharedArray<float>");
@@ -47,6 +51,16 @@ namespace qtpyt {
                 registerSharedArray<long long>("QPySharedArray<long long>");
                 registerSharedArray<unsigned long long>("QPySharedArray<unsigned long long>");
                 registerSharedArray<bool>("QPySharedArray<bool>");
+                registerSharedArray<signed char>("QPySharedArray<signed char>");
+                registerSharedArray<std::byte>("QPySharedArray<std::byte>");
+                registerSharedArray<qfloat16>("QPySharedArray<qfloat16>");
+                registerSharedArray<std::complex<float>>("QPySharedArray<std::complex<float>>");
+                registerSharedArray<std::complex<double>>("QPySharedArray<std::complex<double>>");
+                registerRingBuffer<float>("QPyRingBuffer<float>");
+                registerRingBuffer<double>("QPyRingBuffer<double>");
+                registerRingBuffer<qint16>("QPyRingBuffer<qint16>");
+                registerRingBuffer<qint32>("QPyRingBuffer<qint32>");
+                registerTableType();
                 registerContainerType<QList<double>>("QList<double>");
                 registerContainerType<QList<int>>("QList<int>");
                 registerContainerType<QList<QString>>("QList<QString>");
@@ -0,0 +1,126 @@
+#include "q_py_event_loop.h"
+
+#include <pybind11/eval.h>
+
+#include <QDebug>
+
+namespace py = pybind11;
+
+namespace qtpyt::detail {
+
+    namespace {
+        thread_local QPyEventLoop* t_loop = nullptr;
+    }
+
+    QPyEventLoop::~QPyEventLoop() {
+        if (!m_loop && !m_drain) {
+            return;
+        }
+        if (!Py_IsInitialized()) {
+            m_loop.release();
+            m_drain.release();
+            return;
+        }
+        py::gil_scoped_acquire gil;
+        m_loop = py::object();
+        m_drain = py::object();
+    }
+
+    QPyEventLoop* QPyEventLoop::current() {
+        return t_loop;
+    }
+
+    void QPyEventLoop::setCurrent(QPyEventLoop* loop) {
+        t_loop = loop;
+    }
+
+    py::object QPyEventLoop::schedule(const py::object& coroutine, std::function<void(const py::object&)> done,
+                                      const py::object& context) {
+        if (!m_loop) {
+            const auto asyncio = py::module_::import("asyncio");
+            m_loop = asyncio.attr("new_event_loop")();
+            // coroutines calling asyncio.get_event_loop() outside a task see this one too
+            asyncio.attr("set_event_loop")(m_loop);
+        }
+        py::object task;
+        if (context) {
+            py::dict kwargs;
+            kwargs["context"] = context;
+            task = m_loop.attr("create_task")(coroutine, **kwargs);
+        } else {
+            task = m_loop.attr("create_task")(coroutine);
+        }
+        m_pending.fetch_add(1, std::memory_order_release);
+        task.attr("add_done_callback")(py::cpp_function([this, done = std::move(done)](const py::object& finished) {
+            m_pending.fetch_sub(1, std::memory_order_release);
+            done(finished);
+        }));
+        return task;
+    }
+
+    py::object QPyEventLoop::drain(const py::object& asyncGenerator, const py::object& push, double pause) {
+        if (!m_drain) {
+            // compiled in the worker's interpreter, which a function object must not leave
+            py::dict scope;
+            py::exec("import asyncio\n"
+                     "async def drain(agen, push, pause):\n"
+                     "    try:\n"
+                     "        async for item in agen:\n"
+                     "            while True:\n"
+                     "                taken = push(item)\n"
+                     "                if taken:\n"
+                     "                    break\n"
+                     "                await asyncio.sleep(pause)\n"
+                     "            if taken < 0:\n"
+                     "                return\n"
+                     "    finally:\n"
+                     "        await agen.aclose()\n",
+                     scope);
+            m_drain = scope["drain"];
+        }
+        return m_drain(asyncGenerator, push, pause);
+    }
+
+    void QPyEventLoop::runOnce(std::chrono::microseconds maxWait) {
+        py::gil_scoped_acquire gil;
+        if (!m_loop) {
+            return;
+        }
+        try {
+            // stop() before run_forever() runs exactly one iteration without blocking
+            if (maxWait.count() > 0) {
+                m_loop.attr("call_later")(static_cast<double>(maxWait.count()) / 1e6, m_loop.attr("stop"));
+            } else {
+                m_loop.attr("stop")();
+            }
+            m_loop.attr("run_forever")();
+        } catch (const py::error_already_set& e) {
+            qWarning() << "QPyEventLoop: error in the asyncio loop of a pool worker:" << e.what();
+        }
+    }
+
+    void QPyEventLoop::close() {
+        py::gil_scoped_acquire gil;
+        if (!m_loop) {
+            return;
+        }
+        try {
+            const auto asyncio = py::module_::import("asyncio");
+            const py::list tasks(asyncio.attr("all_tasks")(m_loop));
+            if (!tasks.empty()) {
+                for (const auto& task : tasks) {
+                    task.attr("cancel")();
+                }
+                py::dict kwargs;
+                kwargs["return_exceptions"] = true;
+                m_loop.attr("run_until_complete")(asyncio.attr("gather")(*tasks, **kwargs));
+            }
+            m_loop.attr("close")();
+            asyncio.attr("set_event_loop")(py::none());
+        } catch (const py::error_already_set& e) {
+            qWarning() << "QPyEventLoop: error while closing the asyncio loop of a pool worker:" << e.what();
+        }
+        m_loop = py::object();
+    }
+
+} // namespace qtpyt::detail
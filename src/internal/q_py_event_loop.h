@@ -0,0 +1,64 @@
+#pragma once
+
+#include <pybind11/pybind11.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace qtpyt::detail {
+
+    /**
+     * @brief asyncio event loop hosted by a pool worker.
+     *
+     * Coroutines returned by calls that run on the worker are scheduled as tasks on the loop
+     * instead of being run to completion, so one worker multiplexes any number of calls that
+     * are waiting on I/O. The worker runs the loop between its other tasks, and in short slices
+     * while it has nothing else to do. The Python loop is created when the first coroutine
+     * arrives, so workers that never see one pay nothing.
+     *
+     * All functions must be called on the owning worker thread; schedule() with the GIL held,
+     * the others take it themselves.
+     */
+    class QPyEventLoop {
+    public:
+        QPyEventLoop() = default;
+        ~QPyEventLoop();
+        QPyEventLoop(const QPyEventLoop&) = delete;
+        QPyEventLoop& operator=(const QPyEventLoop&) = delete;
+
+        /// The loop of the worker running on this thread, or nullptr.
+        static QPyEventLoop* current();
+        static void setCurrent(QPyEventLoop* loop);
+
+        /// Wrap \p coroutine in a task running in \p context (a contextvars.Context, or a copy of
+        /// the current one if empty); \p done gets the task once it has ended. Returns the task.
+        pybind11::object schedule(const pybind11::object& coroutine, std::function<void(const pybind11::object&)> done,
+                                  const pybind11::object& context = pybind11::object());
+
+        /**
+         * Coroutine that feeds the items of \p asyncGenerator to \p push, for schedule().
+         * push(item) returns 1 once it took the item, 0 while it has no room (the coroutine
+         * retries after \p pause seconds, letting other tasks run) and -1 to stop early. The
+         * generator is closed however the coroutine ends.
+         */
+        pybind11::object drain(const pybind11::object& asyncGenerator, const pybind11::object& push, double pause);
+
+        /// True while some scheduled task has not ended.
+        [[nodiscard]] bool hasPending() const { return m_pending.load(std::memory_order_acquire) > 0; }
+
+        /// Run the callbacks that are ready. With \p maxWait, keep running (and waiting for I/O
+        /// with the GIL released) for that long.
+        void runOnce(std::chrono::microseconds maxWait = std::chrono::microseconds{0});
+
+        /// Cancel the remaining tasks, let them unwind and close the loop.
+        void close();
+
+    private:
+        pybind11::object m_loop;
+        pybind11::object m_drain;   ///< coroutine function behind drain(), compiled on first use
+        std::atomic<std::size_t> m_pending{0};
+    };
+
+} // namespace qtpyt::detail
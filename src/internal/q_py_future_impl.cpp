@@ -1,10 +1,27 @@
 #include "q_py_future_impl.h"
 #include "../conversions.h"
+#include "q_py_watchdog.h"
+#include "qpymoduleimpl.h"
+#include "pycall.h"
+#include "q_py_event_loop.h"
 
 #include <utility>
 
 QPyFutureImpl::~QPyFutureImpl() {
-
+    if (!m_pyResult && !m_pyInput && !m_task) {
+        return;
+    }
+    if (!Py_IsInitialized()) {
+        // the interpreter is gone, the references with it
+        m_pyResult.release();
+        m_pyInput.release();
+        m_task.release();
+        return;
+    }
+    pybind11::gil_scoped_acquire gil;
+    m_pyResult = py::object();
+    m_pyInput = py::object();
+    m_task = py::object();
 }
 
 QPyFutureImpl::QPyFutureImpl(const qtpyt::QPyModule& module, QSharedPointer<qtpyt::IQPyFutureNotifier>&& notifier, QString functionName, QByteArray  returnType, QVariantList&& arguments)
@@ -30,64 +47,499 @@ QPyFutureImpl::QPyFutureImpl(const qtpyt::QPyModule& module, QSharedPointer<qtpy
 }
 
 
+namespace {
+    // How often an async generator paused on a full result buffer checks for room again.
+    constexpr std::chrono::duration<double> StreamPollInterval{0.001};
+
+    // Call running on this thread, for qpyasync.cancelled().
+    thread_local QPyFutureImpl* t_current = nullptr;
+
+    struct CurrentFuture {
+        explicit CurrentFuture(QPyFutureImpl* f) : previous(t_current) { t_current = f; }
+        ~CurrentFuture() { t_current = previous; }
+        QPyFutureImpl* previous;
+    };
+} // namespace
+
 void QPyFutureImpl::run() {
+    pybind11::gil_scoped_acquire gil;
+    m_threadId = PyThread_get_thread_ident();
+    if (auto expected = qtpyt::QPyFutureState::NotStarted;
+        !m_state.compare_exchange_strong(expected, qtpyt::QPyFutureState::Running, std::memory_order_acq_rel)) {
+        m_pyInput = py::object();
+        return;   // canceled while queued
+    }
+    if (m_options.timeout.count() > 0) {
+        m_watchdogToken = qtpyt::QPyWatchdog::instance().arm(
+            std::chrono::steady_clock::now() + m_options.timeout, [weak = weak_from_this()] {
+                pybind11::gil_scoped_acquire gil;
+                // the last reference may be dropped here, so keep it inside the GIL scope
+                if (auto self = weak.lock()) {
+                    self->expire();
+                }
+            });
+    }
+    CurrentFuture current(this);
     try {
-        pybind11::gil_scoped_acquire gil;
-        {
-            m_state =  qtpyt::QPyFutureState::Running;
-            if (m_notifier != nullptr) {
-                m_notifier->notifyStarted();
+        if (m_notifier != nullptr) {
+            m_notifier->notifyStarted();
+        }
+        // a chained stage gets the previous result as is, without a round trip through QVariant
+        py::object raw;
+        try {
+            const auto args = m_pyInput
+                ? py::make_tuple(std::move(m_pyInput))
+                : py::reinterpret_borrow<py::tuple>(pycall_internal__::build_args_tuple_from_variant_list(m_arguments));
+            raw = m_module.getInternal()->callObject(m_functionName, args);
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error(std::string("QPyFutureImpl::run: ") + e.what());
+        }
+        if (PyCoro_CheckExact(raw.ptr())) {
+            if (auto* loop = qtpyt::detail::QPyEventLoop::current()) {
+                awaitOn(*loop, raw);
+                return;
             }
-            // specify the return type explicitly and pass an explicit empty kwargs dict
-            if (m_returnType == "void" || m_returnType == "NoneType") {
-               auto res = m_module.call(m_functionName, QMetaType::Void, m_arguments);
-               if (!res.second.isEmpty()) {
-                     throw std::runtime_error("QPyFutureImpl::run: " + res.second.toStdString());
-               }
-               m_state =  qtpyt::QPyFutureState::Finished;
-               if (m_notifier != nullptr) {
-                   m_notifier->notifyFinished({});
-               }
-               return;
+            // no worker loop: run the coroutine to completion on this thread
+            raw = py::module_::import("asyncio").attr("run")(raw);
+        }
+        deliver(raw);
+    } catch (...) {
+        handleException(std::current_exception());
+    }
+}
+
+void QPyFutureImpl::deliver(const py::object& raw) {
+    if (PyAsyncGen_CheckExact(raw.ptr())) {
+        if (auto* loop = qtpyt::detail::QPyEventLoop::current()) {
+            drainOn(*loop, raw);
+            return;
+        }
+    }
+    if (PyGen_Check(raw.ptr()) || PyAsyncGen_CheckExact(raw.ptr())) {
+        stream(raw);
+        finish(qtpyt::QPyFutureState::Finished);
+        return;
+    }
+    m_pyResult = raw;
+    if (m_returnType == "void" || m_returnType == "NoneType") {
+        finish(qtpyt::QPyFutureState::Finished);
+        return;
+    }
+    auto result = qtpyt::pyObjectToQVariant(raw, QMetaType::fromName(m_returnType).name());
+    if (!result.has_value()) {
+        throw std::runtime_error("QPyFutureImpl::run: cannot convert the result of " +
+                                 m_functionName.toStdString() + " to " + m_returnType.toStdString());
+    }
+    pushResult(result.value());
+    finish(qtpyt::QPyFutureState::Finished, result.value());
+}
+
+void QPyFutureImpl::handleException(std::exception_ptr error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const py::error_already_set& e) {
+        const auto cancelledType = qtpyt::cancelledErrorType();
+        if (cancelledType && e.matches(cancelledType)) {
+            finish(qtpyt::QPyFutureState::Canceled);
+            return;
+        }
+        if (fail(QString::fromStdString(e.what()))) {
+            qWarning() << "Python error in QPyFutureImpl::run:" << e.what();
+        }
+    } catch (const std::exception& e) {
+        if (fail(QString::fromStdString(e.what()))) {
+            qWarning() << e.what();
+        }
+    }
+}
+
+void QPyFutureImpl::awaitOn(qtpyt::detail::QPyEventLoop& loop, const py::object& coroutine) {
+    // The task and whatever it spawns see this call in qpyasync.cancelled(); a weak reference,
+    // since spawned tasks may outlive it.
+    py::object context = py::module_::import("contextvars").attr("copy_context")();
+    if (const auto var = qtpyt::currentCallVar()) {
+        auto* call = new std::weak_ptr<QPyFutureImpl>(weak_from_this());
+        py::capsule handle(call, [](void* p) { delete static_cast<std::weak_ptr<QPyFutureImpl>*>(p); });
+        context.attr("run")(var.attr("set"), handle);
+    }
+    py::object task = loop.schedule(coroutine, [self = shared_from_this()](const py::object& finished) {
+        self->finishAwait(finished);
+    }, context);
+    std::lock_guard lock(m_cancelMutex);
+    m_task = std::move(task);
+    m_awaited = true;
+    if (m_cancelRequested.load(std::memory_order_relaxed)) {
+        // the request came while the coroutine was created: cancel the task instead
+        PyThreadState_SetAsyncExc(m_threadId, nullptr);
+        m_task.attr("cancel")();
+    }
+}
+
+void QPyFutureImpl::drainOn(qtpyt::detail::QPyEventLoop& loop, const py::object& generator) {
+    // the task may outlive the call only as garbage; never extend its life through push
+    const py::cpp_function push([weak = weak_from_this()](const py::handle& item) {
+        const auto self = weak.lock();
+        return self ? self->offerStreamed(item) : -1;
+    });
+    m_drains = true;
+    awaitOn(loop, loop.drain(generator, push, StreamPollInterval.count()));
+}
+
+void QPyFutureImpl::finishAwait(const py::object& task) {
+    {
+        std::lock_guard lock(m_cancelMutex);
+        m_task = py::object();   // drops the cycle task -> callback -> this
+    }
+    CurrentFuture current(this);
+    try {
+        if (task.attr("cancelled")().cast<bool>()) {
+            finish(qtpyt::QPyFutureState::Canceled);
+            return;
+        }
+        const py::object error = task.attr("exception")();
+        if (!error.is_none()) {
+            const auto cancelledType = qtpyt::cancelledErrorType();
+            if (cancelledType && py::isinstance(error, cancelledType)) {
+                finish(qtpyt::QPyFutureState::Canceled);
+                return;
+            }
+            const std::string type = py::str(py::type::handle_of(error).attr("__name__"));
+            const std::string text = py::str(error);
+            if (fail(QString::fromStdString("QPyFutureImpl::run: Python error: " + type + ": " + text))) {
+                qWarning() << "Python error in QPyFutureImpl::run:" << type.c_str() << text.c_str();
             }
+            return;
+        }
+        if (m_drains) {
+            // the values went out as they came
+            finish(qtpyt::QPyFutureState::Finished);
+            return;
+        }
+        deliver(task.attr("result")());
+    } catch (...) {
+        handleException(std::current_exception());
+    }
+}
 
+void QPyFutureImpl::stream(const py::object& generator) {
+    const auto deliver = [&](const py::handle& item) {
+        const QVariant value = streamedValue(item);
+        if (!waitForSpace()) {
+            return false;
+        }
+        pushStreamed(value);
+        return true;
+    };
 
-            auto result = m_module.call(m_functionName, QMetaType::fromName(m_returnType), m_arguments);
-            if (!result.first.has_value()) {
-                throw std::runtime_error("QPyFutureImpl::run: " + result.second.toStdString());
+    if (PyAsyncGen_CheckExact(generator.ptr())) {
+        // not on a pool worker: no loop to share, drive the generator on a private one
+        py::object loop = py::module_::import("asyncio").attr("new_event_loop")();
+        try {
+            for (;;) {
+                py::object item;
+                try {
+                    item = loop.attr("run_until_complete")(generator.attr("__anext__")());
+                } catch (const py::error_already_set& e) {
+                    if (e.matches(PyExc_StopAsyncIteration)) {
+                        break;
+                    }
+                    throw;
+                }
+                if (!deliver(item)) {
+                    std::lock_guard lock(m_cancelMutex);
+                    PyThreadState_SetAsyncExc(m_threadId, nullptr);
+                    break;
+                }
             }
-            pushResult(result.first.value());
-            m_state =  qtpyt::QPyFutureState::Finished;
-            if (m_notifier != nullptr) {
-                m_notifier->notifyFinished(result.first.value());
+            loop.attr("run_until_complete")(generator.attr("aclose")());
+        } catch (...) {
+            loop.attr("close")();
+            throw;
+        }
+        loop.attr("close")();
+        return;
+    }
+
+    for (;;) {
+        auto item = py::reinterpret_steal<py::object>(PyIter_Next(generator.ptr()));
+        if (!item) {
+            if (PyErr_Occurred()) {
+                throw py::error_already_set();
             }
+            return;
         }
+        if (!deliver(item)) {
+            break;
+        }
+    }
+    {
+        // canceled while paused: let the finally blocks run without the injected exception
+        std::lock_guard lock(m_cancelMutex);
+        PyThreadState_SetAsyncExc(m_threadId, nullptr);
+    }
+    generator.attr("close")();
+}
 
-    } catch (const py::error_already_set& e) {
-        m_state =  qtpyt::QPyFutureState::Error;
-        {
-                std::lock_guard lock(m_mutex);
-                m_errorMessage = QString::fromStdString(e.what());
+QVariant QPyFutureImpl::streamedValue(const py::handle& item) const {
+    // the return type names the type of the yielded values; void converts them as they come
+    const bool untyped = m_returnType == "void" || m_returnType == "NoneType";
+    const QByteArray elementType = untyped ? QByteArray() : QByteArray(QMetaType::fromName(m_returnType).name());
+    auto value = item.is_none() ? std::optional<QVariant>(QVariant()) : qtpyt::pyObjectToQVariant(item, elementType);
+    if (!value.has_value()) {
+        throw std::runtime_error("QPyFutureImpl::run: cannot convert a value yielded by " +
+                                 m_functionName.toStdString() + " to " + m_returnType.toStdString());
+    }
+    return value.value();
+}
+
+void QPyFutureImpl::pushStreamed(const QVariant& value) {
+    // a notifier takes the value; buffering it as well would keep a long stream in memory
+    if (m_notifier != nullptr) {
+        m_notifier->notifyResultAvailable(value);
+    } else {
+        pushResult(value);
+    }
+}
+
+int QPyFutureImpl::offerStreamed(const py::handle& item) {
+    if (m_cancelRequested.load(std::memory_order_relaxed)) {
+        return -1;
+    }
+    if (const std::size_t capacity = m_options.streamBuffer; capacity > 0 && m_notifier == nullptr) {
+        std::lock_guard lock(m_mutex);
+        if (static_cast<std::size_t>(m_result.size()) >= capacity) {
+            return 0;
         }
-        if (m_notifier != nullptr) {
-            m_notifier->notifyErrorOccurred(QString::fromStdString(e.what()));
+    }
+    // only this producer adds results, so the room checked above is still there
+    pushStreamed(streamedValue(item));
+    return 1;
+}
+
+bool QPyFutureImpl::waitForSpace() {
+    const std::size_t capacity = m_options.streamBuffer;
+    if (capacity > 0 && m_notifier == nullptr) {
+        // the consumer and cancel() may need the GIL while we wait
+        pybind11::gil_scoped_release release;
+        std::unique_lock lock(m_mutex);
+        m_resultsChanged.wait(lock, [this, capacity] {
+            return static_cast<std::size_t>(m_result.size()) < capacity ||
+                   m_cancelRequested.load(std::memory_order_relaxed);
+        });
+    }
+    return !m_cancelRequested.load(std::memory_order_relaxed);
+}
+
+void QPyFutureImpl::wakeProducer() {
+    {
+        // pairs with the predicate check in waitForSpace(), so the wakeup cannot be lost
+        std::lock_guard lock(m_mutex);
+    }
+    m_resultsChanged.notify_all();
+}
+
+void QPyFutureImpl::finish(qtpyt::QPyFutureState state, const QVariant& value) {
+    {
+        // A cancel request either arrives before this point and wins, or sees the final state
+        // and does nothing; the lock also covers free-threaded builds where the GIL does not.
+        std::lock_guard lock(m_cancelMutex);
+        if (m_cancelRequested.load(std::memory_order_relaxed)) {
+            // drop a CancelledError that was injected but has not fired yet, so it cannot hit
+            // whatever the worker runs next
+            PyThreadState_SetAsyncExc(m_threadId, nullptr);
+            state = m_timedOut ? qtpyt::QPyFutureState::TimedOut : qtpyt::QPyFutureState::Canceled;
+        }
+        if (state == qtpyt::QPyFutureState::TimedOut) {
+            std::lock_guard errorLock(m_mutex);
+            m_errorMessage = QStringLiteral("timed out after %1 ms").arg(m_options.timeout.count() / 1000.0);
+        }
+        m_state.store(state, std::memory_order_release);
+    }
+    qtpyt::QPyWatchdog::instance().disarm(m_watchdogToken);
+    if (m_notifier != nullptr) {
+        if (state == qtpyt::QPyFutureState::TimedOut) {
+            m_notifier->notifyErrorOccurred(errorMessage());
+        } else if (state == qtpyt::QPyFutureState::Canceled) {
+            m_notifier->notifyCanceled();
+        } else {
+            m_notifier->notifyFinished(value);
         }
-        qWarning() << "Python error in QPyFutureImpl::run:" << e.what();
-        // Handle Python exception (log it, store it, etc.)
     }
+    complete();
+}
 
-    catch (const std::exception& e) {
-        m_state =  qtpyt::QPyFutureState::Error;
+bool QPyFutureImpl::fail(const QString& message) {
+    {
+        std::unique_lock lock(m_cancelMutex);
+        if (m_cancelRequested.load(std::memory_order_relaxed)) {
+            // the error is most likely the injected cancellation surfacing through a conversion
+            lock.unlock();
+            finish(qtpyt::QPyFutureState::Canceled);
+            return false;
+        }
         {
-                std::lock_guard lock(m_mutex);
-                m_errorMessage = QString::fromStdString(e.what());
+            std::lock_guard errorLock(m_mutex);
+            m_errorMessage = message;
         }
+        m_state.store(qtpyt::QPyFutureState::Error, std::memory_order_release);
+    }
+    qtpyt::QPyWatchdog::instance().disarm(m_watchdogToken);
+    if (m_notifier != nullptr) {
+        m_notifier->notifyErrorOccurred(message);
+    }
+    complete();
+    return true;
+}
+
+void QPyFutureImpl::complete() {
+    std::vector<std::function<void()>> continuations;
+    {
+        std::lock_guard lock(m_mutex);
+        m_completed.store(true, std::memory_order_release);
+        continuations.swap(m_continuations);
+    }
+    m_completed.notify_all();
+    m_resultsChanged.notify_all();
+    for (auto& fn : continuations) {
+        fn();
+    }
+}
+
+bool QPyFutureImpl::addContinuation(std::function<void()> fn) {
+    std::lock_guard lock(m_mutex);
+    if (m_completed.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    m_continuations.push_back(std::move(fn));
+    return true;
+}
+
+bool QPyFutureImpl::chain(const std::shared_ptr<QPyFutureImpl>& stage) {
+    // the continuation is run by this impl, so a raw pointer to it cannot dangle
+    return addContinuation([this, stage] {
+        stage->runAfter(*this);
+    });
+}
+
+void QPyFutureImpl::runAfter(const QPyFutureImpl& previous) {
+    if (previous.state() != qtpyt::QPyFutureState::Finished) {
+        skipAfter(previous);
+        return;
+    }
+    takeInputFrom(previous);
+    run();
+}
+
+void QPyFutureImpl::takeInputFrom(const QPyFutureImpl& previous) {
+    pybind11::gil_scoped_acquire gil;
+    m_pyInput = previous.m_pyResult ? previous.m_pyResult : py::none();
+}
+
+void QPyFutureImpl::skipAfter(const QPyFutureImpl& previous) {
+    const auto state = previous.state();
+    if (state != qtpyt::QPyFutureState::Error && state != qtpyt::QPyFutureState::TimedOut) {
+        cancel();
+        return;
+    }
+    if (auto expected = qtpyt::QPyFutureState::NotStarted;
+        !m_state.compare_exchange_strong(expected, qtpyt::QPyFutureState::Error, std::memory_order_acq_rel)) {
+        return;
+    }
+    const QString message = QStringLiteral("previous stage failed: ") + previous.errorMessage();
+    {
+        std::lock_guard lock(m_mutex);
+        m_errorMessage = message;
+    }
+    if (m_notifier != nullptr) {
+        m_notifier->notifyErrorOccurred(message);
+    }
+    complete();
+}
+
+void QPyFutureImpl::onComplete(std::function<void()> fn) {
+    if (!addContinuation(fn)) {
+        fn();
+    }
+}
+
+void QPyFutureImpl::wait() const {
+    // futex wait on the flag: wakes as soon as complete() runs
+    while (!m_completed.load(std::memory_order_acquire)) {
+        m_completed.wait(false, std::memory_order_acquire);
+    }
+}
+
+bool QPyFutureImpl::cancel() {
+    if (auto expected = qtpyt::QPyFutureState::NotStarted;
+        m_state.compare_exchange_strong(expected, qtpyt::QPyFutureState::Canceled, std::memory_order_acq_rel)) {
+        // still queued: the worker that pops it drops it without running it
         if (m_notifier != nullptr) {
-            m_notifier->notifyErrorOccurred(QString::fromStdString(e.what()));
+            m_notifier->notifyCanceled();
         }
-        qWarning() << e.what();
-        // Handle exception (log it, store it, etc.)
+        complete();
+        return true;
+    }
+    if (m_state.load(std::memory_order_acquire) != qtpyt::QPyFutureState::Running) {
+        return false;
+    }
+    pybind11::gil_scoped_acquire gil;
+    std::lock_guard lock(m_cancelMutex);
+    // Running cannot end while we hold the lock (see finish()).
+    if (m_state.load(std::memory_order_acquire) != qtpyt::QPyFutureState::Running) {
+        return false;
+    }
+    if (m_cancelRequested.load(std::memory_order_relaxed)) {
+        return true;   // already on its way out, do not inject a second exception
+    }
+    m_cancelRequested.store(true, std::memory_order_relaxed);
+    interrupt();
+    return true;
+}
+
+void QPyFutureImpl::interrupt() {
+    if (m_task) {
+        // awaited on a worker loop: cancel the task there, the worker may be running anything else
+        m_task.attr("get_loop")().attr("call_soon_threadsafe")(m_task.attr("cancel"));
+        return;
+    }
+    if (m_awaited) {
+        // the task has ended and finishAwait() is delivering its result on the worker, which
+        // may already be running other Python code: finish() sees the request, inject nothing
+        wakeProducer();
+        return;
+    }
+    qtpyt::inject_cancelled(m_threadId);
+    wakeProducer();
+}
+
+void QPyFutureImpl::expire() {
+    std::lock_guard lock(m_cancelMutex);
+    if (m_state.load(std::memory_order_acquire) != qtpyt::QPyFutureState::Running ||
+        m_cancelRequested.load(std::memory_order_relaxed)) {
+        return;
     }
+    qWarning() << "QPyFuture:" << m_functionName << "exceeded its timeout of"
+               << m_options.timeout.count() / 1000.0 << "ms, interrupting it";
+    m_timedOut = true;
+    m_cancelRequested.store(true, std::memory_order_relaxed);
+    interrupt();
+}
+
+bool QPyFutureImpl::currentCancelRequested() {
+    if (t_current != nullptr) {
+        return t_current->m_cancelRequested.load(std::memory_order_relaxed);
+    }
+    // inside a task of the worker loop: the call it was awaited for, if any
+    const auto var = qtpyt::currentCallVar();
+    if (!var) {
+        return false;
+    }
+    const py::object handle = var.attr("get")(py::none());
+    if (!py::isinstance<py::capsule>(handle)) {
+        return false;
+    }
+    const auto call = static_cast<std::weak_ptr<QPyFutureImpl>*>(handle.cast<py::capsule>().get_pointer())->lock();
+    return call && call->m_cancelRequested.load(std::memory_order_relaxed);
 }
 
 int QPyFutureImpl::resultCount() const {
@@ -109,8 +561,39 @@ QString QPyFutureImpl::errorMessage() const {
     return m_errorMessage;
 }
 
-void QPyFutureImpl::pushResult(QVariant result) {
-    std::lock_guard<std::mutex> lock(m_mutex);
-    m_result.append(std::move(result));
+std::optional<QVariant> QPyFutureImpl::takeResult() {
+    std::optional<QVariant> value;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_result.isEmpty()) {
+            return std::nullopt;
+        }
+        value = m_result.takeFirst();
+    }
+    m_resultsChanged.notify_all();
+    return value;
+}
+
+std::optional<QVariant> QPyFutureImpl::waitForResult() {
+    std::optional<QVariant> value;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_resultsChanged.wait(lock, [this] {
+            return !m_result.isEmpty() || m_completed.load(std::memory_order_relaxed);
+        });
+        if (m_result.isEmpty()) {
+            return std::nullopt;
+        }
+        value = m_result.takeFirst();
+    }
+    m_resultsChanged.notify_all();
+    return value;
+}
 
+void QPyFutureImpl::pushResult(QVariant result) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_result.append(std::move(result));
+    }
+    m_resultsChanged.notify_all();
 }
@@ -3,22 +3,80 @@
 #define PYBIND11_NO_KEYWORDS
 #include <pybind11/pybind11.h>
 #include <QObject>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <utility>
+#include <vector>
 #include <qtpyt/qpyfuture.h>
 #include <qtpyt/qpymodule.h>
 
-class QPyFutureImpl {
+namespace qtpyt {
+    namespace detail {
+        class QPyEventLoop;
+    }
+    /// Raise the qpyasync.CancelledError asynchronously in the Python thread \p target_tid.
+    bool inject_cancelled(unsigned long target_tid);
+    /// The qpyasync.CancelledError type (empty before QPyModule::makeQPyAsyncModule()).
+    pybind11::handle cancelledErrorType();
+    /// contextvars.ContextVar naming the awaited call a task belongs to (empty before makeQPyAsyncModule()).
+    pybind11::handle currentCallVar();
+}
+
+class QPyFutureImpl : public std::enable_shared_from_this<QPyFutureImpl> {
   public:
     virtual ~QPyFutureImpl();
     QPyFutureImpl(const qtpyt::QPyModule& module, QSharedPointer<qtpyt::IQPyFutureNotifier>&& notifier, QString  functionName, QByteArray  returnType, QVariantList&& arguments);
     QPyFutureImpl(const qtpyt::QPyModule& module, QSharedPointer<qtpyt::IQPyFutureNotifier>&& notifier, QString  functionName, QByteArray  returnType, const QVector<int>& types, void **a);
     void run();
 
+    /// Cancel the call: a queued call never starts, a running one gets CancelledError raised
+    /// in its thread. Returns false if the call had already completed.
+    bool cancel();
+
+    /// Run \p fn once the call has completed (immediately if it has already). Continuations run
+    /// on the thread that completes the call, after the notifier, and must not block.
+    void onComplete(std::function<void()> fn);
+
+    /// Like onComplete(), but returns false and drops \p fn if the call has already completed.
+    bool addContinuation(std::function<void()> fn);
+
+    /// Run \p stage right after this call, on the worker that completes it and with this call's
+    /// Python result as its only argument. Returns false if this call has already completed;
+    /// the caller then has to start \p stage itself (takeInputFrom() or skipAfter()).
+    bool chain(const std::shared_ptr<QPyFutureImpl>& stage);
+
+    /// Use the Python result of the finished call \p previous as the only argument.
+    void takeInputFrom(const QPyFutureImpl& previous);
+
+    /// Complete a stage that will not run because \p previous did not finish: it ends as
+    /// Error if \p previous failed or timed out and as Canceled otherwise.
+    void skipAfter(const QPyFutureImpl& previous);
+
+    /// Block until the call has completed, without polling.
+    void wait() const;
+
+    bool isCompleted() const {
+        return m_completed.load(std::memory_order_acquire);
+    }
+
+    /// Called by the watchdog when the call has run longer than its timeout.
+    void expire();
+
+    /// True if the call running on the current thread has been asked to cancel.
+    static bool currentCancelRequested();
+
     int resultCount() const;
     QVariant resultAsVariant(int index) const;
+    std::optional<QVariant> takeResult();
+    std::optional<QVariant> waitForResult();
 
      qtpyt::QPyFutureState state() const {
-        return m_state;
+        return m_state.load(std::memory_order_acquire);
     }
 
     qtpyt::QPyModule * modulePtr() {
@@ -26,15 +84,83 @@ class QPyFutureImpl {
     }
     QString errorMessage() const;
 
+    /// Deadline given to Interactive calls that do not carry one.
+    static constexpr std::chrono::microseconds InteractiveBudget{5000};
+
+    void setOptions(const qtpyt::QPyCallOptions& options) {
+        m_options = options;
+        if (options.deadline.count() > 0) {
+            m_deadline = m_createdAt + options.deadline;
+        } else if (options.priority == qtpyt::QPyPriority::Interactive) {
+            m_deadline = m_createdAt + InteractiveBudget;
+        } else {
+            m_deadline.reset();
+        }
+    }
+
+    const qtpyt::QPyCallOptions& options() const {
+        return m_options;
+    }
+
+    std::chrono::steady_clock::time_point createdAt() const {
+        return m_createdAt;
+    }
+
+    /// Deadline the scheduler orders the call by and checks on completion, if any.
+    std::optional<std::chrono::steady_clock::time_point> deadline() const {
+        return m_deadline;
+    }
+
   private:
     void pushResult(QVariant result);
+    void finish(qtpyt::QPyFutureState state, const QVariant& value = {});
+    void complete();
+    void runAfter(const QPyFutureImpl& previous);
+    /// Turn the Python result of the call into the future's results and final state.
+    void deliver(const pybind11::object& raw);
+    void handleException(std::exception_ptr error);
+    /// Hand the coroutine returned by the call to the worker's loop; finishAwait() completes it.
+    void awaitOn(qtpyt::detail::QPyEventLoop& loop, const pybind11::object& coroutine);
+    void finishAwait(const pybind11::object& task);
+    /// Stream an async generator from a task on the worker's loop instead of blocking the worker.
+    void drainOn(qtpyt::detail::QPyEventLoop& loop, const pybind11::object& generator);
+    /// Stop the running call after a cancel request, under m_cancelMutex.
+    void interrupt();
+    /// Deliver the values of a generator or async generator one by one.
+    void stream(const pybind11::object& generator);
+    /// Convert a yielded value to the element type named by the return type.
+    QVariant streamedValue(const pybind11::handle& item) const;
+    void pushStreamed(const QVariant& value);
+    /// Non-blocking producer step of drainOn(): 1 taken, 0 buffer full, -1 canceled.
+    int offerStreamed(const pybind11::handle& item);
+    /// Wait, without the GIL, for room in the result buffer. Returns false if canceled.
+    bool waitForSpace();
+    void wakeProducer();
+    /// Returns false if the failure turned out to be a cancellation.
+    bool fail(const QString& message);
     QByteArray m_returnType;
     mutable std::mutex m_mutex;
+    std::mutex m_cancelMutex;   ///< orders cancel() against the final state transition
     qtpyt::QPyModule m_module;
     QString m_functionName;
     QVariantList m_arguments;
     QVariantList m_result;
-     qtpyt::QPyFutureState m_state{ qtpyt::QPyFutureState::NotStarted};
+    pybind11::object m_pyInput;    ///< argument handed over by the previous stage, under the GIL
+    pybind11::object m_pyResult;   ///< raw result for chained stages, released under the GIL
+    std::atomic<qtpyt::QPyFutureState> m_state{qtpyt::QPyFutureState::NotStarted};
+    std::atomic<bool> m_cancelRequested{false};
+    std::atomic<bool> m_completed{false};   ///< final state published and notifier called
+    std::vector<std::function<void()>> m_continuations;   ///< under m_mutex
+    std::condition_variable m_resultsChanged;   ///< with m_mutex: result pushed or taken, completion
+    bool m_timedOut{false};        ///< the cancel request came from the watchdog, under m_cancelMutex
+    bool m_awaited{false};         ///< the call returned a coroutine now running as m_task
+    bool m_drains{false};          ///< m_task streams an async generator into the results
+    pybind11::object m_task;       ///< asyncio task of an awaited call until it ends, under m_cancelMutex
+    quint64 m_watchdogToken{0};
+    unsigned long m_threadId{0};   ///< Python thread running the call, valid while Running
     QSharedPointer<qtpyt::IQPyFutureNotifier> m_notifier{nullptr};
     QString m_errorMessage{};
+    qtpyt::QPyCallOptions m_options{};
+    std::chrono::steady_clock::time_point m_createdAt{std::chrono::steady_clock::now()};
+    std::optional<std::chrono::steady_clock::time_point> m_deadline;
 };
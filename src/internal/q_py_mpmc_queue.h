@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+
+namespace qtpyt::detail {
+
+    /// Hint to the CPU that the caller is spinning.
+    inline void cpuRelax() {
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield" ::: "memory");
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    /**
+     * @brief Bounded lock-free multi-producer multi-consumer queue (D. Vyukov's design).
+     *
+     * Each cell carries a sequence number that tells producers and consumers whose turn it is,
+     * so a push or pop costs one CAS on the shared position plus one release store, with no
+     * locks and no allocation.
+     *
+     * @tparam T Trivially copyable element, typically a pointer.
+     */
+    template <typename T>
+    class QPyMpmcQueue {
+        static_assert(std::is_trivially_copyable_v<T>, "QPyMpmcQueue stores trivially copyable elements");
+
+    public:
+        explicit QPyMpmcQueue(std::size_t capacity = 1024) {
+            std::size_t cap = 2;
+            while (cap < capacity)
+                cap <<= 1;
+            m_mask = cap - 1;
+            m_cells = std::make_unique<Cell[]>(cap);
+            for (std::size_t i = 0; i < cap; ++i)
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        QPyMpmcQueue(const QPyMpmcQueue&) = delete;
+        QPyMpmcQueue& operator=(const QPyMpmcQueue&) = delete;
+
+        std::size_t capacity() const { return m_mask + 1; }
+
+        /// Returns false if the queue is full.
+        bool tryPush(T value) {
+            std::size_t pos = m_enqueue.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;) {
+                cell = &m_cells[pos & m_mask];
+                const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = std::intptr_t(seq) - std::intptr_t(pos);
+                if (diff == 0) {
+                    if (m_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_enqueue.load(std::memory_order_relaxed);
+                }
+            }
+            cell->value = value;
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Returns false if the queue is empty.
+        bool tryPop(T& out) {
+            std::size_t pos = m_dequeue.load(std::memory_order_relaxed);
+            Cell* cell;
+            for (;;) {
+                cell = &m_cells[pos & m_mask];
+                const std::size_t seq = cell->sequence.load(std::memory_order_acquire);
+                const auto diff = std::intptr_t(seq) - std::intptr_t(pos + 1);
+                if (diff == 0) {
+                    if (m_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_dequeue.load(std::memory_order_relaxed);
+                }
+            }
+            out = cell->value;
+            cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// Approximate number of elements.
+        std::size_t size() const {
+            const std::size_t e = m_enqueue.load(std::memory_order_relaxed);
+            const std::size_t d = m_dequeue.load(std::memory_order_relaxed);
+            return e > d ? e - d : 0;
+        }
+
+    private:
+        struct Cell {
+            std::atomic<std::size_t> sequence{0};
+            T value{};
+        };
+
+        std::unique_ptr<Cell[]> m_cells;
+        std::size_t m_mask = 0;
+        alignas(64) std::atomic<std::size_t> m_enqueue{0};
+        alignas(64) std::atomic<std::size_t> m_dequeue{0};
+    };
+
+} // namespace qtpyt::detail
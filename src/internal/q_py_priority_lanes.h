@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <type_traits>
+#include <vector>
+
+namespace qtpyt::detail {
+
+    /**
+     * @brief The two non-default lanes of the pool scheduler.
+     *
+     * The urgent lane is an earliest-deadline-first heap (ties keep submission order); the
+     * background lane is a FIFO whose head is handed out early once it has waited longer than
+     * the aging threshold. Both are guarded by a mutex, but each keeps an atomic element count
+     * so that the common case, both lanes empty, is checked without locking.
+     *
+     * @tparam T Trivially copyable element, typically a pointer.
+     */
+    template <typename T>
+    class QPyPriorityLanes {
+        static_assert(std::is_trivially_copyable_v<T>, "QPyPriorityLanes stores trivially copyable elements");
+
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        explicit QPyPriorityLanes(Clock::duration agingThreshold = std::chrono::milliseconds(100))
+            : m_agingThreshold(agingThreshold) {}
+
+        QPyPriorityLanes(const QPyPriorityLanes&) = delete;
+        QPyPriorityLanes& operator=(const QPyPriorityLanes&) = delete;
+
+        void pushUrgent(T value, Clock::time_point deadline) {
+            std::lock_guard<std::mutex> lock(m_urgentMutex);
+            m_urgent.push({deadline, m_sequence++, value});
+            m_urgentCount.fetch_add(1, std::memory_order_release);
+        }
+
+        /// Takes the element with the earliest deadline.
+        bool popUrgent(T& out) {
+            if (m_urgentCount.load(std::memory_order_acquire) == 0)
+                return false;
+            std::lock_guard<std::mutex> lock(m_urgentMutex);
+            if (m_urgent.empty())
+                return false;
+            out = m_urgent.top().value;
+            m_urgent.pop();
+            m_urgentCount.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        void pushBackground(T value, Clock::time_point now = Clock::now()) {
+            std::lock_guard<std::mutex> lock(m_backgroundMutex);
+            m_background.push_back({now, value});
+            m_backgroundCount.fetch_add(1, std::memory_order_release);
+        }
+
+        /// Takes the oldest element only if it has waited longer than the aging threshold.
+        bool popAgedBackground(T& out, Clock::time_point now = Clock::now()) {
+            if (m_backgroundCount.load(std::memory_order_acquire) == 0)
+                return false;
+            std::lock_guard<std::mutex> lock(m_backgroundMutex);
+            if (m_background.empty() || now - m_background.front().enqueued < m_agingThreshold)
+                return false;
+            return takeBackground(out);
+        }
+
+        /// Takes the oldest element.
+        bool popBackground(T& out) {
+            if (m_backgroundCount.load(std::memory_order_acquire) == 0)
+                return false;
+            std::lock_guard<std::mutex> lock(m_backgroundMutex);
+            return takeBackground(out);
+        }
+
+        std::size_t urgentSize() const { return m_urgentCount.load(std::memory_order_relaxed); }
+        std::size_t backgroundSize() const { return m_backgroundCount.load(std::memory_order_relaxed); }
+        Clock::duration agingThreshold() const { return m_agingThreshold; }
+
+    private:
+        struct Urgent {
+            Clock::time_point deadline;
+            std::uint64_t sequence;
+            T value;
+            bool operator>(const Urgent& o) const {
+                return deadline != o.deadline ? deadline > o.deadline : sequence > o.sequence;
+            }
+        };
+        struct Background {
+            Clock::time_point enqueued;
+            T value;
+        };
+
+        bool takeBackground(T& out) {
+            if (m_background.empty())
+                return false;
+            out = m_background.front().value;
+            m_background.pop_front();
+            m_backgroundCount.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        const Clock::duration m_agingThreshold;
+
+        std::mutex m_urgentMutex;
+        std::priority_queue<Urgent, std::vector<Urgent>, std::greater<Urgent>> m_urgent;
+        std::uint64_t m_sequence = 0;
+        alignas(64) std::atomic<std::size_t> m_urgentCount{0};
+
+        std::mutex m_backgroundMutex;
+        std::deque<Background> m_background;
+        alignas(64) std::atomic<std::size_t> m_backgroundCount{0};
+    };
+
+} // namespace qtpyt::detail
@@ -0,0 +1,124 @@
+#include <pybind11/pybind11.h>
+
+#include "q_py_watchdog.h"
+#include "q_py_future_impl.h"
+
+namespace qtpyt {
+
+    QPyWatchdog& QPyWatchdog::instance() {
+        static QPyWatchdog watchdog;
+        return watchdog;
+    }
+
+    QPyWatchdog::~QPyWatchdog() {
+        stop();
+    }
+
+    QPyWatchdog::Token QPyWatchdog::arm(Clock::time_point expiry, std::function<void()> onExpired) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_stopped)
+            return 0;
+        if (!m_thread.joinable())
+            m_thread = std::thread([this] { loop(); });
+        const Token token = m_nextToken++;
+        const bool earliest = m_entries.empty() || expiry < m_entries.begin()->first.first;
+        m_entries.emplace(std::make_pair(expiry, token), std::move(onExpired));
+        m_expiry.emplace(token, expiry);
+        if (earliest)
+            m_condition.notify_one();
+        return token;
+    }
+
+    void QPyWatchdog::disarm(Token token) {
+        if (token == 0)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const auto it = m_expiry.find(token);
+        if (it == m_expiry.end())
+            return;
+        m_entries.erase({it->second, token});
+        m_expiry.erase(it);
+        // no notify: the thread wakes at the old head's expiry and finds nothing to fire
+    }
+
+    size_t QPyWatchdog::armed() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_entries.size();
+    }
+
+    void QPyWatchdog::stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+            m_entries.clear();
+            m_expiry.clear();
+        }
+        m_condition.notify_all();
+        if (m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id())
+            m_thread.join();
+    }
+
+    void QPyWatchdog::loop() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopped) {
+            if (m_entries.empty()) {
+                m_condition.wait(lock);
+                continue;
+            }
+            const auto head = m_entries.begin();
+            if (Clock::now() < head->first.first) {
+                m_condition.wait_until(lock, head->first.first);
+                continue;
+            }
+            std::function<void()> onExpired = std::move(head->second);
+            m_expiry.erase(head->first.second);
+            m_entries.erase(head);
+            lock.unlock();
+            onExpired();
+            lock.lock();
+        }
+    }
+
+    struct QPyTimeoutScope::State {
+        std::mutex mutex;
+        unsigned long threadId = 0;
+        bool done = false;
+        bool fired = false;
+    };
+
+    QPyTimeoutScope::QPyTimeoutScope(std::chrono::microseconds timeout) {
+        if (timeout.count() <= 0)
+            return;
+        m_state = std::make_shared<State>();
+        m_state->threadId = PyThread_get_thread_ident();
+        m_token = QPyWatchdog::instance().arm(QPyWatchdog::Clock::now() + timeout,
+                                              [state = m_state] {
+            pybind11::gil_scoped_acquire gil;
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (state->done)
+                return;
+            state->fired = true;
+            inject_cancelled(state->threadId);
+        });
+    }
+
+    QPyTimeoutScope::~QPyTimeoutScope() {
+        if (!m_state)
+            return;
+        finish();
+        QPyWatchdog::instance().disarm(m_token);
+    }
+
+    bool QPyTimeoutScope::finish() {
+        if (!m_state)
+            return false;
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        if (m_state->done)
+            return m_state->fired;
+        m_state->done = true;
+        if (m_state->fired)
+            PyThreadState_SetAsyncExc(m_state->threadId, nullptr);
+        return m_state->fired;
+    }
+
+} // namespace qtpyt
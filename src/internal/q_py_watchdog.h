@@ -0,0 +1,85 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace qtpyt {
+
+    /**
+     * @brief Single thread that fires callbacks when their deadline passes.
+     *
+     * Used to enforce call timeouts: a call arms an entry when it starts and disarms it when it
+     * ends, so the watchdog only ever sees the calls that are currently running. Callbacks run
+     * on the watchdog thread without any lock held and must do their own synchronisation with
+     * the call they guard; disarm() never waits for a callback that is already running.
+     */
+    class QPyWatchdog {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using Token = quint64;
+
+        static QPyWatchdog& instance();
+
+        QPyWatchdog() = default;
+        ~QPyWatchdog();
+        QPyWatchdog(const QPyWatchdog&) = delete;
+        QPyWatchdog& operator=(const QPyWatchdog&) = delete;
+
+        /// Run \p onExpired on the watchdog thread at \p expiry unless disarmed before.
+        Token arm(Clock::time_point expiry, std::function<void()> onExpired);
+
+        /// Remove the entry; a no-op if it has fired already.
+        void disarm(Token token);
+
+        /// Number of armed entries.
+        [[nodiscard]] size_t armed() const;
+
+        /// Stop the thread and drop all entries; later arm() calls are ignored.
+        void stop();
+
+    private:
+        void loop();
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::map<std::pair<Clock::time_point, Token>, std::function<void()>> m_entries;
+        std::unordered_map<Token, Clock::time_point> m_expiry;
+        Token m_nextToken = 1;
+        bool m_stopped = false;
+        std::thread m_thread;
+    };
+
+    /**
+     * @brief Timeout for Python code running synchronously on the current thread.
+     *
+     * While the scope is alive and the timeout has not passed, nothing happens. Once it passes,
+     * the watchdog raises qpyasync.CancelledError in this thread. finish() must be called with
+     * the GIL held once the Python code has returned; it clears an exception that was injected
+     * but did not fire, and reports whether the timeout was hit. The destructor calls it too, so
+     * the scope must also be destroyed with the GIL held.
+     */
+    class QPyTimeoutScope {
+    public:
+        explicit QPyTimeoutScope(std::chrono::microseconds timeout);
+        ~QPyTimeoutScope();
+        QPyTimeoutScope(const QPyTimeoutScope&) = delete;
+        QPyTimeoutScope& operator=(const QPyTimeoutScope&) = delete;
+
+        /// True if the timeout fired.
+        bool finish();
+
+    private:
+        struct State;
+        std::shared_ptr<State> m_state;
+        QPyWatchdog::Token m_token = 0;
+    };
+
+} // namespace qtpyt
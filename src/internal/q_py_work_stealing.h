@@ -0,0 +1,162 @@
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace qtpyt::detail {
+
+    /**
+     * @brief Chase-Lev work-stealing deque (Le, Pop, Cohen, Zappa Nardelli, PPoPP 2013).
+     *
+     * The owner thread pushes and pops at the bottom (LIFO); any thread steals from the top
+     * (FIFO). Every operation is lock-free; the storage grows on push and retired arrays are
+     * kept until destruction because a thief may still be reading from them.
+     *
+     * @tparam T Trivially copyable element, typically a pointer.
+     */
+    template <typename T>
+    class QPyWorkStealingDeque {
+        static_assert(std::is_trivially_copyable_v<T>, "QPyWorkStealingDeque stores trivially copyable elements");
+
+    public:
+        explicit QPyWorkStealingDeque(std::int64_t capacity = 256) {
+            std::int64_t cap = 1;
+            while (cap < capacity)
+                cap <<= 1;
+            m_arrays.push_back(std::make_unique<Array>(cap));
+            m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+        }
+
+        QPyWorkStealingDeque(const QPyWorkStealingDeque&) = delete;
+        QPyWorkStealingDeque& operator=(const QPyWorkStealingDeque&) = delete;
+
+        /// Owner only.
+        void push(T value) {
+            const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+            const std::int64_t t = m_top.load(std::memory_order_acquire);
+            Array* a = m_array.load(std::memory_order_relaxed);
+            if (b - t > a->capacity - 1)
+                a = grow(a, b, t);
+            a->put(b, value);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_bottom.store(b + 1, std::memory_order_relaxed);
+        }
+
+        /// Owner only. Returns false if the deque is empty or the last element was stolen.
+        bool pop(T& out) {
+            const std::int64_t b = m_bottom.load(std::memory_order_relaxed) - 1;
+            Array* a = m_array.load(std::memory_order_relaxed);
+            m_bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::int64_t t = m_top.load(std::memory_order_relaxed);
+            if (t > b) {
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return false;
+            }
+            out = a->get(b);
+            if (t == b) {
+                // last element: race against thieves for it
+                const bool won = m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                               std::memory_order_relaxed);
+                m_bottom.store(b + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        /// Any thread. Returns false if the deque is empty or another thread won the element.
+        bool steal(T& out) {
+            std::int64_t t = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const std::int64_t b = m_bottom.load(std::memory_order_acquire);
+            if (t >= b)
+                return false;
+            Array* a = m_array.load(std::memory_order_acquire);
+            const T value = a->get(t);
+            if (!m_top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return false;
+            out = value;
+            return true;
+        }
+
+        /// Approximate number of elements.
+        std::int64_t size() const {
+            const std::int64_t b = m_bottom.load(std::memory_order_relaxed);
+            const std::int64_t t = m_top.load(std::memory_order_relaxed);
+            return b > t ? b - t : 0;
+        }
+
+    private:
+        struct Array {
+            explicit Array(std::int64_t cap) : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[size_t(cap)]) {}
+            T get(std::int64_t i) const { return slots[size_t(i & mask)].load(std::memory_order_relaxed); }
+            void put(std::int64_t i, T v) { slots[size_t(i & mask)].store(v, std::memory_order_relaxed); }
+
+            const std::int64_t capacity;
+            const std::int64_t mask;
+            std::unique_ptr<std::atomic<T>[]> slots;
+        };
+
+        Array* grow(Array* old, std::int64_t b, std::int64_t t) {
+            auto bigger = std::make_unique<Array>(old->capacity * 2);
+            for (std::int64_t i = t; i < b; ++i)
+                bigger->put(i, old->get(i));
+            Array* a = bigger.get();
+            m_arrays.push_back(std::move(bigger));
+            m_array.store(a, std::memory_order_release);
+            return a;
+        }
+
+        alignas(64) std::atomic<std::int64_t> m_top{0};
+        alignas(64) std::atomic<std::int64_t> m_bottom{0};
+        std::atomic<Array*> m_array{nullptr};
+        std::vector<std::unique_ptr<Array>> m_arrays;   ///< current and retired arrays, owner only
+    };
+
+    /**
+     * @brief Bounded, lock-free map from a module identity to the worker that last ran it.
+     *
+     * A fixed table of packed (tag, worker) words indexed by a hash of the key. Collisions
+     * overwrite each other, which only costs a wrong hint: stealing still balances the load.
+     */
+    class QPyAffinityHints {
+    public:
+        static constexpr std::size_t TableSize = 1024;
+        static constexpr int None = -1;
+
+        /// Worker that last ran \p key, or None.
+        int lookup(quintptr key) const {
+            const quint64 h = mix(key);
+            const quint64 v = m_table[h & (TableSize - 1)].load(std::memory_order_relaxed);
+            if (v == 0 || (v >> 16) != (h >> 16))
+                return None;
+            return int(v & 0xffff) - 1;
+        }
+
+        void record(quintptr key, int worker) {
+            const quint64 h = mix(key);
+            const quint64 v = ((h >> 16) << 16) | quint64(worker + 1);
+            auto& slot = m_table[h & (TableSize - 1)];
+            if (slot.load(std::memory_order_relaxed) != v)
+                slot.store(v, std::memory_order_relaxed);
+        }
+
+    private:
+        static quint64 mix(quintptr key) {
+            // splitmix64 finalizer; keeps the tag non-zero for any real key
+            quint64 z = quint64(key) + 0x9e3779b97f4a7c15ull;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return (z ^ (z >> 31)) | (quint64(1) << 63);
+        }
+
+        std::array<std::atomic<quint64>, TableSize> m_table{};
+    };
+
+} // namespace qtpyt::detail
@@ -0,0 +1,245 @@
+#include "qpybufferexporter.h"
+#include "qpydlpack.h"
+
+#include <mutex>
+#include <new>
+
+namespace qtpyt {
+    namespace {
+
+        struct QPyBufferExporterObject {
+            PyObject_HEAD
+            QPyBufferExport* info;
+            py::ssize_t shape[1];
+            py::ssize_t strides[1];
+        };
+
+        int exporter_getbuffer(PyObject* self, Py_buffer* view, int flags) {
+            auto* o = reinterpret_cast<QPyBufferExporterObject*>(self);
+            const QPyBufferExport* e = o->info;
+            if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && e->readonly) {
+                PyErr_SetString(PyExc_BufferError, "QPySharedArray buffer is read-only");
+                return -1;
+            }
+            view->obj = Py_NewRef(self);
+            view->buf = e->buf;
+            view->len = e->length * e->itemsize;
+            view->readonly = e->readonly ? 1 : 0;
+            view->itemsize = e->itemsize;
+            view->format = (flags & PyBUF_FORMAT) == PyBUF_FORMAT ? const_cast<char*>(e->format.c_str()) : nullptr;
+            view->ndim = 1;
+            view->shape = (flags & PyBUF_ND) == PyBUF_ND ? o->shape : nullptr;
+            view->strides = (flags & PyBUF_STRIDES) == PyBUF_STRIDES ? o->strides : nullptr;
+            view->suboffsets = nullptr;
+            view->internal = nullptr;
+            if (e->exports)
+                e->exports->fetch_add(1, std::memory_order_acq_rel);
+            return 0;
+        }
+
+        void exporter_releasebuffer(PyObject* self, Py_buffer*) {
+            const auto* o = reinterpret_cast<QPyBufferExporterObject*>(self);
+            if (o->info->exports)
+                o->info->exports->fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        void exporter_dealloc(PyObject* self) {
+            auto* o = reinterpret_cast<QPyBufferExporterObject*>(self);
+            PyTypeObject* tp = Py_TYPE(self);
+            if (o->info->pinned && o->info->exports)
+                o->info->exports->fetch_sub(1, std::memory_order_acq_rel);
+            // Dropping the anchor may release the last reference to the C++ storage.
+            delete o->info;
+            o->info = nullptr;
+            tp->tp_free(self);
+            Py_DECREF(tp);
+        }
+
+        PyObject* exporter_len(PyObject* self, void*) {
+            return PyLong_FromSsize_t(reinterpret_cast<QPyBufferExporterObject*>(self)->info->length);
+        }
+
+        PyObject* exporter_format(PyObject* self, void*) {
+            return PyUnicode_FromString(reinterpret_cast<QPyBufferExporterObject*>(self)->info->format.c_str());
+        }
+
+        PyObject* exporter_exports(PyObject* self, void*) {
+            const auto* e = reinterpret_cast<QPyBufferExporterObject*>(self)->info;
+            return PyLong_FromLong(e->exports ? e->exports->load(std::memory_order_acquire) : 0);
+        }
+
+        PyGetSetDef exporter_getset[] = {
+            {"length", exporter_len, nullptr, "Number of elements.", nullptr},
+            {"format", exporter_format, nullptr, "PEP 3118 format string.", nullptr},
+            {"exports", exporter_exports, nullptr, "Number of live buffer views.", nullptr},
+            {nullptr, nullptr, nullptr, nullptr, nullptr}
+        };
+
+        PyObject* exporter_dlpack(PyObject* self, PyObject* args, PyObject* kwargs) {
+            static const char* keywords[] = {"stream", "max_version", "dl_device", "copy", nullptr};
+            PyObject* stream = Py_None;
+            PyObject* maxVersion = Py_None;
+            PyObject* dlDevice = Py_None;
+            PyObject* copy = Py_None;
+            if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|$OOOO:__dlpack__", const_cast<char**>(keywords),
+                                             &stream, &maxVersion, &dlDevice, &copy))
+                return nullptr;
+            try {
+                const auto* e = reinterpret_cast<QPyBufferExporterObject*>(self)->info;
+                return exportDLPack(*e, py::reinterpret_borrow<py::object>(stream),
+                                    py::reinterpret_borrow<py::object>(maxVersion),
+                                    py::reinterpret_borrow<py::object>(dlDevice),
+                                    py::reinterpret_borrow<py::object>(copy)).release().ptr();
+            } catch (py::error_already_set& err) {
+                err.restore();
+            } catch (const py::builtin_exception& err) {
+                err.set_error();
+            } catch (const std::exception& err) {
+                PyErr_SetString(PyExc_BufferError, err.what());
+            }
+            return nullptr;
+        }
+
+        PyObject* exporter_dlpack_device(PyObject*, PyObject*) {
+            return Py_BuildValue("(ii)", int(kDLCPU), 0);
+        }
+
+        PyMethodDef exporter_methods[] = {
+            {"__dlpack__", reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(exporter_dlpack)),
+             METH_VARARGS | METH_KEYWORDS, "Export the buffer as a DLPack capsule (zero-copy, CPU)."},
+            {"__dlpack_device__", exporter_dlpack_device, METH_NOARGS, "DLPack device: (kDLCPU, 0)."},
+            {nullptr, nullptr, 0, nullptr}
+        };
+
+        PyType_Slot exporter_slots[] = {
+            {Py_bf_getbuffer, reinterpret_cast<void*>(exporter_getbuffer)},
+            {Py_bf_releasebuffer, reinterpret_cast<void*>(exporter_releasebuffer)},
+            {Py_tp_dealloc, reinterpret_cast<void*>(exporter_dealloc)},
+            {Py_tp_getset, exporter_getset},
+            {Py_tp_methods, exporter_methods},
+            {Py_tp_doc, const_cast<char*>("Buffer exporter that keeps a QPySharedArray storage alive.")},
+            {0, nullptr}
+        };
+
+        PyType_Spec exporter_spec = {
+            "qtpyt.SharedBuffer",
+            sizeof(QPyBufferExporterObject),
+            0,
+            Py_TPFLAGS_DEFAULT,
+            exporter_slots
+        };
+
+        PyTypeObject* exporterType() {
+            static PyTypeObject* type = nullptr;
+            static std::once_flag once;
+            std::call_once(once, [] {
+                type = reinterpret_cast<PyTypeObject*>(PyType_FromSpec(&exporter_spec));
+            });
+            if (!type)
+                throw std::runtime_error("qtpyt: failed to create the SharedBuffer type");
+            return type;
+        }
+
+    } // namespace
+
+    py::object makeBufferExporter(QPyBufferExport&& e) {
+        PyTypeObject* type = exporterType();
+        PyObject* self = type->tp_alloc(type, 0);
+        if (!self)
+            throw py::error_already_set();
+        auto* o = reinterpret_cast<QPyBufferExporterObject*>(self);
+        o->shape[0] = e.length;
+        o->strides[0] = e.itemsize;
+        o->info = new QPyBufferExport(std::move(e));
+        if (o->info->pinned && o->info->exports)
+            o->info->exports->fetch_add(1, std::memory_order_acq_rel);
+        return py::reinterpret_steal<py::object>(self);
+    }
+
+    py::memoryview makeExportedMemoryView(QPyBufferExport&& e) {
+        py::object exporter = makeBufferExporter(std::move(e));
+        PyObject* mv = PyMemoryView_FromObject(exporter.ptr());
+        if (!mv)
+            throw py::error_already_set();
+        return py::reinterpret_steal<py::memoryview>(mv);
+    }
+
+    const QPyBufferExport* bufferExportOf(const py::handle& obj) {
+        if (!obj)
+            return nullptr;
+        py::handle candidate = obj;
+        const void* viewBuf = nullptr;
+        py::ssize_t viewLen = 0;
+        if (PyMemoryView_Check(obj.ptr())) {
+            const Py_buffer* view = PyMemoryView_GET_BUFFER(obj.ptr());
+            candidate = view->obj;
+            if (!candidate)
+                return nullptr;
+            viewBuf = view->buf;
+            viewLen = view->len;
+        } else if (Py_TYPE(obj.ptr()) != exporterType() && PyObject_CheckBuffer(obj.ptr()) &&
+                   py::hasattr(obj, "base")) {
+            // ndarray exported in QPyArrayExportMode::NumPy: the exporter is its base object
+            candidate = obj.attr("base");
+            Py_buffer view;
+            if (PyObject_GetBuffer(obj.ptr(), &view, PyBUF_RECORDS_RO) != 0) {
+                PyErr_Clear();
+                return nullptr;
+            }
+            viewBuf = view.buf;
+            viewLen = view.len;
+            PyBuffer_Release(&view);
+        }
+        if (Py_TYPE(candidate.ptr()) != exporterType())
+            return nullptr;
+        const QPyBufferExport* e = reinterpret_cast<QPyBufferExporterObject*>(candidate.ptr())->info;
+        // A slice shares the exporter of the whole buffer, but element indices of the export
+        // do not apply to it.
+        if (candidate.ptr() != obj.ptr() && (viewBuf != e->buf || viewLen != e->length * e->itemsize))
+            return nullptr;
+        return e;
+    }
+
+    namespace {
+
+        const QPyBufferExport& sharedArrayExport(const py::handle& obj) {
+            const QPyBufferExport* e = bufferExportOf(obj);
+            if (!e)
+                throw py::type_error("expected a whole buffer exported from a QPySharedArray, not a slice of one");
+            return *e;
+        }
+
+    } // namespace
+
+    void addChangeTrackingFunctions(py::module_& m) {
+        m.def("changed_ranges", [](const py::object& buffer, quint64 since) {
+            const QPyBufferExport& e = sharedArrayExport(buffer);
+            py::list ranges;
+            quint64 version = 0;
+            if (!e.changes) {
+                if (e.length > 0)
+                    ranges.append(py::make_tuple(py::ssize_t(0), e.length));
+            } else {
+                for (const auto& [begin, end] : e.changes->ranges(since, qsizetype(e.length), &version))
+                    ranges.append(py::make_tuple(begin, end));
+            }
+            return py::make_tuple(ranges, version);
+        }, py::arg("buffer"), py::arg("since") = 0,
+           "Element ranges changed at or after version since, and the version to pass next time");
+
+        m.def("mark_changed", [](const py::object& buffer, py::ssize_t begin, py::ssize_t count) {
+            const QPyBufferExport& e = sharedArrayExport(buffer);
+            if (begin < 0 || count < 0 || begin + count > e.length)
+                throw py::index_error("mark_changed: range out of bounds");
+            if (e.changes)
+                e.changes->mark(qsizetype(begin), qsizetype(count));
+        }, py::arg("buffer"), py::arg("begin"), py::arg("count") = 1,
+           "Record a write made through the buffer");
+
+        m.def("change_version", [](const py::object& buffer) {
+            const QPyBufferExport& e = sharedArrayExport(buffer);
+            return e.changes ? e.changes->version() : quint64(0);
+        }, py::arg("buffer"), "Current change version; 0 if the array does not track changes");
+    }
+
+} // namespace qtpyt
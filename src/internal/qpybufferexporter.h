@@ -0,0 +1,60 @@
+#pragma once
+#include <pybind11/pybind11.h>
+#include <qtpyt/qpysharedarray.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace py = pybind11;
+
+namespace qtpyt {
+
+    /**
+     * @struct QPyBufferExport
+     * @brief Description of a contiguous 1D buffer handed to Python by the exporter type.
+     *
+     * The anchor keeps the C++ storage alive for as long as the exporter object (and therefore
+     * every memoryview created from it) exists. The optional export counter lives inside the
+     * anchored storage and is incremented/decremented from bf_getbuffer/bf_releasebuffer.
+     */
+    struct QPyBufferExport {
+        void* buf = nullptr;                          ///< first element
+        py::ssize_t itemsize = 0;                     ///< element size in bytes
+        py::ssize_t length = 0;                       ///< element count
+        std::string format;                           ///< PEP 3118 format string
+        bool readonly = false;                        ///< refuse writable requests
+        std::shared_ptr<detail::OwnerState> anchor;   ///< keeps the storage alive
+        std::atomic<int>* exports = nullptr;          ///< live export counter in the anchored storage
+        std::shared_ptr<detail::ChangeTracker> changes; ///< change tracking state of the storage, if enabled
+        bool pinned = false;                          ///< the exporter itself counts as one export (ndarray base)
+    };
+
+    /**
+     * @brief Create a `qtpyt.SharedBuffer` object that exports \p e through the buffer protocol.
+     * @note The GIL must be held.
+     */
+    py::object makeBufferExporter(QPyBufferExport&& e);
+
+    /**
+     * @brief Create a memoryview over a fresh exporter for \p e.
+     * The memoryview holds the exporter, so the storage stays valid while the view exists.
+     * @note The GIL must be held.
+     */
+    py::memoryview makeExportedMemoryView(QPyBufferExport&& e);
+
+    /**
+     * @brief Returns the export description if \p obj is an exporter, or a memoryview or
+     * ndarray covering all of one.
+     * @return Pointer owned by the exporter object, or nullptr (also for slices).
+     */
+    const QPyBufferExport* bufferExportOf(const py::handle& obj);
+
+    /**
+     * @brief Add the change-tracking functions for exported shared arrays to \p m:
+     * \c changed_ranges(buffer, since=0) -> ([(begin, end), ...], version),
+     * \c mark_changed(buffer, begin, count=1) and \c change_version(buffer).
+     */
+    void addChangeTrackingFunctions(py::module_& m);
+
+} // namespace qtpyt
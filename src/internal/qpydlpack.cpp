@@ -0,0 +1,225 @@
+#include "qpydlpack.h"
+#include "../pep3118format.h"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+
+namespace qtpyt {
+    namespace {
+
+        constexpr const char* LegacyName = "dltensor";
+        constexpr const char* LegacyUsedName = "used_dltensor";
+        constexpr const char* VersionedName = "dltensor_versioned";
+        constexpr const char* VersionedUsedName = "used_dltensor_versioned";
+
+        // ---- export ------------------------------------------------------------------------
+
+        DLDataType dtypeOf(const QPyBufferExport& e) {
+            const std::string code = pep3118::canonical_code(e.format, e.itemsize);
+            const auto bits = uint8_t(e.itemsize * 8);
+            if (code.size() == 2 && code.front() == 'Z' && code[1] != 'g')
+                return {uint8_t(kDLComplex), bits, 1};
+            if (code.size() == 1) {
+                switch (code.front()) {
+                    case 'b': case 'h': case 'i': case 'q': return {uint8_t(kDLInt), bits, 1};
+                    case 'B': case 'H': case 'I': case 'Q': return {uint8_t(kDLUInt), bits, 1};
+                    case '?': return {uint8_t(kDLBool), bits, 1};
+                    case 'e': case 'f': case 'd': return {uint8_t(kDLFloat), bits, 1};
+                    default: break;
+                }
+            }
+            throw py::buffer_error("__dlpack__: buffer format '" + e.format + "' has no DLPack data type");
+        }
+
+        template <typename Managed>
+        struct ExportContext {
+            Managed managed{};
+            int64_t shape[1]{};
+            std::shared_ptr<detail::OwnerState> anchor;
+            std::atomic<int>* exports = nullptr;   ///< counted like a buffer view while the tensor lives
+            std::unique_ptr<std::byte[]> copy;
+
+            ~ExportContext() {
+                if (exports)
+                    exports->fetch_sub(1, std::memory_order_acq_rel);
+            }
+        };
+
+        template <typename Managed>
+        void deleteExport(Managed* self) {
+            delete static_cast<ExportContext<Managed>*>(self->manager_ctx);
+        }
+
+        // Capsule destructor: frees the tensor unless a consumer renamed the capsule to "used_...".
+        template <typename Managed>
+        void releaseCapsule(PyObject* capsule, const char* name) {
+            if (!PyCapsule_IsValid(capsule, name))
+                return;
+            auto* managed = static_cast<Managed*>(PyCapsule_GetPointer(capsule, name));
+            if (managed && managed->deleter)
+                managed->deleter(managed);
+        }
+
+        void releaseLegacyCapsule(PyObject* capsule) { releaseCapsule<DLManagedTensor>(capsule, LegacyName); }
+        void releaseVersionedCapsule(PyObject* capsule) {
+            releaseCapsule<DLManagedTensorVersioned>(capsule, VersionedName);
+        }
+
+        template <typename Managed>
+        py::object makeTensorCapsule(const QPyBufferExport& e, bool copy) {
+            auto* ctx = new ExportContext<Managed>;
+            ctx->shape[0] = e.length;
+            DLTensor& t = ctx->managed.dl_tensor;
+            t.dtype = dtypeOf(e);
+            if (copy) {
+                const size_t bytes = size_t(e.length) * size_t(e.itemsize);
+                ctx->copy = std::make_unique<std::byte[]>(bytes);
+                if (bytes)
+                    std::memcpy(ctx->copy.get(), e.buf, bytes);
+                t.data = ctx->copy.get();
+            } else {
+                t.data = e.buf;
+                ctx->anchor = e.anchor;
+                ctx->exports = e.exports;
+                if (ctx->exports)
+                    ctx->exports->fetch_add(1, std::memory_order_acq_rel);
+            }
+            t.device = {kDLCPU, 0};
+            t.ndim = 1;
+            t.shape = ctx->shape;
+            t.strides = nullptr;   // compact row-major
+            t.byte_offset = 0;
+            ctx->managed.manager_ctx = ctx;
+            ctx->managed.deleter = &deleteExport<Managed>;
+
+            const char* name = LegacyName;
+            PyCapsule_Destructor destructor = &releaseLegacyCapsule;
+            if constexpr (std::is_same_v<Managed, DLManagedTensorVersioned>) {
+                ctx->managed.version = {DLPACK_MAJOR_VERSION, DLPACK_MINOR_VERSION};
+                ctx->managed.flags = copy ? DLPACK_FLAG_BITMASK_IS_COPIED
+                                          : (e.readonly ? DLPACK_FLAG_BITMASK_READ_ONLY : 0);
+                name = VersionedName;
+                destructor = &releaseVersionedCapsule;
+            }
+            PyObject* capsule = PyCapsule_New(&ctx->managed, name, destructor);
+            if (!capsule) {
+                delete ctx;
+                throw py::error_already_set();
+            }
+            return py::reinterpret_steal<py::object>(capsule);
+        }
+
+        // ---- import ------------------------------------------------------------------------
+
+        bool isHostMemory(const py::handle& obj) {
+            if (!py::hasattr(obj, "__dlpack_device__"))
+                return true;
+            py::tuple device = obj.attr("__dlpack_device__")();
+            const int type = device[0].cast<int>();
+            return type == kDLCPU || type == kDLCUDAHost || type == kDLROCMHost;
+        }
+
+        bool isCompact(const DLTensor& t) {
+            if (!t.strides)
+                return true;
+            int64_t expected = 1;
+            for (int32_t d = t.ndim - 1; d >= 0; --d) {
+                if (t.shape[d] > 1 && t.strides[d] != expected)
+                    return false;
+                expected *= t.shape[d];
+            }
+            return true;
+        }
+
+        template <typename Managed>
+        std::optional<QPyDLPackImport> takeTensor(PyObject* capsule, const char* name, const char* usedName) {
+            auto* managed = static_cast<Managed*>(PyCapsule_GetPointer(capsule, name));
+            if (!managed)
+                throw py::error_already_set();
+            if constexpr (std::is_same_v<Managed, DLManagedTensorVersioned>) {
+                if (managed->version.major > DLPACK_MAJOR_VERSION)
+                    throw py::buffer_error("DLPack " + std::to_string(managed->version.major) +
+                                           ".x capsules are not supported");
+            }
+            // The tensor belongs to us from here on: the capsule destructor must not free it.
+            if (PyCapsule_SetName(capsule, usedName) != 0)
+                throw py::error_already_set();
+
+            QPyDLPackImport out;
+            out.anchor = detail::make_owner(managed, [](void* p) {
+                auto* m = static_cast<Managed*>(p);
+                // Producers may release Python objects in their deleter; once the interpreter
+                // is gone those are too, so the tensor is left alone.
+                if (m->deleter && Py_IsInitialized()) {
+                    py::gil_scoped_acquire gil;
+                    m->deleter(m);
+                }
+            });
+            const DLTensor& t = managed->dl_tensor;
+            if (!isCompact(t))
+                return std::nullopt;
+            out.count = 1;
+            for (int32_t d = 0; d < t.ndim; ++d)
+                out.count *= t.shape[d];
+            out.data = static_cast<char*>(t.data) + t.byte_offset;
+            out.dtype = t.dtype;
+            if constexpr (std::is_same_v<Managed, DLManagedTensorVersioned>)
+                out.readonly = (managed->flags & DLPACK_FLAG_BITMASK_READ_ONLY) != 0;
+            return out;
+        }
+
+    } // namespace
+
+    py::object exportDLPack(const QPyBufferExport& e, const py::object& stream, const py::object& maxVersion,
+                            const py::object& dlDevice, const py::object& copy) {
+        if (!stream.is_none())
+            throw py::buffer_error("__dlpack__: CPU buffers take stream=None");
+        if (!dlDevice.is_none()) {
+            py::tuple device = py::reinterpret_borrow<py::tuple>(dlDevice);
+            if (device[0].cast<int>() != kDLCPU || device[1].cast<int>() != 0)
+                throw py::buffer_error("__dlpack__: the buffer can only be exported to the CPU device");
+        }
+        const bool doCopy = !copy.is_none() && copy.cast<bool>();
+        const bool versioned = !maxVersion.is_none() &&
+                               py::reinterpret_borrow<py::tuple>(maxVersion)[0].cast<int>() >= 1;
+        if (versioned)
+            return makeTensorCapsule<DLManagedTensorVersioned>(e, doCopy);
+        if (e.readonly && !doCopy)
+            throw py::buffer_error("__dlpack__: read-only buffers require max_version >= (1, 0)");
+        return makeTensorCapsule<DLManagedTensor>(e, doCopy);
+    }
+
+    std::optional<QPyDLPackImport> importDLPack(const py::handle& obj) {
+        if (!py::hasattr(obj, "__dlpack__") || !isHostMemory(obj))
+            return std::nullopt;
+
+        py::object capsule;
+        try {
+            try {
+                capsule = obj.attr("__dlpack__")(py::arg("max_version") = py::make_tuple(DLPACK_MAJOR_VERSION,
+                                                                                          DLPACK_MINOR_VERSION));
+            } catch (py::error_already_set& err) {
+                // Producers implementing DLPack < 1.0 do not know max_version.
+                if (!err.matches(PyExc_TypeError))
+                    throw;
+                capsule = obj.attr("__dlpack__")();
+            }
+        } catch (py::error_already_set& err) {
+            // The producer refuses this export: BufferError for a read-only array without
+            // DLPack 1.0, RuntimeError for a PyTorch tensor that requires grad, and so on. The
+            // caller falls back to the buffer protocol; cancellation and other BaseExceptions
+            // still propagate.
+            if (err.matches(PyExc_Exception))
+                return std::nullopt;
+            throw;
+        }
+
+        if (PyCapsule_IsValid(capsule.ptr(), VersionedName))
+            return takeTensor<DLManagedTensorVersioned>(capsule.ptr(), VersionedName, VersionedUsedName);
+        if (PyCapsule_IsValid(capsule.ptr(), LegacyName))
+            return takeTensor<DLManagedTensor>(capsule.ptr(), LegacyName, LegacyUsedName);
+        throw py::type_error("__dlpack__ did not return a DLPack capsule");
+    }
+
+} // namespace qtpyt
@@ -0,0 +1,148 @@
+#pragma once
+#include <pybind11/pybind11.h>
+#include <qtpyt/qpysharedarray.h>
+#include <qtpyt/qpyrecord.h>
+#include <QtCore/qfloat16.h>
+
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+#include "qpybufferexporter.h"
+
+namespace py = pybind11;
+
+// DLPack structures (https://dmlc.github.io/dlpack), declared here when dlpack.h is not included.
+#ifndef DLPACK_DLPACK_H_
+#define DLPACK_DLPACK_H_
+
+#define DLPACK_MAJOR_VERSION 1
+#define DLPACK_MINOR_VERSION 0
+
+#define DLPACK_FLAG_BITMASK_READ_ONLY (1UL << 0UL)
+#define DLPACK_FLAG_BITMASK_IS_COPIED (1UL << 1UL)
+
+typedef struct {
+    uint32_t major;
+    uint32_t minor;
+} DLPackVersion;
+
+typedef enum : int32_t {
+    kDLCPU = 1,
+    kDLCUDA = 2,
+    kDLCUDAHost = 3,
+    kDLROCMHost = 11,
+} DLDeviceType;
+
+typedef struct {
+    DLDeviceType device_type;
+    int32_t device_id;
+} DLDevice;
+
+typedef enum {
+    kDLInt = 0U,
+    kDLUInt = 1U,
+    kDLFloat = 2U,
+    kDLOpaqueHandle = 3U,
+    kDLBfloat = 4U,
+    kDLComplex = 5U,
+    kDLBool = 6U,
+} DLDataTypeCode;
+
+typedef struct {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+} DLDataType;
+
+typedef struct {
+    void* data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t* shape;
+    int64_t* strides;
+    uint64_t byte_offset;
+} DLTensor;
+
+typedef struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void* manager_ctx;
+    void (*deleter)(struct DLManagedTensor* self);
+} DLManagedTensor;
+
+typedef struct DLManagedTensorVersioned {
+    DLPackVersion version;
+    void* manager_ctx;
+    void (*deleter)(struct DLManagedTensorVersioned* self);
+    uint64_t flags;
+    DLTensor dl_tensor;
+} DLManagedTensorVersioned;
+
+#endif // DLPACK_DLPACK_H_
+
+namespace qtpyt {
+
+    /**
+     * @brief Implementation of \c SharedBuffer.__dlpack__: a "dltensor_versioned" capsule if
+     * \p maxVersion allows DLPack 1.x, otherwise a legacy "dltensor" capsule.
+     *
+     * The capsule references the exported storage without copying unless \p copy is true.
+     * @throws py::buffer_error for non-CPU devices, streams, record formats, or read-only
+     *         buffers requested as legacy capsules.
+     */
+    py::object exportDLPack(const QPyBufferExport& e, const py::object& stream, const py::object& maxVersion,
+                            const py::object& dlDevice, const py::object& copy);
+
+    /**
+     * @struct QPyDLPackImport
+     * @brief C-contiguous CPU tensor imported from a DLPack producer, flattened to 1-D.
+     */
+    struct QPyDLPackImport {
+        void* data = nullptr;
+        qint64 count = 0;                             ///< total number of elements
+        DLDataType dtype{};
+        bool readonly = false;
+        std::shared_ptr<detail::OwnerState> anchor;   ///< calls the producer's deleter
+    };
+
+    /**
+     * @brief Consume \p obj.__dlpack__() if \p obj implements DLPack and lives in CPU memory.
+     * @return std::nullopt if \p obj is not a DLPack producer, is on another device, is not
+     *         C-contiguous or its __dlpack__() raises an Exception.
+     */
+    std::optional<QPyDLPackImport> importDLPack(const py::handle& obj);
+
+    namespace detail {
+
+        template <typename T>
+        struct is_std_complex : std::false_type {};
+        template <typename T>
+        struct is_std_complex<std::complex<T>> : std::true_type {};
+
+        // True if a DLPack tensor of type \p t can be viewed as elements of T.
+        template <typename T>
+        bool dlpack_dtype_matches(const DLDataType& t) {
+            if (t.lanes != 1 || t.bits != sizeof(T) * 8)
+                return false;
+            if constexpr (QPyRecord<T>::isRecord)
+                return false;
+            else if constexpr (std::is_same_v<T, bool>)
+                return t.code == kDLBool;
+            else if constexpr (std::is_same_v<T, qfloat16> || std::is_floating_point_v<T>)
+                return t.code == kDLFloat;
+            else if constexpr (is_std_complex<T>::value)
+                return t.code == kDLComplex;
+            else if constexpr (std::is_same_v<T, std::byte>)
+                return t.code == kDLUInt;
+            else if constexpr (std::is_integral_v<T>)
+                return t.code == (std::is_signed_v<T> ? kDLInt : kDLUInt);
+            else
+                return false;
+        }
+
+    } // namespace detail
+
+} // namespace qtpyt
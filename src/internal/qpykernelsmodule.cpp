@@ -0,0 +1,242 @@
+#include "qpykernelsmodule.h"
+
+#include <qtpyt/qpykernels.h>
+
+#include <QtGlobal>
+
+#include <optional>
+#include <string>
+
+namespace qtpyt {
+    namespace {
+
+        enum class Dtype { U8, I32, I64, F32, F64 };
+
+        bool isNativeOrderPrefix(char c) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+            return c == '@' || c == '=' || c == '<';
+#else
+            return c == '@' || c == '=' || c == '>' || c == '!';
+#endif
+        }
+
+        // Maps a PEP 3118 format to a kernel element type; only native byte order is accepted.
+        // There are no kernels for int8, 16-bit or unsigned 32/64-bit elements ('b', 'h', 'H',
+        // 'I', 'L', 'Q'): those formats are rejected rather than reinterpreted.
+        std::optional<Dtype> dtypeOf(const py::buffer_info& info) {
+            std::string f = info.format;
+            if (!f.empty() && isNativeOrderPrefix(f.front()))
+                f.erase(0, 1);
+            if (f.size() != 1)
+                return std::nullopt;
+            switch (f.front()) {
+            case 'B':
+                return Dtype::U8;
+            case 'h':
+            case 'i':
+            case 'l':
+            case 'q':
+                if (info.itemsize == 4) return Dtype::I32;
+                if (info.itemsize == 8) return Dtype::I64;
+                return std::nullopt;
+            case 'f':
+                return Dtype::F32;
+            case 'd':
+                return Dtype::F64;
+            default:
+                return std::nullopt;
+            }
+        }
+
+        template <typename F>
+        decltype(auto) withType(Dtype t, F&& f) {
+            switch (t) {
+            case Dtype::U8: return f(quint8{});
+            case Dtype::I32: return f(qint32{});
+            case Dtype::I64: return f(qint64{});
+            case Dtype::F32: return f(float{});
+            case Dtype::F64: break;
+            }
+            return f(double{});
+        }
+
+        struct Operand {
+            py::buffer_info info;
+            Dtype dtype;
+            qsizetype length;
+        };
+
+        Operand request(const py::object& obj, bool writable, const char* what) {
+            if (!py::isinstance<py::buffer>(obj))
+                throw py::type_error(std::string(what) + " must support the buffer protocol");
+            py::buffer_info info = py::reinterpret_borrow<py::buffer>(obj).request(writable);
+            const auto dtype = dtypeOf(info);
+            if (!dtype)
+                throw py::type_error(std::string(what) + ": unsupported element format '" + info.format + "'");
+            // C-contiguous buffers of any rank are processed as a flat sequence.
+            py::ssize_t expected = info.itemsize;
+            for (py::ssize_t d = info.ndim - 1; d >= 0; --d) {
+                if (info.shape[size_t(d)] > 1 && info.strides[size_t(d)] != expected)
+                    throw py::value_error(std::string(what) + " must be C-contiguous");
+                expected *= info.shape[size_t(d)];
+            }
+            const qsizetype length = qsizetype(info.size);
+            return {std::move(info), *dtype, length};
+        }
+
+        void requireSameShape(const Operand& a, const Operand& b) {
+            if (a.length != b.length)
+                throw py::value_error("operands have different lengths");
+            if (a.dtype != b.dtype)
+                throw py::type_error("operands have different element types");
+        }
+
+        template <typename T>
+        T scalarAs(const py::handle& h) {
+            if constexpr (std::is_integral_v<T>)
+                return T(h.cast<qint64>());
+            else
+                return T(h.cast<double>());
+        }
+
+        template <typename T>
+        py::object toPython(T v) {
+            if constexpr (std::is_integral_v<T>)
+                return py::int_(qint64(v));
+            else
+                return py::float_(double(v));
+        }
+
+        py::object elementwise(QPyKernelOp op, const py::object& a, const py::object& b, py::object out) {
+            if (out.is_none())
+                out = a;
+            Operand dst = request(out, /*writable*/true, "out");
+            Operand lhs = request(a, false, "a");
+            requireSameShape(dst, lhs);
+            if (py::isinstance<py::buffer>(b)) {
+                Operand rhs = request(b, false, "b");
+                requireSameShape(dst, rhs);
+                withType(dst.dtype, [&](auto tag) {
+                    using T = decltype(tag);
+                    py::gil_scoped_release release;
+                    kernels::binary<T>(op, static_cast<const T*>(lhs.info.ptr), static_cast<const T*>(rhs.info.ptr),
+                                       static_cast<T*>(dst.info.ptr), dst.length);
+                });
+            } else {
+                withType(dst.dtype, [&](auto tag) {
+                    using T = decltype(tag);
+                    const T s = scalarAs<T>(b);
+                    py::gil_scoped_release release;
+                    kernels::binaryScalar<T>(op, static_cast<const T*>(lhs.info.ptr), s,
+                                             static_cast<T*>(dst.info.ptr), dst.length);
+                });
+            }
+            return out;
+        }
+
+        void defineElementwise(py::module_& m, const char* name, QPyKernelOp op, const char* doc) {
+            m.def(name, [op](const py::object& a, const py::object& b, const py::object& out) {
+                return elementwise(op, a, b, out);
+            }, py::arg("a"), py::arg("b"), py::arg("out") = py::none(), doc);
+        }
+
+    } // namespace
+
+    void addKernelsModule(py::module_& parent) {
+        py::module_ m = parent.def_submodule("kernels", "Vectorized in-place kernels over buffer objects");
+
+        defineElementwise(m, "add", QPyKernelOp::Add, "out = a + b; b may be a buffer or a number, out defaults to a");
+        defineElementwise(m, "subtract", QPyKernelOp::Sub, "out = a - b; b may be a buffer or a number, out defaults to a");
+        defineElementwise(m, "multiply", QPyKernelOp::Mul, "out = a * b; b may be a buffer or a number, out defaults to a");
+        defineElementwise(m, "divide", QPyKernelOp::Div, "out = a / b; integer division by zero yields 0");
+        defineElementwise(m, "minimum", QPyKernelOp::Min, "out = min(a, b) elementwise");
+        defineElementwise(m, "maximum", QPyKernelOp::Max, "out = max(a, b) elementwise");
+
+        m.def("sum", [](const py::object& a) {
+            Operand src = request(a, false, "a");
+            return withType(src.dtype, [&](auto tag) {
+                using T = decltype(tag);
+                py::gil_scoped_release release;
+                return kernels::sum<T>(static_cast<const T*>(src.info.ptr), src.length);
+            });
+        }, py::arg("a"), "Sum of all elements as float");
+
+        m.def("minmax", [](const py::object& a) {
+            Operand src = request(a, false, "a");
+            if (src.length == 0)
+                throw py::value_error("minmax of an empty buffer");
+            return withType(src.dtype, [&](auto tag) {
+                using T = decltype(tag);
+                std::pair<T, T> r;
+                {
+                    py::gil_scoped_release release;
+                    r = kernels::minMax<T>(static_cast<const T*>(src.info.ptr), src.length);
+                }
+                return py::make_tuple(toPython(r.first), toPython(r.second));
+            });
+        }, py::arg("a"), "(min, max) of the elements");
+
+        m.def("mean_var", [](const py::object& a) {
+            Operand src = request(a, false, "a");
+            if (src.length == 0)
+                throw py::value_error("mean_var of an empty buffer");
+            const QPyMoments mo = withType(src.dtype, [&](auto tag) {
+                using T = decltype(tag);
+                py::gil_scoped_release release;
+                return kernels::moments<T>(static_cast<const T*>(src.info.ptr), src.length);
+            });
+            return py::make_tuple(mo.mean, mo.variance);
+        }, py::arg("a"), "(mean, population variance) of the elements");
+
+        m.def("cumsum", [](const py::object& a, py::object out) {
+            if (out.is_none())
+                out = a;
+            Operand dst = request(out, true, "out");
+            Operand src = request(a, false, "a");
+            requireSameShape(dst, src);
+            withType(dst.dtype, [&](auto tag) {
+                using T = decltype(tag);
+                py::gil_scoped_release release;
+                kernels::inclusiveScan<T>(static_cast<const T*>(src.info.ptr), static_cast<T*>(dst.info.ptr),
+                                          dst.length);
+            });
+            return out;
+        }, py::arg("a"), py::arg("out") = py::none(), "Inclusive prefix sum; out defaults to a");
+
+        m.def("clip", [](const py::object& a, const py::object& lo, const py::object& hi) {
+            Operand dst = request(a, true, "a");
+            withType(dst.dtype, [&](auto tag) {
+                using T = decltype(tag);
+                const T l = scalarAs<T>(lo);
+                const T h = scalarAs<T>(hi);
+                py::gil_scoped_release release;
+                kernels::clamp<T>(static_cast<T*>(dst.info.ptr), dst.length, l, h);
+            });
+            return a;
+        }, py::arg("a"), py::arg("lo"), py::arg("hi"), "Clamp the elements of a to [lo, hi] in place");
+
+        m.def("cast", [](const py::object& src, const py::object& dst, double scale, double offset) {
+            Operand from = request(src, false, "src");
+            Operand to = request(dst, true, "dst");
+            if (from.length != to.length)
+                throw py::value_error("operands have different lengths");
+            withType(from.dtype, [&](auto fromTag) {
+                using From = decltype(fromTag);
+                withType(to.dtype, [&](auto toTag) {
+                    using To = decltype(toTag);
+                    py::gil_scoped_release release;
+                    kernels::convert<From, To>(static_cast<const From*>(from.info.ptr), static_cast<To*>(to.info.ptr),
+                                               to.length, scale, offset);
+                });
+            });
+            return dst;
+        }, py::arg("src"), py::arg("dst"), py::arg("scale") = 1.0, py::arg("offset") = 0.0,
+           "dst = src * scale + offset converted to the element type of dst (saturating for integers)");
+
+        m.def("simd_level", [] { return kernels::simdLevelName(kernels::simdLevel()); },
+              "Instruction set the kernels dispatch to");
+        m.def("set_max_threads", &kernels::setMaxThreads, py::arg("threads"),
+              "Maximum threads per kernel call; 1 disables partitioning");
+    }
+
+} // namespace qtpyt
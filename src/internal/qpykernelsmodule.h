@@ -0,0 +1,18 @@
+#pragma once
+#include <pybind11/pybind11.h>
+
+namespace py = pybind11;
+
+namespace qtpyt {
+
+    /**
+     * @brief Add the \c kernels submodule (bindings of qtpyt/qpykernels.h) to \p parent.
+     *
+     * The functions accept any C-contiguous buffer of uint8, int32, int64, float32 or float64
+     * elements (memoryview, bytearray, array.array, QPySharedArray views) and run with the
+     * interpreter lock released. Other element formats, unsigned 32/64-bit and int8 included,
+     * raise TypeError.
+     */
+    void addKernelsModule(py::module_& parent);
+
+} // namespace qtpyt
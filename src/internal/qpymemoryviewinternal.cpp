@@ -4,16 +4,25 @@
 
 #include "qpymemoryviewinternal.h"
 
-qtpyt::QPyMemoryViewInternal::QPyMemoryViewInternal(char *ptr, char fmt, std::size_t count, bool readOnly): fmt_(fmt),
+#include <cctype>
+#include <cstring>
+
+qtpyt::QPyMemoryViewInternal::QPyMemoryViewInternal(char *ptr, char fmt, std::size_t count, bool readOnly):
+    QPyMemoryViewInternal(ptr, std::string(1, fmt), count, readOnly) {
+}
+
+qtpyt::QPyMemoryViewInternal::QPyMemoryViewInternal(char *ptr, const std::string &fmt, std::size_t count, bool readOnly):
+    format_(fmt),
     itemsize_(itemsize_from_format(fmt)),
     count_(count),
     nbytes_(itemsize_ * count_) {
+    fmt_ = format_.size() > 1 && !std::isalpha(static_cast<unsigned char>(format_.front())) ? format_[1] : format_.front();
     backing_ = py::bytearray(ptr, nbytes_);
     py::buffer_info info = py::buffer(backing_).request();
     view_ = py::memoryview::from_buffer(
         info.ptr,
-        itemsize_from_format(fmt_),
-        std::string(1, fmt_).c_str(),
+        static_cast<py::ssize_t>(itemsize_),
+        format_.c_str(),
         { static_cast<py::ssize_t>(count_) },         // shape
         { static_cast<py::ssize_t>(itemsize_) },
         readOnly
@@ -30,8 +39,11 @@ qtpyt::QPyMemoryViewInternal::QPyMemoryViewInternal(const py::memoryview &mv) {
     if (info.ndim != 1)
         throw std::invalid_argument("Only 1D memoryviews are supported");
 
-    fmt_ = info.format[0]; // assume single char format
-    itemsize_ = static_cast<std::size_t>(info.itemsize);
+    format_ = info.format;
+    itemsize_ = itemsize_from_format(format_);
+    if (itemsize_ != static_cast<std::size_t>(info.itemsize))
+        throw std::invalid_argument("Item size does not match format " + format_);
+    fmt_ = format_.size() > 1 && !std::isalpha(static_cast<unsigned char>(format_.front())) ? format_[1] : format_.front();
     count_ = static_cast<std::size_t>(info.shape[0]);
     nbytes_ = itemsize_ * count_;
 
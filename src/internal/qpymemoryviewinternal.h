@@ -8,12 +8,20 @@
 namespace py = pybind11;
 
 namespace qtpyt {
-    static std::size_t itemsize_from_format(char c) {
+    // Item size of format code \p c: native sizes, or the struct module's standard sizes
+    // when \p native is false (a '=', '<', '>' or '!' prefix).
+    static std::size_t itemsize_from_format(char c, bool native = true) {
         switch (c) {
-            case 'b': return 1; case 'B': return 1;
+            case 'b': return 1; case 'B': return 1; case 'c': return 1;
             case 'h': return 2; case 'H': return 2;
             case 'i': return 4; case 'I': return 4;
+            case 'l': return native ? sizeof(long) : 4; case 'L': return native ? sizeof(unsigned long) : 4;
             case 'q': return 8; case 'Q': return 8;
+            case 'n': case 'N':
+                if (!native)
+                    throw std::invalid_argument(std::string("Format ") + c + " requires native mode");
+                return c == 'n' ? sizeof(std::ptrdiff_t) : sizeof(std::size_t);
+            case 'e': return 2;
             case 'f': return 4;
             case 'd': return 8;
             case '?': return 1;
@@ -21,9 +29,26 @@ namespace qtpyt {
         }
     }
 
+    // Item size of a single-element format with an optional byte-order prefix, including the
+    // complex codes "Zf" and "Zd".
+    static std::size_t itemsize_from_format(const std::string& fmt) {
+        std::string f = fmt;
+        bool native = true;
+        if (!f.empty() && (f.front() == '@' || f.front() == '=' || f.front() == '<' || f.front() == '>' || f.front() == '!')) {
+            native = f.front() == '@';
+            f.erase(0, 1);
+        }
+        if (f.size() == 2 && f.front() == 'Z')
+            return 2 * itemsize_from_format(f[1], native);
+        if (f.size() != 1)
+            throw std::invalid_argument("Unsupported format: " + fmt);
+        return itemsize_from_format(f.front(), native);
+    }
+
     class QPyMemoryViewInternal {
     public:
         QPyMemoryViewInternal(char * ptr, char fmt, std::size_t count, bool readOnly);
+        QPyMemoryViewInternal(char * ptr, const std::string& fmt, std::size_t count, bool readOnly);
         explicit QPyMemoryViewInternal(const py::memoryview& mv);
 
         py::object memoryview() const;
@@ -38,6 +63,9 @@ namespace qtpyt {
 
         char format() const noexcept { return fmt_; }
 
+        // Full format string of the view, e.g. "Zf" for complex64.
+        const std::string& formatString() const noexcept { return format_; }
+
 
         std::uint8_t* data_u8();
 
@@ -52,6 +80,7 @@ namespace qtpyt {
 
     private:
         char fmt_;
+        std::string format_;
         std::size_t itemsize_;
         std::size_t count_;
         std::size_t nbytes_;
@@ -5,6 +5,7 @@
 
 #include "q_py_execute_event.h"
 #include "pycall.h"
+#include "q_py_watchdog.h"
 #include <qfile.h>
 
 namespace qtpyt {
@@ -61,7 +62,16 @@ namespace qtpyt {
 
     std::pair<std::optional<QVariant>, QString> QPyModuleImpl::call(const QString &function,
                                                                     const QPyRegisteredType &returnType,
-                                                                    const QVariantList &args, const QVariantMap &kwargs) {
+                                                                    const QVariantList &args, const QVariantMap &kwargs,
+                                                                    std::chrono::microseconds timeout) {
+        // the timeout scope has to be finished and destroyed with the GIL held
+        std::optional<py::gil_scoped_acquire> gil;
+        if (timeout.count() > 0)
+            gil.emplace();
+        QPyTimeoutScope timeoutScope(timeout);
+        const auto timedOut = [&timeout] {
+            return QStringLiteral("QPyModuleBase::call: timed out after %1 ms").arg(timeout.count() / 1000.0);
+        };
         try {
             QByteArray typeName = {"Unknown Type"};
             if (std::holds_alternative<QMetaType>(returnType)) {
@@ -77,14 +87,25 @@ namespace qtpyt {
                 kwargsDict[py::str(it.key().toStdString())] = qvariantToPyObject(it.value());
             }
             setCallableFunction(function);
-            return {pyObjectToQVariant(pycall_internal__::call_python(callable, argsTuple, kwargsDict),
-                typeName), {}};
+            auto result = pyObjectToQVariant(pycall_internal__::call_python(callable, argsTuple, kwargsDict), typeName);
+            if (timeoutScope.finish()) {
+                return {std::nullopt, timedOut()};
+            }
+            return {std::move(result), {}};
         } catch (const std::exception &e) {
+            if (timeoutScope.finish()) {
+                return {std::nullopt, timedOut()};
+            }
             return {std::nullopt, QString::fromStdString(e.what())};
         }
         return {};
     }
 
+    py::object QPyModuleImpl::callObject(const QString &function, const py::tuple &args) {
+        setCallableFunction(function);
+        return pycall_internal__::call_python(callable, args);
+    }
+
     void QPyModuleImpl::setCallableFunction(const QString &name) {
         m_callableFunction = name;
         if (m_module && !m_module.is_none()) {
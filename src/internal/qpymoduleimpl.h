@@ -2,6 +2,7 @@
 #include <pybind11/pybind11.h>
 #include <qtpyt/qpymodulebase.h>
 #include <QVariant>
+#include <chrono>
 
 namespace qtpyt {
     class QPyModuleImpl {
@@ -17,7 +18,11 @@ namespace qtpyt {
         [[nodiscard]] std::pair<std::optional<QVariant>, QString> call(const QString &function,
                                                                        const QPyRegisteredType &returnType,
                                                                        const QVariantList &args,
-                                                                       const QVariantMap &kwargs = {});
+                                                                       const QVariantMap &kwargs = {},
+                                                                       std::chrono::microseconds timeout = {});
+        /// Call \p function with ready-made Python arguments and return the raw result.
+        /// The caller holds the GIL; Python errors are thrown as std::runtime_error.
+        pybind11::object callObject(const QString &function, const pybind11::tuple &args);
         void setCallableFunction(const QString &name);
         PyCallableInfo inspectCallable() const;
         QString functionName() const;
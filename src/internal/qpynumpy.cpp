@@ -0,0 +1,73 @@
+#include "qpynumpy.h"
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+namespace qtpyt {
+
+    bool numpyAvailable() {
+        // -1 unknown, 0 missing, 1 importable. Atomic rather than GIL-protected: the module is
+        // also loaded into free-threaded interpreters. Two threads may both probe; same answer.
+        static std::atomic<int> state{-1};
+        int known = state.load(std::memory_order_acquire);
+        if (known < 0) {
+            try {
+                py::module_::import("numpy");
+                known = 1;
+            } catch (py::error_already_set&) {
+                known = 0;
+            }
+            state.store(known, std::memory_order_release);
+        }
+        return known == 1;
+    }
+
+    bool isNdarray(const py::handle& obj) {
+        static std::atomic<bool> loaded{false};
+        if (!loaded.load(std::memory_order_acquire)) {
+            if (PyDict_GetItemString(PyImport_GetModuleDict(), "numpy") == nullptr)
+                return false;
+            loaded.store(true, std::memory_order_release);
+        }
+        return py::isinstance<py::array>(obj);
+    }
+
+    py::array makeExportedNdarray(QPyBufferExport&& e, const py::dtype& dtype) {
+        const void* ptr = e.buf;
+        const py::ssize_t length = e.length;
+        const py::ssize_t itemsize = e.itemsize;
+        const bool readonly = e.readonly;
+        e.pinned = true;
+        py::object base = makeBufferExporter(std::move(e));
+        py::array a(dtype, {length}, {itemsize}, ptr, base);
+        if (readonly)
+            py::detail::array_proxy(a.ptr())->flags &= ~py::detail::npy_api::NPY_ARRAY_WRITEABLE_;
+        return a;
+    }
+
+    namespace detail {
+
+        const py::dtype& numpyDtype(const std::string& format, py::ssize_t itemsize) {
+            // Intentionally leaked: dtypes live as long as the interpreter, and destroying them
+            // after Py_Finalize would crash. The GIL does not serialize free-threaded builds, so
+            // the map has its own lock; it is never held across a call into Python, which could
+            // switch threads and deadlock against a waiter that holds the GIL.
+            static auto* cache = new std::unordered_map<std::string, py::dtype>();
+            static std::mutex mutex;
+            {
+                std::lock_guard lock(mutex);
+                if (const auto it = cache->find(format); it != cache->end())
+                    return it->second;
+            }
+            // dtype(buffer_info) parses with numpy's _dtype_from_pep3118 and keeps the item size,
+            // padding included, while dropping the unnamed padding fields.
+            py::dtype created(py::buffer_info(nullptr, itemsize, format, 0));
+            std::lock_guard lock(mutex);
+            // references into an unordered_map stay valid across rehashing
+            return cache->try_emplace(format, std::move(created)).first->second;
+        }
+
+    } // namespace detail
+
+} // namespace qtpyt
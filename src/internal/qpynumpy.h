@@ -0,0 +1,59 @@
+#pragma once
+#ifdef slots
+  #pragma push_macro("slots")
+  #undef slots
+  #define _RESTORE_SLOTS 1
+#endif
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#ifdef _RESTORE_SLOTS
+  #pragma pop_macro("slots")
+  #undef _RESTORE_SLOTS
+#endif
+
+#include <string>
+
+#include "qpybufferexporter.h"
+
+namespace py = pybind11;
+
+namespace qtpyt {
+
+    /**
+     * @brief True if NumPy can be imported. The import is attempted once, on the first call.
+     * @note The GIL must be held.
+     */
+    bool numpyAvailable();
+
+    /**
+     * @brief True if \p obj is a numpy.ndarray. Never imports NumPy: without a loaded NumPy
+     * module no ndarray can exist.
+     * @note The GIL must be held.
+     */
+    bool isNdarray(const py::handle& obj);
+
+    /**
+     * @brief Create a 1-D ndarray of \p dtype over a fresh exporter for \p e.
+     *
+     * The exporter is the base object of the array, so the storage stays valid while the array
+     * (or any view of it) exists, and it counts as one export. Read-only exports produce arrays
+     * with the WRITEABLE flag cleared.
+     * @note The GIL must be held and numpyAvailable() must be true.
+     */
+    py::array makeExportedNdarray(QPyBufferExport&& e, const py::dtype& dtype);
+
+    namespace detail {
+
+        /**
+         * @brief NumPy dtype for the PEP 3118 format \p format with elements of \p itemsize
+         * bytes, created once per format.
+         *
+         * The format goes through NumPy's buffer-protocol parser: \c numpy.dtype() itself
+         * does not understand struct ("T{...}") or complex ("Zd") codes.
+         * @note The GIL must be held and numpyAvailable() must be true.
+         */
+        const py::dtype& numpyDtype(const std::string& format, py::ssize_t itemsize);
+
+    } // namespace detail
+
+} // namespace qtpyt
@@ -0,0 +1,61 @@
+#include <qtpyt/qpyrecord.h>
+#include "sharedarrayinternal.h"
+
+namespace qtpyt {
+    namespace {
+
+        py::object toPython(const detail::RecordArrayType& type, const void* array) {
+            py::gil_scoped_acquire gil;
+            detail::RecordArrayStorage s = type.storage(array);
+            QPyBufferExport e;
+            e.buf = s.data;
+            e.itemsize = static_cast<py::ssize_t>(type.itemsize);
+            e.length = static_cast<py::ssize_t>(s.count);
+            e.format = std::string(pep3118::native_byte_order_prefix()) + type.code;
+            e.readonly = s.readonly;
+            e.exports = s.exports;
+            e.changes = std::move(s.changes);
+            e.anchor = std::move(s.anchor);
+            if (type.exportMode() == QPyArrayExportMode::NumPy && numpyAvailable()) {
+                const py::dtype& dtype = detail::numpyDtype(e.format, e.itemsize);
+                return makeExportedNdarray(std::move(e), dtype);
+            }
+            return makeExportedMemoryView(std::move(e));
+        }
+
+        // Records are only accepted as contiguous buffers with the same field layout; the
+        // spelling may differ (NumPy writes "l" for int64 and drops trailing padding).
+        QVariant fromPython(const detail::RecordArrayType& type, const std::string& layout, const py::object& obj) {
+            if (!obj || obj.is_none())
+                return QVariant();
+            py::gil_scoped_acquire gil;
+            if (!py::isinstance<py::buffer>(obj))
+                return QVariant();
+            py::buffer_info info = py::reinterpret_borrow<py::buffer>(obj).request();
+            if (info.itemsize != static_cast<py::ssize_t>(type.itemsize) ||
+                pep3118::record_layout(info.format) != layout || !detail::is_c_contiguous(info))
+                return QVariant();
+            if (info.ndim != 1)
+                return type.copy(info.ptr, qsizetype(info.size));
+            return type.wrap(info.ptr, qsizetype(info.size), info.readonly, keep_alive(obj));
+        }
+
+    } // namespace
+
+    namespace detail {
+
+        void registerRecordArrayType(int typeId, RecordArrayType type) {
+            const std::string layout = pep3118::record_layout(type.code);
+            if (layout.empty())
+                throw std::runtime_error("registerRecordArray: cannot parse the record format '" + type.code + "'");
+            auto shared = std::make_shared<const RecordArrayType>(std::move(type));
+            addMetatypeVoidPtrToPyObjectConverterFunc(static_cast<QMetaType::Type>(typeId),
+                                                      [shared](const void* v) { return toPython(*shared, v); });
+            addFromQVariantFunc(typeId, [shared](const QVariant& v) { return toPython(*shared, v.constData()); });
+            addFromPyObjectToQVariantFunc(QString::fromLatin1(QMetaType(typeId).name()),
+                                          [shared, layout](const py::object& obj) { return fromPython(*shared, layout, obj); });
+        }
+
+    } // namespace detail
+
+} // namespace qtpyt
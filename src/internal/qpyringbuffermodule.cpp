@@ -0,0 +1,105 @@
+#include "qpyringbuffermodule.h"
+#include "qpybufferexporter.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace qtpyt {
+    namespace {
+
+        // Keeps the ring storage alive and counts the buffer exports of one view.
+        struct ViewAnchor {
+            std::shared_ptr<detail::QPyRingState> state;
+            std::atomic<int> exports{0};
+        };
+
+        py::memoryview slice(const QPyRingReader& r, quint64 position, quint64 offset, quint64 count) {
+            auto* owner = new ViewAnchor{r.state};
+            QPyBufferExport e;
+            e.buf = r.state->base + offset * quint64(r.state->itemsize);
+            e.itemsize = static_cast<py::ssize_t>(r.state->itemsize);
+            e.length = static_cast<py::ssize_t>(count);
+            e.format = r.format;
+            e.readonly = true;
+            // The view holds the ring state, so the storage outlives every handle.
+            e.anchor = detail::make_owner(owner, [](void* p) { delete static_cast<ViewAnchor*>(p); });
+            e.exports = &owner->exports;
+            QPyRingReader::View tracked{position, e.anchor, e.exports, {}};
+            py::memoryview view = makeExportedMemoryView(std::move(e));
+            if (count) {
+                // forget views Python has already dropped
+                auto& views = *r.views;
+                views.erase(std::remove_if(views.begin(), views.end(), [](const QPyRingReader::View& v) {
+                    return v.view().is_none() && v.exports->load(std::memory_order_acquire) == 0;
+                }), views.end());
+                tracked.view = py::weakref(view);
+                views.push_back(std::move(tracked));
+            }
+            return view;
+        }
+
+        // Release the views that start below end; throws while one of them is still exported.
+        void releaseViews(const QPyRingReader& r, quint64 end) {
+            auto& views = *r.views;
+            const auto consumed = std::partition(views.begin(), views.end(), [end](const QPyRingReader::View& v) {
+                return v.begin >= end;
+            });
+            for (auto it = consumed; it != views.end(); ++it) {
+                py::object view = it->view();
+                if (view.is_none())
+                    continue;
+                try {
+                    view.attr("release")();
+                } catch (py::error_already_set& e) {
+                    // a slice of the view is still alive; reported below
+                    if (!e.matches(PyExc_BufferError))
+                        throw;
+                }
+            }
+            for (auto it = consumed; it != views.end(); ++it) {
+                if (it->exports->load(std::memory_order_acquire) > 0)
+                    throw py::buffer_error("consume: a view of the consumed elements is still in use");
+            }
+            views.erase(consumed, views.end());
+        }
+
+    } // namespace
+
+    void addRingBufferType(py::module_& m) {
+        py::class_<QPyRingReader>(m, "RingBuffer", "Consumer end of a C++ QPyRingBuffer")
+            .def("read", [](const QPyRingReader& r, py::ssize_t max) {
+                const quint64 limit = max < 0 ? std::numeric_limits<quint64>::max() : quint64(max);
+                const auto span = r.state->readable(limit);
+                const quint64 tail = r.state->tail.load(std::memory_order_relaxed);
+                return py::make_tuple(slice(r, tail, span.firstOffset, span.firstSize),
+                                      slice(r, tail + span.firstSize, 0, span.secondSize));
+            }, py::arg("max") = -1,
+               "(first, second) read-only memoryviews over the readable elements; consume() releases them")
+            .def("consume", [](const QPyRingReader& r, py::ssize_t n) {
+                if (n < 0)
+                    throw py::value_error("consume: negative count");
+                if (quint64(n) > r.state->size())
+                    throw py::index_error("QPyRingBuffer: consume() past the readable region");
+                releaseViews(r, r.state->tail.load(std::memory_order_relaxed) + quint64(n));
+                try {
+                    r.state->consume(quint64(n));
+                } catch (const std::out_of_range& e) {
+                    throw py::index_error(e.what());
+                }
+            }, py::arg("n"),
+               "Release n elements to the producers; raises BufferError while a view of them is still exported")
+            .def("wait", [](const QPyRingReader& r, py::ssize_t min, double timeout) {
+                const int ms = timeout < 0 ? -1 : int(timeout * 1000.0);
+                py::gil_scoped_release release;
+                return r.state->waitForData(quint64(std::max<py::ssize_t>(min, 0)), ms);
+            }, py::arg("min") = 1, py::arg("timeout") = -1.0,
+               "Block until min elements are readable or timeout seconds pass; returns False on timeout")
+            .def("__len__", [](const QPyRingReader& r) { return py::ssize_t(r.state->size()); })
+            .def_property_readonly("capacity", [](const QPyRingReader& r) { return py::ssize_t(r.state->capacity); })
+            .def_property_readonly("dropped", [](const QPyRingReader& r) {
+                return r.state->dropped.load(std::memory_order_relaxed);
+            }, "Elements rejected by producers because the buffer was full")
+            .def_property_readonly("format", [](const QPyRingReader& r) { return r.format; });
+    }
+
+} // namespace qtpyt
@@ -0,0 +1,74 @@
+#pragma once
+#include <pybind11/pybind11.h>
+#include <qtpyt/qpyringbuffer.h>
+#include "../conversions.h"
+#include "../pep3118format.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace py = pybind11;
+
+namespace qtpyt {
+
+    /**
+     * @brief Consumer end of a QPyRingBuffer as seen from Python (\c qt_interop.RingBuffer).
+     */
+    struct QPyRingReader {
+        /// A memoryview returned by read(), tracked until consume() releases its elements.
+        struct View {
+            quint64 begin = 0;                            ///< absolute position of the first element
+            std::shared_ptr<detail::OwnerState> anchor;   ///< keeps the export counter alive
+            std::atomic<int>* exports = nullptr;          ///< buffer exports of the view's exporter
+            py::weakref view;                             ///< the memoryview handed to Python
+        };
+
+        std::shared_ptr<detail::QPyRingState> state;
+        std::string format;
+        std::shared_ptr<std::vector<View>> views = std::make_shared<std::vector<View>>();
+    };
+
+    /**
+     * @brief Add the \c RingBuffer type to \p m.
+     *
+     * Methods: \c read(max=-1) returns two memoryviews over the readable elements (the second
+     * is empty unless the region wraps) without consuming them; the views stay valid until
+     * \c consume(n) releases the elements. consume() releases the views of the consumed elements
+     * and raises BufferError, consuming nothing, while one of them is still exported (a slice, a
+     * NumPy array, ...), since producers would overwrite the memory under it. \c wait(min=1, timeout=-1.0) blocks with the
+     * interpreter lock released. \c len(ring), \c capacity and \c dropped report the state.
+     */
+    void addRingBufferType(py::module_& m);
+
+    /**
+     * @brief Register QPyRingBuffer<T> so that it is passed to Python as \c qt_interop.RingBuffer.
+     */
+    template <typename T>
+    int registerRingBuffer(const QString& name) {
+        const int id = qRegisterMetaType<QPyRingBuffer<T>>(name.toStdString().c_str());
+        addFromQVariantFunc(id, [](const QVariant& v) -> py::object {
+            const auto ring = v.template value<QPyRingBuffer<T>>();
+            if (ring.isNull())
+                return py::none();
+            return py::cast(QPyRingReader{ring.state(), pep3118::full_format_string<T>(QPyRecord<T>::isRecord)});
+        });
+        addMetatypeVoidPtrToPyObjectConverterFunc(static_cast<QMetaType::Type>(id), [](const void* v) -> py::object {
+            const auto* ring = static_cast<const QPyRingBuffer<T>*>(v);
+            if (ring->isNull())
+                return py::none();
+            return py::cast(QPyRingReader{ring->state(), pep3118::full_format_string<T>(QPyRecord<T>::isRecord)});
+        });
+        return id;
+    }
+
+} // namespace qtpyt
+
+Q_DECLARE_METATYPE(qtpyt::QPyRingBuffer<float>)
+
+Q_DECLARE_METATYPE(qtpyt::QPyRingBuffer<double>)
+
+Q_DECLARE_METATYPE(qtpyt::QPyRingBuffer<qint16>)
+
+Q_DECLARE_METATYPE(qtpyt::QPyRingBuffer<qint32>)
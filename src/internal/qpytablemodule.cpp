@@ -0,0 +1,196 @@
+#include "qpytablemodule.h"
+#include "qpybufferexporter.h"
+#include "../conversions.h"
+
+#include <string>
+
+namespace qtpyt {
+    namespace {
+
+        constexpr const char* SchemaCapsuleName = "arrow_schema";
+        constexpr const char* ArrayCapsuleName = "arrow_array";
+        constexpr const char* StreamCapsuleName = "arrow_array_stream";
+
+        // Capsule destructors release the struct if the consumer did not move it out.
+        void releaseSchemaCapsule(PyObject* capsule) {
+            auto* s = static_cast<ArrowSchema*>(PyCapsule_GetPointer(capsule, SchemaCapsuleName));
+            if (s && s->release)
+                s->release(s);
+            delete s;
+        }
+
+        void releaseArrayCapsule(PyObject* capsule) {
+            auto* a = static_cast<ArrowArray*>(PyCapsule_GetPointer(capsule, ArrayCapsuleName));
+            if (a && a->release)
+                a->release(a);
+            delete a;
+        }
+
+        void releaseStreamCapsule(PyObject* capsule) {
+            auto* s = static_cast<ArrowArrayStream*>(PyCapsule_GetPointer(capsule, StreamCapsuleName));
+            if (s && s->release)
+                s->release(s);
+            delete s;
+        }
+
+        template <typename S>
+        py::object makeCapsule(S* s, const char* name, PyCapsule_Destructor destructor) {
+            PyObject* capsule = PyCapsule_New(s, name, destructor);
+            if (!capsule) {
+                if (s->release)
+                    s->release(s);
+                delete s;
+                throw py::error_already_set();
+            }
+            return py::reinterpret_steal<py::object>(capsule);
+        }
+
+        template <typename S>
+        S* capsulePointer(const py::handle& capsule, const char* name) {
+            auto* p = static_cast<S*>(PyCapsule_GetPointer(capsule.ptr(), name));
+            if (!p)
+                throw py::error_already_set();
+            return p;
+        }
+
+        void rejectSchemaRequest(const py::object& requested) {
+            // Only the table's own schema is produced; casting is left to the consumer.
+            if (!requested.is_none())
+                throw py::value_error("qt_interop.Table: requested_schema is not supported");
+        }
+
+        py::object schemaCapsule(const QPyTable& t) {
+            auto* schema = new ArrowSchema{};
+            ArrowArray array{};
+            t.exportToArrow(&array, schema);
+            array.release(&array);
+            return makeCapsule(schema, SchemaCapsuleName, &releaseSchemaCapsule);
+        }
+
+        const char* pep3118Format(const std::string& arrow) {
+            switch (arrow.front()) {
+                case 'c': return "b";
+                case 'C': return "B";
+                case 's': return "h";
+                case 'S': return "H";
+                case 'i': return "i";
+                case 'I': return "I";
+                case 'l': return "q";
+                case 'L': return "Q";
+                case 'e': return "e";
+                case 'f': return "f";
+                default: return "d";
+            }
+        }
+
+        qsizetype columnIndex(const QPyTable& t, const py::handle& key) {
+            if (py::isinstance<py::str>(key)) {
+                const qsizetype i = t.indexOf(QString::fromStdString(key.cast<std::string>()));
+                if (i < 0)
+                    throw py::key_error(key.cast<std::string>());
+                return i;
+            }
+            const qsizetype i = key.cast<qsizetype>();
+            if (i < 0 || i >= t.columnCount())
+                throw py::index_error("column index out of range");
+            return i;
+        }
+
+        py::memoryview exportBytes(const void* data, py::ssize_t itemsize, py::ssize_t length, const char* format,
+                                   const std::shared_ptr<detail::OwnerState>& anchor) {
+            QPyBufferExport e;
+            e.buf = const_cast<void*>(data);
+            e.itemsize = itemsize;
+            e.length = length;
+            e.format = format;
+            e.readonly = true;
+            e.anchor = anchor;
+            return makeExportedMemoryView(std::move(e));
+        }
+
+    } // namespace
+
+    QPyTable tableFromPython(const py::handle& obj) {
+        if (py::isinstance<QPyTable>(obj))
+            return obj.cast<QPyTable>();
+        if (py::hasattr(obj, "__arrow_c_stream__")) {
+            py::object capsule = obj.attr("__arrow_c_stream__")();
+            auto* stream = capsulePointer<ArrowArrayStream>(capsule, StreamCapsuleName);
+            ArrowArrayStream moved = *stream;
+            stream->release = nullptr;
+            return QPyTable::importFromArrowStream(&moved);
+        }
+        if (py::hasattr(obj, "__arrow_c_array__")) {
+            py::tuple capsules = obj.attr("__arrow_c_array__")();
+            const auto* schema = capsulePointer<ArrowSchema>(capsules[0], SchemaCapsuleName);
+            auto* array = capsulePointer<ArrowArray>(capsules[1], ArrayCapsuleName);
+            return QPyTable::importFromArrow(array, schema);
+        }
+        throw py::type_error("expected an object implementing the Arrow PyCapsule interface");
+    }
+
+    void addTableType(py::module_& m) {
+        py::class_<QPyTable>(m, "Table", "Columns of a C++ QPyTable, exchanged through the Arrow C Data Interface")
+            .def_static("from_arrow", [](const py::object& obj) { return tableFromPython(obj); }, py::arg("data"),
+                        "Import an object implementing __arrow_c_stream__ or __arrow_c_array__ without copying")
+            .def_property_readonly("num_rows", &QPyTable::rowCount)
+            .def_property_readonly("num_columns", &QPyTable::columnCount)
+            .def_property_readonly("column_names", [](const QPyTable& t) {
+                py::list names;
+                for (const QString& n : t.columnNames())
+                    names.append(n.toStdString());
+                return names;
+            })
+            .def("__len__", &QPyTable::rowCount)
+            .def("column", [](const QPyTable& t, const py::object& key) {
+                const QPyTableColumn& c = t.columnAt(columnIndex(t, key));
+                return exportBytes(c.data, c.itemsize, t.rowCount(), pep3118Format(c.format), c.anchor);
+            }, py::arg("key"), "Read-only zero-copy memoryview of a column (by name or index)")
+            .def("validity", [](const QPyTable& t, const py::object& key) -> py::object {
+                const QPyTableColumn& c = t.columnAt(columnIndex(t, key));
+                if (!c.validity)
+                    return py::none();
+                return exportBytes(c.validity, 1, (t.rowCount() + 7) / 8, "B", c.anchor);
+            }, py::arg("key"), "Validity bitmap of a column (LSB first, 1 = valid), or None without nulls")
+            .def("__arrow_c_schema__", [](const QPyTable& t) { return schemaCapsule(t); })
+            .def("__arrow_c_array__", [](const QPyTable& t, const py::object& requested) {
+                rejectSchemaRequest(requested);
+                auto* schema = new ArrowSchema{};
+                auto* array = new ArrowArray{};
+                try {
+                    t.exportToArrow(array, schema);
+                } catch (...) {
+                    delete schema;
+                    delete array;
+                    throw;
+                }
+                py::object s = makeCapsule(schema, SchemaCapsuleName, &releaseSchemaCapsule);
+                py::object a = makeCapsule(array, ArrayCapsuleName, &releaseArrayCapsule);
+                return py::make_tuple(s, a);
+            }, py::arg("requested_schema") = py::none())
+            .def("__arrow_c_stream__", [](const QPyTable& t, const py::object& requested) {
+                rejectSchemaRequest(requested);
+                auto* stream = new ArrowArrayStream{};
+                t.exportToArrowStream(stream);
+                return makeCapsule(stream, StreamCapsuleName, &releaseStreamCapsule);
+            }, py::arg("requested_schema") = py::none());
+    }
+
+    void registerTableType() {
+        const int id = qRegisterMetaType<QPyTable>("QPyTable");
+        addFromQVariantFunc(id, [](const QVariant& v) -> py::object {
+            return py::cast(v.value<QPyTable>());
+        });
+        addMetatypeVoidPtrToPyObjectConverterFunc(static_cast<QMetaType::Type>(id), [](const void* v) -> py::object {
+            return py::cast(*static_cast<const QPyTable*>(v));
+        });
+        addFromPyObjectToQVariantFunc(QStringLiteral("QPyTable"), [](const py::object& obj) -> QVariant {
+            try {
+                return QVariant::fromValue(tableFromPython(obj));
+            } catch (const py::type_error&) {
+                return QVariant();
+            }
+        });
+    }
+
+} // namespace qtpyt
@@ -0,0 +1,26 @@
+#pragma once
+#include <pybind11/pybind11.h>
+#include <qtpyt/qpytable.h>
+
+namespace py = pybind11;
+
+namespace qtpyt {
+
+    /**
+     * @brief Add the \c Table type (a QPyTable implementing the Arrow PyCapsule protocol) to \p m.
+     */
+    void addTableType(py::module_& m);
+
+    /**
+     * @brief Convert any object implementing \c __arrow_c_stream__ or \c __arrow_c_array__
+     * (pyarrow, polars, ...) or a \c qt_interop.Table to a QPyTable without copying the buffers.
+     * @throws py::type_error if the object does not implement the protocol.
+     */
+    QPyTable tableFromPython(const py::handle& obj);
+
+    /**
+     * @brief Register QPyTable with the QVariant <-> Python conversions.
+     */
+    void registerTableType();
+
+} // namespace qtpyt
@@ -6,48 +6,161 @@
 #endif
 #include <pybind11/pybind11.h>
 #include <pybind11/buffer_info.h>
+#include <pybind11/complex.h>
 #include <pybind11/numpy.h>
 #ifdef _RESTORE_SLOTS
   #pragma pop_macro("slots")
   #undef _RESTORE_SLOTS
 #endif
 #include <qtpyt/qpysharedarray.h>
+#include <qtpyt/qpykernels.h>
 #include "../conversions.h"
+#include "../pep3118format.h"
 #include <QVariant>
 #include <vector>
 #include "stringpool.h"
+#include "qpybufferexporter.h"
+#include "qpydlpack.h"
+#include "qpynumpy.h"
 
 
 namespace qtpyt {
 namespace py = pybind11;
 
 inline std::shared_ptr<detail::OwnerState> keep_alive(py::object obj) {
-    auto* heapObj = new py::object(std::move(obj));
+    // The owner holds the strong reference itself, so no py::object is allocated for it.
     return detail::make_owner(
-        heapObj,
+        obj.release().ptr(),
         [](void* p) {
-            // Deleting py::object will DECREF; ensure GIL is held.
+            // Dropping the reference may deallocate the object; ensure GIL is held.
             py::gil_scoped_acquire gil;
-            delete static_cast<py::object*>(p);
+            Py_DECREF(static_cast<PyObject*>(p));
         }
     );
 }
 
-// Convert QPySharedArray<T> -> memoryview (zero-copy if external/owned contiguous)
+namespace detail {
+
+template <typename T>
+struct SharedArrayAccess {
+    using Data = typename QPySharedArray<T>::Data;
+
+    // Describe the array storage for the buffer exporter; the anchor owns a reference to Data.
+    static QPyBufferExport makeExport(const QPySharedArray<T>& a, const std::string& format) {
+        QPyBufferExport e;
+        e.buf = const_cast<T*>(a.constData());
+        e.itemsize = static_cast<py::ssize_t>(sizeof(T));
+        e.length = static_cast<py::ssize_t>(a.size());
+        e.format = format;
+        e.readonly = a.isReadOnly();
+        e.exports = &a.d_->m_exports;
+        e.changes = a.d_->m_changes;
+        a.d_->ref.ref();
+        e.anchor = make_owner(a.d_.data(), [](void* p) {
+            auto* d = static_cast<Data*>(p);
+            if (!d->ref.deref())
+                delete d;
+        });
+        return e;
+    }
+};
+
+// Buffer format of exported arrays. Scalars use the native spelling without a byte-order
+// prefix ("i", "e", "Zf"), so memoryview can index all of them except complex: CPython has
+// no unpacker for "Zf"/"Zd", those views are read through NumPy or cast('B').cast('f').
+// Records described with QTPYT_RECORD export "<T{...}" with explicit padding.
+template <typename T>
+std::string export_format() {
+    return pep3118::full_format_string<T>(QPyRecord<T>::isRecord);
+}
+
+// Element of a Python sequence as T, for types pybind11 has no caster for.
+template <typename T>
+T element_from_py(const py::handle& h) {
+    if constexpr (std::is_same_v<T, qfloat16>)
+        return qfloat16(h.cast<float>());
+    else if constexpr (std::is_same_v<T, std::byte>)
+        return std::byte(h.cast<unsigned int>());
+    else
+        return h.cast<T>();
+}
+
+} // namespace detail
+
+// Convert QPySharedArray<T> -> memoryview (zero-copy; the view keeps the storage alive)
 template <typename T>
 py::memoryview to_memoryview( qtpyt::QPySharedArray<T>* a) {
     py::gil_scoped_acquire gil;
-    const py::ssize_t n = static_cast<py::ssize_t>(a->size());
-
-    // 1D buffer
-    return py::memoryview::from_buffer(a->data(), // ptr
-                                       static_cast<py::ssize_t>(sizeof(T)), // itemsize
-                                       py::format_descriptor<T>::format().c_str(),
-                                       std::vector<py::ssize_t>{n}, // shape
-                                       std::vector<py::ssize_t>{static_cast<py::ssize_t>(sizeof(T))},
-                                       a->isReadOnly());
+    return makeExportedMemoryView(detail::SharedArrayAccess<T>::makeExport(*a, detail::export_format<T>()));
 }
 
+// Convert QPySharedArray<T> -> ndarray or memoryview according to \p mode (zero-copy either way)
+template <typename T>
+py::object to_pyobject(const QPySharedArray<T>& a, QPyArrayExportMode mode = sharedArrayExportMode<T>()) {
+    py::gil_scoped_acquire gil;
+    if (mode == QPyArrayExportMode::NumPy && numpyAvailable()) {
+        static const py::dtype* dtype = &detail::numpyDtype(detail::export_format<T>(), py::ssize_t(sizeof(T)));
+        return makeExportedNdarray(detail::SharedArrayAccess<T>::makeExport(a, detail::export_format<T>()), *dtype);
+    }
+    return makeExportedMemoryView(detail::SharedArrayAccess<T>::makeExport(a, detail::export_format<T>()));
+}
+
+namespace detail {
+
+// Same-sized element type the kernels are instantiated for, or void.
+template <typename T>
+using kernel_type_t =
+    std::conditional_t<std::is_same_v<T, bool>, void,
+    std::conditional_t<std::is_floating_point_v<T>,
+        std::conditional_t<std::is_same_v<T, float> || std::is_same_v<T, double>, T, void>,
+    std::conditional_t<std::is_integral_v<T> && sizeof(T) == 1 && std::is_unsigned_v<T>, quint8,
+    std::conditional_t<std::is_integral_v<T> && sizeof(T) == 4 && std::is_signed_v<T>, qint32,
+    std::conditional_t<std::is_integral_v<T> && sizeof(T) == 8 && std::is_signed_v<T>, qint64, void>>>>>;
+
+inline bool is_c_contiguous(const py::buffer_info& info) {
+    py::ssize_t expected = info.itemsize;
+    for (py::ssize_t d = info.ndim - 1; d >= 0; --d) {
+        if (info.shape[size_t(d)] > 1 && info.strides[size_t(d)] != expected)
+            return false;
+        expected *= info.shape[size_t(d)];
+    }
+    return true;
+}
+
+// Converts a contiguous buffer of another numeric type into a new array in one vectorized pass.
+// Returns false if either side is not a kernel type.
+template <typename T>
+bool convert_buffer(const py::buffer_info& info, QPySharedArray<T>& out) {
+    using To = kernel_type_t<T>;
+    if constexpr (std::is_void_v<To>) {
+        return false;
+    } else {
+        if (!is_c_contiguous(info))
+            return false;
+        const std::string code = pep3118::canonical_code(info.format, info.itemsize);
+        const auto n = static_cast<qsizetype>(info.size);
+        auto run = [&](auto tag) {
+            using From = decltype(tag);
+            QPySharedArray<T> arr(n);
+            To* dst = reinterpret_cast<To*>(arr.data());
+            {
+                py::gil_scoped_release release;
+                kernels::convert<From, To>(static_cast<const From*>(info.ptr), dst, n);
+            }
+            out = std::move(arr);
+            return true;
+        };
+        if (code == "B") return run(quint8{});
+        if (code == "i") return run(qint32{});
+        if (code == "q") return run(qint64{});
+        if (code == "f") return run(float{});
+        if (code == "d") return run(double{});
+        return false;
+    }
+}
+
+} // namespace detail
+
 // Convert Python buffer -> QPySharedArray<T>, optionally zero-copy by viewing exporter memory
 template <typename T>
 qtpyt::QPySharedArray<T> from_buffer(py::buffer b, bool allowZeroCopy = true, bool takeOwnership = false) {
@@ -57,11 +170,13 @@ qtpyt::QPySharedArray<T> from_buffer(py::buffer b, bool allowZeroCopy = true, bo
     if (info.ndim != 1)
         throw std::runtime_error("Expected a 1D buffer");
 
-    if (info.itemsize != (py::ssize_t)sizeof(T))
-        throw std::runtime_error("Itemsize mismatch for requested T");
+    if (!pep3118::format_matches<T>(info.format, info.itemsize))
+        throw std::runtime_error("Buffer format '" + info.format + "' does not match the element type '" +
+                                 pep3118::format<T>::code() + "'");
+
+    if (info.shape[0] > 1 && info.strides[0] != info.itemsize)
+        throw std::runtime_error("Expected a contiguous buffer");
 
-    // If you want strict format checking, compare info.format vs format_descriptor<T>::format()
-    // (Some exporters leave format empty or use compatible aliases.)
     const auto n = static_cast<qsizetype>(info.shape[0]);
     auto* ptr = static_cast<T*>(info.ptr);
 
@@ -96,19 +211,57 @@ qtpyt::QPySharedArray<T> from_buffer(py::buffer b, bool allowZeroCopy = true, bo
             return QVariant::fromValue(arr);
         };
 
-        if (py::isinstance<py::buffer>(obj)) {
-            py::buffer buf = py::buffer(obj);
-            py::buffer_info info = buf.request();
+        // ndarrays: one type check and a dtype comparison, no buffer request
+        if (isNdarray(obj)) {
+            static const py::dtype* dtype = &detail::numpyDtype(detail::export_format<T>(), py::ssize_t(sizeof(T)));
+            const auto arr = py::reinterpret_borrow<py::array>(obj);
+            if ((arr.flags() & py::array::c_style) && PyObject_RichCompareBool(arr.dtype().ptr(), dtype->ptr(), Py_EQ) == 1) {
+                if (!allowZeroCopy)
+                    return copy_bytes_to_array(arr.data(), size_t(arr.nbytes()));
+                QPySharedArray<T> a = QPySharedArray<T>::wrapWithOwner(
+                    static_cast<T*>(const_cast<void*>(arr.data())), qsizetype(arr.size()), false, keep_alive(arr));
+                if (!arr.writeable())
+                    a.setReadOnly(true);
+                return QVariant::fromValue(a);
+            }
+        }
 
-            if (allowZeroCopy && info.ndim == 1 && static_cast<size_t>(info.itemsize) == sizeof(T)) {
-                QPySharedArray<T> a = from_buffer<T>(buf, allowZeroCopy, /*takeOwnership=*/false);
+        // DLPack producers (NumPy 2, PyTorch CPU tensors, JAX) hand over C-contiguous tensors of
+        // any rank without copying; other element types fall through to the conversions below.
+        if (!PyMemoryView_Check(obj.ptr())) {
+            if (auto tensor = importDLPack(obj); tensor && detail::dlpack_dtype_matches<T>(tensor->dtype)) {
+                if (!allowZeroCopy)
+                    return copy_bytes_to_array(tensor->data, size_t(tensor->count) * sizeof(T));
+                QPySharedArray<T> a = QPySharedArray<T>::wrapWithOwner(static_cast<T*>(tensor->data),
+                                                                       qsizetype(tensor->count), false,
+                                                                       std::move(tensor->anchor));
+                if (tensor->readonly)
+                    a.setReadOnly(true);
                 return QVariant::fromValue(a);
             }
+        }
 
-            const size_t total_bytes = static_cast<size_t>(info.size) * static_cast<size_t>(info.itemsize);
-            if (static_cast<size_t>(info.itemsize) == sizeof(T)) {
+        if (py::isinstance<py::buffer>(obj)) {
+            py::buffer buf = py::buffer(obj);
+            py::buffer_info info = buf.request();
+
+            // Element types must match exactly; equal item sizes alone ('f' vs 'i') are not enough.
+            if (pep3118::format_matches<T>(info.format, info.itemsize) && detail::is_c_contiguous(info)) {
+                if (allowZeroCopy && info.ndim == 1) {
+                    // bytes and other read-only exporters stay read-only; writes go to a copy
+                    QPySharedArray<T> a = from_buffer<T>(buf, allowZeroCopy, /*takeOwnership=*/false);
+                    if (info.readonly)
+                        a.setReadOnly(true);
+                    return QVariant::fromValue(a);
+                }
+                const size_t total_bytes = static_cast<size_t>(info.size) * static_cast<size_t>(info.itemsize);
                 return copy_bytes_to_array(info.ptr, total_bytes);
             }
+
+            QPySharedArray<T> converted;
+            if (detail::convert_buffer<T>(info, converted))
+                return QVariant::fromValue(converted);
+            // other element types fall through to the per-element conversion below
         }
 
         if (py::isinstance<py::bytes>(obj) || py::isinstance<py::bytearray>(obj)) {
@@ -116,7 +269,7 @@ qtpyt::QPySharedArray<T> from_buffer(py::buffer b, bool allowZeroCopy = true, bo
             py::buffer_info info = buf.request();
             const size_t total_bytes = static_cast<size_t>(info.size) * static_cast<size_t>(info.itemsize);
 
-            if (allowZeroCopy && info.ndim == 1 && static_cast<size_t>(info.itemsize) == sizeof(T)) {
+            if (allowZeroCopy && info.ndim == 1 && pep3118::format_matches<T>(info.format, info.itemsize)) {
                 QPySharedArray<T> a = from_buffer<T>(buf, allowZeroCopy, /*takeOwnership=*/false);
                 return QVariant::fromValue(a);
             }
@@ -127,14 +280,15 @@ qtpyt::QPySharedArray<T> from_buffer(py::buffer b, bool allowZeroCopy = true, bo
             return QVariant();
         }
 
-        if (py::isinstance<py::sequence>(obj)) {
+        // Records are only accepted as buffers with a matching "T{...}" layout.
+        if constexpr (!QPyRecord<T>::isRecord) if (py::isinstance<py::sequence>(obj)) {
             py::sequence seq = py::reinterpret_borrow<py::sequence>(obj);
             const ssize_t n = seq.size();
             if (n < 0) return QVariant();
 
             QPySharedArray<T> arr(static_cast<qsizetype>(n));
             for (ssize_t i = 0; i < n; ++i) {
-                arr[static_cast<qsizetype>(i)] = seq[i].cast<T>();
+                arr[static_cast<qsizetype>(i)] = detail::element_from_py<T>(seq[i]);
             }
             return QVariant::fromValue(arr);
         }
@@ -158,30 +312,21 @@ public:
     static_assert(std::is_trivially_copyable_v<T>,
                   "Typed memoryview requires trivially copyable T");
 
-    const py::ssize_t n = static_cast<py::ssize_t>(_this->size());
-
     py::gil_scoped_acquire gil;
-    auto* fmtptr = StringPool::instance().intern(py::format_descriptor<T>::format());
-    return py::memoryview::from_buffer(const_cast<void *>(static_cast<const void *>(_this->constData())),
-                                       static_cast<py::ssize_t>(sizeof(T)), // itemsize
-                                       fmtptr->c_str(),
-                                       std::vector<py::ssize_t>{n}, // shape
-                                       std::vector<py::ssize_t>{static_cast<py::ssize_t>(sizeof(T))},
-                                       _this->isReadOnly());
+    auto* fmtptr = StringPool::instance().intern(detail::export_format<T>());
+    return makeExportedMemoryView(detail::SharedArrayAccess<T>::makeExport(*_this, *fmtptr));
 }
 
     template<typename T>
     static int registerSharedArray(const QString &name, bool allowZeroCopy = true) {
         auto id = qRegisterMetaType<QPySharedArray<T> >(name.toStdString().c_str());
         addMetatypeVoidPtrToPyObjectConverterFunc(static_cast<QMetaType::Type>(id), [](const void *v) {
-            auto *ptr = static_cast<QPySharedArray<T> *>(const_cast<void*>(v));
-            return to_memoryview<T>(ptr);
+            return to_pyobject<T>(*static_cast<const QPySharedArray<T> *>(v));
         });
 
         addFromQVariantFunc(id, [](const QVariant &v) {
             QPySharedArray<T> arr = v.template value<QPySharedArray<T> >();
-            auto obj = toMemoryView<T>(&arr);
-            return obj;
+            return to_pyobject<T>(arr);
         });
 
     QString typeName = QMetaType::typeName(id);
@@ -220,3 +365,11 @@ Q_DECLARE_METATYPE(qtpyt::QPySharedArray<std::byte>)
 
 Q_DECLARE_METATYPE(qtpyt::QPySharedArray<std::int8_t>)
 
+Q_DECLARE_METATYPE(qtpyt::QPySharedArray<bool>)
+
+Q_DECLARE_METATYPE(qtpyt::QPySharedArray<qfloat16>)
+
+Q_DECLARE_METATYPE(qtpyt::QPySharedArray<std::complex<float>>)
+
+Q_DECLARE_METATYPE(qtpyt::QPySharedArray<std::complex<double>>)
+
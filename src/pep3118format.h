@@ -1,107 +1,276 @@
 #pragma once
 #include <pybind11/pybind11.h>
-#include <type_traits>
-#include <complex>
-#include <cstdint>
+#include <qtpyt/qpyrecord.h>
+#include <algorithm>
+#include <cctype>
 #include <string>
 
 namespace py = pybind11;
 
+// Format generation is public (<qtpyt/qpyrecord.h>); parsing needs pybind11 and stays here.
+namespace pep3118 = qtpyt::pep3118;
+
+namespace qtpyt::pep3118 {
+
 // -----------------------------
-// PEP 3118 format generation
+// PEP 3118 format parsing
 // -----------------------------
-namespace pep3118 {
-
-constexpr const char* native_byte_order_prefix() {
-#if defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && defined(__ORDER_BIG_ENDIAN__)
-#  if (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-    return "<";
-#  elif (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
-    return ">";
-#  else
-    return "=";
-#  endif
-#elif defined(_WIN32)
-    return "<"; // Windows is little-endian on supported architectures
-#else
-    return "="; // safest fallback
-#endif
-}
 
-template <typename T>
-std::string integral_code() {
-    static_assert(std::is_integral_v<T>, "integral_code<T> requires integral T");
-    if constexpr (std::is_same_v<T, bool>) {
-        return "?";
-    } else if constexpr (sizeof(T) == 1) {
-        return std::is_signed_v<T> ? "b" : "B";
-    } else if constexpr (sizeof(T) == 2) {
-        return std::is_signed_v<T> ? "h" : "H";
-    } else if constexpr (sizeof(T) == 4) {
-        return std::is_signed_v<T> ? "i" : "I";
-    } else if constexpr (sizeof(T) == 8) {
-        return std::is_signed_v<T> ? "q" : "Q";
-    } else {
-        static_assert(sizeof(T) == 1 || sizeof(T) == 2 || sizeof(T) == 4 || sizeof(T) == 8,
-                      "Unsupported integer size");
-        return "";
+// Canonical code of a single-element buffer format, in the spelling produced by format<T>::code():
+// byte-order prefixes for the native order are dropped and integer codes are resolved by item
+// size ("<l" with itemsize 8 becomes "q"). An empty format means "B" (PEP 3118).
+// Returns an empty string for non-native byte order, multi-field or unknown formats.
+inline std::string canonical_code(std::string fmt, py::ssize_t itemsize) {
+    if (fmt.empty())
+        fmt = "B";
+    const char native = native_byte_order_prefix()[0];
+    const char prefix = fmt.front();
+    if (prefix == '@' || prefix == '=' || (prefix == native && native != '=') ||
+        (prefix == '!' && native == '>')) {
+        fmt.erase(0, 1);
+    } else if (prefix == '<' || prefix == '>' || prefix == '!') {
+        return {};
     }
-}
 
-template <typename T>
-std::string float_code() {
-    static_assert(std::is_floating_point_v<T>, "float_code<T> requires floating-point T");
-    if constexpr (sizeof(T) == 4) return "f";
-    if constexpr (sizeof(T) == 8) return "d";
-    // long double is messy across platforms; PEP 3118 uses 'g' for long double.
-    if constexpr (std::is_same_v<T, long double>) return "g";
-    static_assert(sizeof(T) == 4 || sizeof(T) == 8 || std::is_same_v<T, long double>,
-                  "Unsupported float size for PEP 3118 mapping");
-    return "";
-}
+    if (fmt.size() == 2 && fmt.front() == 'Z') {
+        const char c = fmt[1];
+        return (c == 'f' || c == 'd' || c == 'g') ? fmt : std::string();
+    }
+    if (fmt.size() != 1)
+        return {};
 
-template <typename T>
-std::string complex_code() {
-    static_assert(std::is_same_v<T, std::complex<float>> ||
-                  std::is_same_v<T, std::complex<double>> ||
-                  std::is_same_v<T, std::complex<long double>>,
-                  "Unsupported complex type for PEP 3118 mapping");
-
-    if constexpr (std::is_same_v<T, std::complex<float>>)       return "Zf";
-    if constexpr (std::is_same_v<T, std::complex<double>>)      return "Zd";
-    if constexpr (std::is_same_v<T, std::complex<long double>>) return "Zg";
-    return "";
+    auto sized = [itemsize](bool isSigned) -> std::string {
+        switch (itemsize) {
+            case 1: return isSigned ? "b" : "B";
+            case 2: return isSigned ? "h" : "H";
+            case 4: return isSigned ? "i" : "I";
+            case 8: return isSigned ? "q" : "Q";
+            default: return {};
+        }
+    };
+    switch (fmt.front()) {
+        case 'b': case 'h': case 'i': case 'l': case 'q': case 'n':
+            return sized(true);
+        case 'B': case 'H': case 'I': case 'L': case 'Q': case 'N':
+            return sized(false);
+        case 'c':
+            return sized(std::is_signed_v<char>);
+        case '?': case 'e': case 'f': case 'd': case 'g':
+            return fmt;
+        default:
+            return {};
+    }
 }
 
-template <typename T, typename Enable = void>
-struct format {
-    // Default: refuse unless trivially copyable AND user chooses to expose as bytes.
-    static std::string code() {
-        static_assert(std::is_void_v<Enable>,
-                      "pep3118::format<T> not specialized for this type");
-        return "";
+namespace detail {
+
+// Reads the field list of a "T{...}" format for record_layout().
+struct layout_parser {
+    struct item {
+        std::string layout;
+        std::size_t size = 0;
+        std::size_t align = 1;
+    };
+
+    const std::string& fmt;
+    std::size_t pos = 0;
+    bool ok = true;
+    bool native = true; // '@' (the default): native sizes and alignment; otherwise standard sizes
+
+    // Consumes a byte-order character; a non-native byte order fails the parse.
+    bool byte_order(char c) {
+        const char host = native_byte_order_prefix()[0];
+        if (c == '@') {
+            native = true;
+        } else if (c == '=' || (c == host && host != '=') || (c == '!' && host == '>')) {
+            native = false;
+        } else if (c == '<' || c == '>' || c == '!') {
+            ok = false;
+        } else {
+            return false;
+        }
+        ++pos;
+        return true;
     }
-};
 
-template <typename T>
-struct format<T, std::enable_if_t<std::is_integral_v<T>>> {
-    static std::string code() { return integral_code<T>(); }
-};
+    static std::string integer(std::size_t size, bool isSigned) {
+        switch (size) {
+            case 1: return isSigned ? "b" : "B";
+            case 2: return isSigned ? "h" : "H";
+            case 4: return isSigned ? "i" : "I";
+            case 8: return isSigned ? "q" : "Q";
+            default: return {};
+        }
+    }
 
-// Floating specialization
-template <typename T>
-struct format<T, std::enable_if_t<std::is_floating_point_v<T>>> {
-    static std::string code() { return float_code<T>(); }
+    // Scalar code at pos, integers resolved by size ("l" becomes "q" on LP64).
+    item scalar() {
+        item it;
+        const char c = fmt[pos++];
+        auto set = [&](std::string layout, std::size_t size, std::size_t align) {
+            it.layout = std::move(layout);
+            it.size = size;
+            it.align = native ? align : 1;
+            ok = ok && !it.layout.empty();
+        };
+        switch (c) {
+            case 'b': set("b", 1, 1); break;
+            case 'B': set("B", 1, 1); break;
+            case 'c': set(integer(1, std::is_signed_v<char>), 1, 1); break;
+            case '?': set("?", 1, alignof(bool)); break;
+            case 'h': set("h", 2, alignof(short)); break;
+            case 'H': set("H", 2, alignof(short)); break;
+            case 'i': set("i", 4, alignof(int)); break;
+            case 'I': set("I", 4, alignof(int)); break;
+            case 'l': set(integer(native ? sizeof(long) : 4, true), native ? sizeof(long) : 4, alignof(long)); break;
+            case 'L': set(integer(native ? sizeof(long) : 4, false), native ? sizeof(long) : 4, alignof(long)); break;
+            case 'q': set("q", 8, alignof(long long)); break;
+            case 'Q': set("Q", 8, alignof(long long)); break;
+            case 'n': set(native ? integer(sizeof(std::size_t), true) : std::string(), sizeof(std::size_t), alignof(std::size_t)); break;
+            case 'N': set(native ? integer(sizeof(std::size_t), false) : std::string(), sizeof(std::size_t), alignof(std::size_t)); break;
+            case 'e': set("e", 2, 2); break;
+            case 'f': set("f", 4, alignof(float)); break;
+            case 'd': set("d", 8, alignof(double)); break;
+            case 'g': set(native ? "g" : "", sizeof(long double), alignof(long double)); break;
+            case 'Z': {
+                if (pos >= fmt.size()) {
+                    ok = false;
+                    break;
+                }
+                item part = scalar();
+                if (part.layout != "f" && part.layout != "d" && part.layout != "g")
+                    ok = false;
+                it.layout = "Z" + part.layout;
+                it.size = 2 * part.size;
+                it.align = part.align;
+                break;
+            }
+            default: ok = false;
+        }
+        return it;
+    }
+
+    // Shape "(2,3)" or repeat count "3" at pos, normalized to "(2,3)"; empty for one element.
+    std::string shape(std::size_t& count) {
+        count = 1;
+        const bool parens = fmt[pos] == '(';
+        if (parens)
+            ++pos;
+        std::string dims;
+        while (pos < fmt.size() && std::isdigit(static_cast<unsigned char>(fmt[pos]))) {
+            std::size_t n = 0;
+            while (pos < fmt.size() && std::isdigit(static_cast<unsigned char>(fmt[pos])))
+                n = n * 10 + std::size_t(fmt[pos++] - '0');
+            count *= n;
+            dims += (dims.empty() ? "" : ",") + std::to_string(n);
+            if (!parens || pos >= fmt.size() || fmt[pos] != ',')
+                break;
+            ++pos;
+        }
+        if (parens) {
+            if (pos >= fmt.size() || fmt[pos] != ')' || dims.empty())
+                ok = false;
+            ++pos;
+        }
+        return dims.empty() ? std::string() : "(" + dims + ")";
+    }
+
+    // Fields of a record after its "T{", up to and including the closing "}". Every field is
+    // written as "offset shape code:name:", so layouts compare equal whether gaps are spelled
+    // as "x" padding or follow from native alignment; trailing padding is not part of it.
+    item record() {
+        item rec;
+        rec.layout = "T{";
+        std::size_t offset = 0;
+        const bool outer = native;
+        while (ok) {
+            if (pos >= fmt.size()) {
+                ok = false;
+                break;
+            }
+            if (fmt[pos] == '}') {
+                ++pos;
+                break;
+            }
+            if (byte_order(fmt[pos]))
+                continue;
+            std::size_t count = 1;
+            std::string dims;
+            if (fmt[pos] == '(' || std::isdigit(static_cast<unsigned char>(fmt[pos])))
+                dims = shape(count);
+            if (!ok || pos >= fmt.size()) {
+                ok = false;
+                break;
+            }
+            if (fmt[pos] == 'x') {
+                ++pos;
+                offset += count;
+                continue;
+            }
+            item elem;
+            if (fmt.compare(pos, 2, "T{") == 0) {
+                pos += 2;
+                elem = record();
+            } else {
+                elem = scalar();
+            }
+            std::string name;
+            if (pos < fmt.size() && fmt[pos] == ':') {
+                const std::size_t end = fmt.find(':', pos + 1);
+                if (end == std::string::npos) {
+                    ok = false;
+                    break;
+                }
+                name = fmt.substr(pos + 1, end - pos - 1);
+                pos = end + 1;
+            }
+            if (native)
+                offset = (offset + elem.align - 1) / elem.align * elem.align;
+            rec.align = std::max(rec.align, elem.align);
+            rec.layout += std::to_string(offset) + dims + elem.layout + ':' + name + ':';
+            offset += elem.size * count;
+        }
+        rec.layout += '}';
+        rec.size = native ? (offset + rec.align - 1) / rec.align * rec.align : offset;
+        native = outer;
+        return rec;
+    }
 };
 
+} // namespace detail
+
+// Field layout of a record format: names, offsets and canonical codes of all fields, so
+// "<T{q:a:d:b:i:c:4x}" (as exported for a QTPYT_RECORD type) and "T{l:a:d:b:i:c:}" (as
+// exported by NumPy on LP64) yield the same layout. The item size is not part of it and has to
+// be compared separately. Returns an empty string for non-native byte order or a format that
+// is not a single record.
+inline std::string record_layout(const std::string& fmt) {
+    detail::layout_parser p{fmt};
+    while (p.ok && p.pos < fmt.size() && p.byte_order(fmt[p.pos])) {
+    }
+    if (!p.ok || fmt.compare(p.pos, 2, "T{") != 0)
+        return {};
+    p.pos += 2;
+    std::string layout = p.record().layout;
+    return p.ok && p.pos == fmt.size() ? layout : std::string();
+}
+
+// True if a buffer with this format and item size holds elements of type T.
+// Plain char holds raw bytes whatever its signedness, so it also takes "B" (bytes, bytearray).
 template <typename T>
-struct format<T, std::enable_if_t<
-    std::is_same_v<T, std::complex<float>> ||
-    std::is_same_v<T, std::complex<double>> ||
-    std::is_same_v<T, std::complex<long double>>
->> {
-    static std::string code() { return complex_code<T>(); }
-};
+bool format_matches(const std::string& fmt, py::ssize_t itemsize) {
+    if (itemsize != static_cast<py::ssize_t>(sizeof(T)))
+        return false;
+    if constexpr (qtpyt::QPyRecord<T>::isRecord) {
+        static const std::string layout = record_layout(format<T>::code());
+        return !layout.empty() && record_layout(fmt) == layout;
+    } else if constexpr (std::is_same_v<T, char>) {
+        const std::string code = canonical_code(fmt, itemsize);
+        return code == "b" || code == "B";
+    } else {
+        return canonical_code(fmt, itemsize) == format<T>::code();
+    }
+}
 
 template <typename T>
 std::string full_format_string(bool include_byte_order = true) {
@@ -111,4 +280,4 @@ std::string full_format_string(bool include_byte_order = true) {
     return s;
 }
 
-} // namespace pep3118
+} // namespace qtpyt::pep3118
@@ -3,6 +3,10 @@
 #include <pybind11/embed.h>
 #include "pymodule.h"
 #include "q_embed_meta_object_py.h"
+#include "internal/qpybufferexporter.h"
+#include "internal/qpykernelsmodule.h"
+#include "internal/qpyringbuffermodule.h"
+#include "internal/qpytablemodule.h"
 
 static_assert(PYBIND11_VERSION_HEX >= 0x020D0500, "Wrong/old pybind11 headers");
 
@@ -50,6 +54,11 @@ namespace qtpyt {
 
             m.def("invoke_mt", &invoke_returning_from_args_mt, py::arg("obj_ptr"), py::arg("method"));
 
+            addChangeTrackingFunctions(m);
+            addKernelsModule(m);
+            addRingBufferType(m);
+            addTableType(m);
+
         }
 
     } // namespace
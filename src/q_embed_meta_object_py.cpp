@@ -14,7 +14,6 @@
 #include "conversions.h"
 #include "conversions.h"
 #include "../../Qt/6.10.1/gcc_64/include/QtCore/QVariant"
-#include "internal/q_py_queue.h"
 
 class QObject;
 namespace qtpyt {
@@ -0,0 +1,301 @@
+#include <qtpyt/qpybufferpool.h>
+#include <qtpyt/qpysharedarray.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace qtpyt {
+namespace {
+
+    // Buffers: power-of-two classes from 256 B to 64 MiB, preceded by a 64-byte header so the
+    // payload stays cache-line aligned.
+    constexpr int kMinClassShift = 8;
+    constexpr int kMaxClassShift = 26;
+    constexpr int kBufferClasses = kMaxClassShift - kMinClassShift + 1;
+    constexpr std::size_t kHeaderBytes = 64;
+    constexpr std::align_val_t kBlockAlign{64};
+    constexpr int kThreadCacheDepth = 8;
+    constexpr int kLargeClassShift = 20;       // classes above 1 MiB keep fewer blocks per thread
+    constexpr int kLargeThreadCacheDepth = 2;
+
+    // Bookkeeping blocks: 16-byte steps up to 256 B.
+    constexpr std::size_t kSmallStep = 16;
+    constexpr int kSmallClasses = 16;
+    constexpr int kSmallListLimit = 1024;
+
+    struct BlockHeader {
+        int sizeClass;
+    };
+
+    std::atomic<bool> g_enabled{false};
+    std::atomic<qint64> g_maxDepotBytes{qint64(256) << 20};
+    std::atomic<qint64> g_depotBytes{0};
+
+    std::atomic<quint64> g_hits{0};
+    std::atomic<quint64> g_misses{0};
+    std::atomic<quint64> g_recycled{0};
+    std::atomic<quint64> g_freed{0};
+    std::atomic<quint64> g_smallHits{0};
+    std::atomic<quint64> g_smallMisses{0};
+
+    inline void bump(std::atomic<quint64>& counter) { counter.fetch_add(1, std::memory_order_relaxed); }
+
+    constexpr qint64 classBytes(int cls) { return qint64(1) << (cls + kMinClassShift); }
+    constexpr int threadDepth(int cls) {
+        return cls + kMinClassShift > kLargeClassShift ? kLargeThreadCacheDepth : kThreadCacheDepth;
+    }
+
+    int classFor(qint64 bytes) {
+        int shift = kMinClassShift;
+        while ((qint64(1) << shift) < bytes)
+            ++shift;
+        return shift - kMinClassShift;
+    }
+
+    BlockHeader* headerOf(void* payload) {
+        return reinterpret_cast<BlockHeader*>(static_cast<char*>(payload) - kHeaderBytes);
+    }
+
+    void* allocateBlock(int cls) {
+        auto* base = static_cast<char*>(::operator new(kHeaderBytes + size_t(classBytes(cls)), kBlockAlign));
+        reinterpret_cast<BlockHeader*>(base)->sizeClass = cls;
+        return base + kHeaderBytes;
+    }
+
+    void freeBlock(void* payload) {
+        ::operator delete(headerOf(payload), kBlockAlign);
+    }
+
+    struct Depot {
+        std::mutex mutex;
+        std::array<std::vector<void*>, kBufferClasses> blocks;
+
+        bool push(void* payload, int cls) {
+            const qint64 bytes = classBytes(cls);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (g_depotBytes.load(std::memory_order_relaxed) + bytes > g_maxDepotBytes.load(std::memory_order_relaxed))
+                return false;
+            blocks[size_t(cls)].push_back(payload);
+            g_depotBytes.fetch_add(bytes, std::memory_order_relaxed);
+            return true;
+        }
+
+        void* pop(int cls) {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto& v = blocks[size_t(cls)];
+            if (v.empty())
+                return nullptr;
+            void* payload = v.back();
+            v.pop_back();
+            g_depotBytes.fetch_sub(classBytes(cls), std::memory_order_relaxed);
+            return payload;
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int cls = 0; cls < kBufferClasses; ++cls) {
+                for (void* payload : blocks[size_t(cls)])
+                    freeBlock(payload);
+                g_depotBytes.fetch_sub(classBytes(cls) * qint64(blocks[size_t(cls)].size()),
+                                       std::memory_order_relaxed);
+                blocks[size_t(cls)].clear();
+            }
+        }
+    };
+
+    Depot& depot() {
+        // Intentionally leaked: buffers may be released by static destructors of other units.
+        static Depot* d = new Depot;
+        return *d;
+    }
+
+    struct SmallNode {
+        SmallNode* next;
+    };
+
+    enum class CacheState : unsigned char { Unused, Alive, Destroyed };
+    thread_local CacheState t_cacheState = CacheState::Unused;
+
+    struct ThreadCache {
+        struct Slots {
+            std::array<void*, kThreadCacheDepth> items{};
+            int count = 0;
+        };
+        std::array<Slots, kBufferClasses> buffers;
+        std::array<SmallNode*, kSmallClasses> small{};
+        std::array<int, kSmallClasses> smallCount{};
+
+        ThreadCache() { t_cacheState = CacheState::Alive; }
+
+        ~ThreadCache() {
+            t_cacheState = CacheState::Destroyed;
+            releaseBuffers(/*toDepot*/true);
+            releaseSmall();
+        }
+
+        void releaseBuffers(bool toDepot) {
+            for (int cls = 0; cls < kBufferClasses; ++cls) {
+                auto& s = buffers[size_t(cls)];
+                for (int i = 0; i < s.count; ++i) {
+                    void* payload = s.items[size_t(i)];
+                    if (!toDepot || !depot().push(payload, cls))
+                        freeBlock(payload);
+                }
+                s.count = 0;
+            }
+        }
+
+        void releaseSmall() {
+            for (int cls = 0; cls < kSmallClasses; ++cls) {
+                while (SmallNode* n = small[size_t(cls)]) {
+                    small[size_t(cls)] = n->next;
+                    ::operator delete(n);
+                }
+                smallCount[size_t(cls)] = 0;
+            }
+        }
+    };
+
+    ThreadCache* threadCache() {
+        // After the cache of an exiting thread is gone, fall back to the heap.
+        if (t_cacheState == CacheState::Destroyed)
+            return nullptr;
+        thread_local ThreadCache cache;
+        return &cache;
+    }
+
+    void releasePooledBlock(void* payload) {
+        const int cls = headerOf(payload)->sizeClass;
+        if (g_enabled.load(std::memory_order_relaxed)) {
+            if (ThreadCache* c = threadCache()) {
+                auto& s = c->buffers[size_t(cls)];
+                if (s.count < threadDepth(cls)) {
+                    s.items[size_t(s.count++)] = payload;
+                    bump(g_recycled);
+                    return;
+                }
+            }
+            if (depot().push(payload, cls)) {
+                bump(g_recycled);
+                return;
+            }
+        }
+        bump(g_freed);
+        freeBlock(payload);
+    }
+
+} // namespace
+
+void QPyBufferPool::setEnabled(bool enabled) {
+    g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool QPyBufferPool::isEnabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void QPyBufferPool::setMaxDepotBytes(qint64 bytes) {
+    g_maxDepotBytes.store(std::max<qint64>(bytes, 0), std::memory_order_relaxed);
+}
+
+qint64 QPyBufferPool::maxPooledBytes() {
+    return classBytes(kBufferClasses - 1);
+}
+
+qint64 QPyBufferPool::sizeClassBytes(qint64 bytes) {
+    if (bytes > maxPooledBytes())
+        return bytes;
+    return classBytes(classFor(bytes));
+}
+
+QPyBufferPoolStats QPyBufferPool::stats() {
+    QPyBufferPoolStats s;
+    s.hits = g_hits.load(std::memory_order_relaxed);
+    s.misses = g_misses.load(std::memory_order_relaxed);
+    s.recycled = g_recycled.load(std::memory_order_relaxed);
+    s.freed = g_freed.load(std::memory_order_relaxed);
+    s.smallHits = g_smallHits.load(std::memory_order_relaxed);
+    s.smallMisses = g_smallMisses.load(std::memory_order_relaxed);
+    s.depotBytes = g_depotBytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+void QPyBufferPool::resetStats() {
+    for (auto* c : {&g_hits, &g_misses, &g_recycled, &g_freed, &g_smallHits, &g_smallMisses})
+        c->store(0, std::memory_order_relaxed);
+}
+
+void QPyBufferPool::trim() {
+    if (ThreadCache* c = threadCache()) {
+        c->releaseBuffers(/*toDepot*/false);
+        c->releaseSmall();
+    }
+    depot().clear();
+}
+
+namespace detail {
+
+    std::shared_ptr<OwnerState> acquirePooledBuffer(qint64 bytes, void** outPtr, qint64* outCapacity) {
+        if (!g_enabled.load(std::memory_order_relaxed) || bytes > QPyBufferPool::maxPooledBytes())
+            return {};
+        const int cls = classFor(bytes);
+        void* payload = nullptr;
+        if (ThreadCache* c = threadCache()) {
+            auto& s = c->buffers[size_t(cls)];
+            if (s.count > 0)
+                payload = s.items[size_t(--s.count)];
+        }
+        if (!payload)
+            payload = depot().pop(cls);
+        if (payload) {
+            bump(g_hits);
+        } else {
+            bump(g_misses);
+            payload = allocateBlock(cls);
+        }
+        *outPtr = payload;
+        *outCapacity = classBytes(cls);
+        return std::allocate_shared<OwnerState>(PoolAllocator<OwnerState>(), payload, &releasePooledBlock);
+    }
+
+    void* poolAllocateSmall(std::size_t bytes) {
+        const std::size_t cls = (bytes + kSmallStep - 1) / kSmallStep;
+        if (cls == 0 || cls > kSmallClasses)
+            return ::operator new(bytes);
+        // Disabled: plain heap, rounded to the class so poolFreeSmall() may still recycle it.
+        if (!g_enabled.load(std::memory_order_relaxed))
+            return ::operator new(cls * kSmallStep);
+        if (ThreadCache* c = threadCache()) {
+            if (SmallNode* n = c->small[cls - 1]) {
+                c->small[cls - 1] = n->next;
+                --c->smallCount[cls - 1];
+                bump(g_smallHits);
+                return n;
+            }
+        }
+        bump(g_smallMisses);
+        return ::operator new(cls * kSmallStep);
+    }
+
+    void poolFreeSmall(void* p, std::size_t bytes) noexcept {
+        if (!p)
+            return;
+        const std::size_t cls = (bytes + kSmallStep - 1) / kSmallStep;
+        if (cls > 0 && cls <= kSmallClasses && g_enabled.load(std::memory_order_relaxed)) {
+            if (ThreadCache* c = threadCache(); c && c->smallCount[cls - 1] < kSmallListLimit) {
+                auto* n = static_cast<SmallNode*>(p);
+                n->next = c->small[cls - 1];
+                c->small[cls - 1] = n;
+                ++c->smallCount[cls - 1];
+                return;
+            }
+        }
+        ::operator delete(p);
+    }
+
+} // namespace detail
+} // namespace qtpyt
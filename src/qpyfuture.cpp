@@ -5,15 +5,52 @@
 
 #include "internal/q_py_future_impl.h"
 
+#include <qtpyt/qpythreadpool.h>
+
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QPointer>
+#include <QPromise>
+#include <QThread>
+
+#include <atomic>
+
 namespace qtpyt {
+    namespace {
+        QByteArray typeNameOf(const QPyRegisteredType& type) {
+            if (std::holds_alternative<QMetaType>(type)) {
+                return std::get<QMetaType>(type).name();
+            }
+            if (std::holds_alternative<QString>(type)) {
+                return std::get<QString>(type).toUtf8();
+            }
+            return QMetaType(std::get<QMetaType::Type>(type)).name();
+        }
+
+        // Run fn here, or on the thread of context if one was given (and is still alive then).
+        void dispatch(const QPointer<QObject>& context, bool hasContext, std::function<void()> fn) {
+            if (!hasContext) {
+                fn();
+                return;
+            }
+            if (QObject* target = context.data()) {
+                QMetaObject::invokeMethod(target, std::move(fn), Qt::QueuedConnection);
+            }
+        }
+    } // namespace
+
+    QPyFuture::QPyFuture(std::shared_ptr<QPyFutureImpl> impl) : m_impl(std::move(impl)) {}
+
     QPyFuture::QPyFuture(QPyModule module, QSharedPointer<IQPyFutureNotifier> notifier, const QString& functionName, const QByteArray& returnType,
-                         QVariantList&& arguments) {
+                         QVariantList&& arguments, const QPyCallOptions& options) {
         m_impl = std::make_shared<QPyFutureImpl>(std::move(module), std::move(notifier), functionName, returnType, std::move(arguments));
+        m_impl->setOptions(options);
     }
 
     QPyFuture::QPyFuture(QPyModule module, QSharedPointer<IQPyFutureNotifier> notifier, QString functionName, const QByteArray& returnType,
-        const QVector<int>& types,  void** a) {
+        const QVector<int>& types,  void** a, const QPyCallOptions& options) {
         m_impl = std::make_shared<::QPyFutureImpl>(std::move(module), std::move(notifier), std::move(functionName), returnType, types, a);
+        m_impl->setOptions(options);
     }
 
     QPyFuture::QPyFuture(const QPyFuture& other) {
@@ -28,13 +65,148 @@ namespace qtpyt {
     }
 
     void QPyFuture::waitForFinished() const {
-        while (true) {
-            const QPyFutureState s = this->state();
-            if (s == QPyFutureState::Finished || s == QPyFutureState::Error || s == QPyFutureState::Canceled) {
+        if (m_impl->isCompleted()) {
+            return;
+        }
+        const QCoreApplication* app = QCoreApplication::instance();
+        if (app == nullptr || QThread::currentThread() != app->thread()) {
+            m_impl->wait();
+            return;
+        }
+        // On the GUI thread keep serving events (queued notifier signals, blocking calls from
+        // Python into Qt objects) and leave the local loop as soon as the call completes.
+        QEventLoop loop;
+        m_impl->onComplete([&loop] {
+            QMetaObject::invokeMethod(&loop, &QEventLoop::quit, Qt::QueuedConnection);
+        });
+        loop.exec();
+    }
+
+    QFuture<QVariant> QPyFuture::toQFuture() const {
+        auto promise = std::make_shared<QPromise<QVariant>>();
+        QFuture<QVariant> future = promise->future();
+        promise->start();
+        QPyFutureImpl* impl = m_impl.get();   // the continuation is run by the impl itself
+        m_impl->onComplete([promise, impl] {
+            switch (impl->state()) {
+            case QPyFutureState::Finished:
+                if (impl->resultCount() > 0) {
+                    promise->addResult(impl->resultAsVariant(0));
+                }
+                break;
+            case QPyFutureState::Canceled:
+            case QPyFutureState::TimedOut:
+                promise->future().cancel();
+                break;
+            default:
+                promise->setException(std::make_exception_ptr(std::runtime_error(impl->errorMessage().toStdString())));
                 break;
             }
-            QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
-            QThread::msleep(1);
+            promise->finish();
+        });
+        return future;
+    }
+
+    QPyFuture QPyFuture::then(const QPyModule& module, const QString& functionName, const QPyRegisteredType& returnType,
+                              QSharedPointer<IQPyFutureNotifier> notifier) const {
+        QPyFuture stage(module, std::move(notifier), functionName, typeNameOf(returnType), QVariantList{}, m_impl->options());
+        if (m_impl->chain(stage.m_impl)) {
+            return stage;
+        }
+        // already completed: run the stage on the pool like any other call
+        if (m_impl->state() == QPyFutureState::Finished) {
+            stage.m_impl->takeInputFrom(*m_impl);
+            QPyThreadPool::instance().submit(stage);
+        } else {
+            stage.m_impl->skipAfter(*m_impl);
+        }
+        return stage;
+    }
+
+    QPyFuture QPyFuture::then(const QString& functionName, const QPyRegisteredType& returnType,
+                              QSharedPointer<IQPyFutureNotifier> notifier) const {
+        return then(*m_impl->modulePtr(), functionName, returnType, std::move(notifier));
+    }
+
+    const QPyFuture& QPyFuture::then(std::function<void(const QPyFuture&)> fn, QObject* context) const {
+        QPyFutureImpl* impl = m_impl.get();   // run by the impl itself, see toQFuture()
+        m_impl->onComplete([impl, fn = std::move(fn), target = QPointer<QObject>(context), hasContext = context != nullptr] {
+            dispatch(target, hasContext, [self = QPyFuture(impl->shared_from_this()), fn] {
+                fn(self);
+            });
+        });
+        return *this;
+    }
+
+    const QPyFuture& QPyFuture::onFailed(std::function<void(const QString&)> fn, QObject* context) const {
+        QPyFutureImpl* impl = m_impl.get();
+        m_impl->onComplete([impl, fn = std::move(fn), target = QPointer<QObject>(context), hasContext = context != nullptr] {
+            const auto state = impl->state();
+            if (state != QPyFutureState::Error && state != QPyFutureState::TimedOut) {
+                return;
+            }
+            dispatch(target, hasContext, [message = impl->errorMessage(), fn] {
+                fn(message);
+            });
+        });
+        return *this;
+    }
+
+    void QPyFuture::whenAll(const QList<QPyFuture>& futures, std::function<void(const QList<QPyFuture>&)> fn,
+                            QObject* context) {
+        struct State {
+            std::atomic<qsizetype> remaining{0};
+            QList<QPyFuture> futures;
+            std::function<void(const QList<QPyFuture>&)> fn;
+            QPointer<QObject> target;
+            bool hasContext = false;
+        };
+        auto state = std::make_shared<State>();
+        state->remaining.store(futures.size(), std::memory_order_relaxed);
+        state->futures = futures;
+        state->fn = std::move(fn);
+        state->target = context;
+        state->hasContext = context != nullptr;
+        const auto fire = [](const std::shared_ptr<State>& s) {
+            dispatch(s->target, s->hasContext, [s] {
+                s->fn(s->futures);
+            });
+        };
+        if (futures.isEmpty()) {
+            fire(state);
+            return;
+        }
+        for (const auto& future : futures) {
+            future.m_impl->onComplete([state, fire] {
+                if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    fire(state);
+                }
+            });
+        }
+    }
+
+    void QPyFuture::whenAny(const QList<QPyFuture>& futures, std::function<void(const QPyFuture&)> fn,
+                            QObject* context) {
+        struct State {
+            std::atomic<bool> fired{false};
+            std::function<void(const QPyFuture&)> fn;
+            QPointer<QObject> target;
+            bool hasContext = false;
+        };
+        auto state = std::make_shared<State>();
+        state->fn = std::move(fn);
+        state->target = context;
+        state->hasContext = context != nullptr;
+        for (const auto& future : futures) {
+            QPyFutureImpl* impl = future.m_impl.get();
+            future.m_impl->onComplete([state, impl] {
+                if (state->fired.exchange(true, std::memory_order_acq_rel)) {
+                    return;
+                }
+                dispatch(state->target, state->hasContext, [state, self = QPyFuture(impl->shared_from_this())] {
+                    state->fn(self);
+                });
+            });
         }
     }
 
@@ -61,17 +233,49 @@ namespace qtpyt {
         return m_impl->resultAsVariant(index);
     }
 
+    std::optional<QVariant> QPyFuture::takeResult() const {
+        return m_impl->takeResult();
+    }
+
+    std::optional<QVariant> QPyFuture::waitForResult() const {
+        return m_impl->waitForResult();
+    }
+
     QPyFutureState QPyFuture::state() const {
         return m_impl->state();
     }
 
+    bool QPyFuture::isCompleted() const {
+        return m_impl->isCompleted();
+    }
+
+    bool QPyFuture::cancel() {
+        return m_impl->cancel();
+    }
+
     QPyModule* QPyFuture::callablePtr() const {
         return m_impl->modulePtr();
     }
 
+    quintptr QPyFuture::moduleId() const {
+        return m_impl->modulePtr()->moduleId();
+    }
+
     QString QPyFuture::errorMessage() const {
         return m_impl->errorMessage();
     }
+
+    const QPyCallOptions& QPyFuture::options() const {
+        return m_impl->options();
+    }
+
+    std::chrono::steady_clock::time_point QPyFuture::createdAt() const {
+        return m_impl->createdAt();
+    }
+
+    std::optional<std::chrono::steady_clock::time_point> QPyFuture::deadline() const {
+        return m_impl->deadline();
+    }
 } // namespace qtpyt
 
 
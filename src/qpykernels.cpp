@@ -0,0 +1,533 @@
+#include <qtpyt/qpykernels.h>
+
+#include <QThreadPool>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+// Every kernel is a plain loop written so that the compiler can vectorize it. The loop is
+// force-inlined into one wrapper per instruction set (target attributes), so a single
+// translation unit carries AVX-512, AVX2 and baseline code and no special build flags are needed.
+#if defined(__GNUC__) || defined(__clang__)
+#define QTPYT_ALWAYS_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define QTPYT_ALWAYS_INLINE __forceinline
+#else
+#define QTPYT_ALWAYS_INLINE inline
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define QTPYT_KERNELS_X86 1
+#define QTPYT_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define QTPYT_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl")))
+#endif
+
+namespace qtpyt {
+namespace kernels {
+namespace {
+
+    // ---- dispatch state -----------------------------------------------------------------
+
+    QPySimdLevel detect() {
+#if defined(QTPYT_KERNELS_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+            __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl"))
+            return QPySimdLevel::Avx512;
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+            return QPySimdLevel::Avx2;
+        return QPySimdLevel::Scalar;
+#elif defined(__aarch64__) || defined(_M_ARM64)
+        return QPySimdLevel::Neon;   // Advanced SIMD is part of the AArch64 baseline
+#else
+        return QPySimdLevel::Scalar;
+#endif
+    }
+
+    QPySimdLevel detected() {
+        static const QPySimdLevel level = detect();
+        return level;
+    }
+
+    std::atomic<int> g_level{-1};
+    std::atomic<int> g_maxThreads{0};
+    std::atomic<qsizetype> g_parallelThreshold{qsizetype(256) * 1024};
+    constexpr qsizetype kMinChunk = 64 * 1024;   // elements per partition
+    constexpr qsizetype kChunkAlign = 64;
+
+    QPySimdLevel level() {
+        const int forced = g_level.load(std::memory_order_relaxed);
+        return forced < 0 ? detected() : QPySimdLevel(forced);
+    }
+
+#if defined(QTPYT_KERNELS_X86)
+#define QTPYT_MULTIVERSION(name)                                                                  \
+    template <typename... A> QTPYT_TARGET_AVX512 void name##Avx512(A... a) { name(a...); }       \
+    template <typename... A> QTPYT_TARGET_AVX2 void name##Avx2(A... a) { name(a...); }           \
+    template <typename... A> void name##Base(A... a) { name(a...); }                              \
+    template <typename... A> void name##Dispatch(A... a) {                                        \
+        switch (level()) {                                                                        \
+        case QPySimdLevel::Avx512: name##Avx512(a...); return;                                    \
+        case QPySimdLevel::Avx2: name##Avx2(a...); return;                                        \
+        default: name##Base(a...); return;                                                        \
+        }                                                                                         \
+    }
+#else
+#define QTPYT_MULTIVERSION(name)                                                                  \
+    template <typename... A> void name##Dispatch(A... a) { name(a...); }
+#endif
+
+    // ---- partitioning -------------------------------------------------------------------
+
+    int partitionsFor(qsizetype n) {
+        if (n < g_parallelThreshold.load(std::memory_order_relaxed))
+            return 1;
+        int threads = g_maxThreads.load(std::memory_order_relaxed);
+        if (threads <= 0)
+            threads = QThreadPool::globalInstance()->maxThreadCount() + 1;
+        return int(std::max<qsizetype>(1, std::min<qsizetype>(threads, n / kMinChunk)));
+    }
+
+    struct Partition {
+        qsizetype begin;
+        qsizetype end;
+    };
+
+    Partition partition(qsizetype n, int parts, int index) {
+        qsizetype chunk = (n + parts - 1) / parts;
+        chunk = (chunk + kChunkAlign - 1) / kChunkAlign * kChunkAlign;
+        const qsizetype begin = std::min(n, chunk * index);
+        return {begin, std::min(n, begin + chunk)};
+    }
+
+    struct ParallelJob {
+        std::function<void(qsizetype, qsizetype, int)> body;
+        qsizetype n = 0;
+        int parts = 0;
+        std::atomic<int> next{0};
+        std::atomic<int> done{0};
+
+        void runAvailable() {
+            for (int index = next.fetch_add(1, std::memory_order_relaxed); index < parts;
+                 index = next.fetch_add(1, std::memory_order_relaxed)) {
+                const Partition p = partition(n, parts, index);
+                body(p.begin, p.end, index);
+                if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == parts)
+                    done.notify_all();
+            }
+        }
+    };
+
+    // Runs body(begin, end, index) for \p parts partitions of [0, n). The caller claims
+    // partitions too, so the call completes even if no pool thread becomes available; helpers
+    // that start late find nothing left and never touch the (possibly gone) caller frame.
+    void forEachPartition(qsizetype n, int parts, std::function<void(qsizetype, qsizetype, int)> body) {
+        if (parts <= 1) {
+            body(0, n, 0);
+            return;
+        }
+        auto job = std::make_shared<ParallelJob>();
+        job->body = std::move(body);
+        job->n = n;
+        job->parts = parts;
+        for (int i = 1; i < parts; ++i)
+            QThreadPool::globalInstance()->start([job] { job->runAvailable(); });
+        job->runAvailable();
+        for (int d = job->done.load(std::memory_order_acquire); d < parts; d = job->done.load(std::memory_order_acquire))
+            job->done.wait(d, std::memory_order_acquire);
+    }
+
+    // ---- element operations -------------------------------------------------------------
+
+    template <typename T, bool = std::is_integral_v<T>>
+    struct WrapType { using type = T; };
+    template <typename T>
+    struct WrapType<T, true> { using type = std::make_unsigned_t<T>; };
+
+    // Integers are accumulated in the unsigned type of the same width, so overflow wraps.
+    template <typename T>
+    using Wrap = typename WrapType<T>::type;
+
+    template <typename T>
+    QTPYT_ALWAYS_INLINE T applyOp(QPyKernelOp op, T x, T y) {
+        // Integer arithmetic wraps instead of overflowing.
+        switch (op) {
+        case QPyKernelOp::Add: return T(Wrap<T>(x) + Wrap<T>(y));
+        case QPyKernelOp::Sub: return T(Wrap<T>(x) - Wrap<T>(y));
+        case QPyKernelOp::Mul: return T(Wrap<T>(x) * Wrap<T>(y));
+        case QPyKernelOp::Div:
+            if constexpr (std::is_integral_v<T>) {
+                if (y == 0)
+                    return T(0);
+                if constexpr (std::is_signed_v<T>) {
+                    if (y == T(-1))
+                        return T(Wrap<T>(0) - Wrap<T>(x));
+                }
+            }
+            return T(x / y);
+        case QPyKernelOp::Min: return y < x ? y : x;
+        case QPyKernelOp::Max: return x < y ? y : x;
+        }
+        return x;
+    }
+
+    // The operation is a template parameter so that each loop body is branch-free.
+    template <QPyKernelOp Op, typename T>
+    QTPYT_ALWAYS_INLINE void binaryLoop(const T* a, const T* b, T* out, qsizetype n) {
+        for (qsizetype i = 0; i < n; ++i)
+            out[i] = applyOp(Op, a[i], b[i]);
+    }
+
+    template <QPyKernelOp Op, typename T>
+    QTPYT_ALWAYS_INLINE void scalarLoop(const T* a, T s, T* out, qsizetype n) {
+        for (qsizetype i = 0; i < n; ++i)
+            out[i] = applyOp(Op, a[i], s);
+    }
+
+    template <typename T>
+    QTPYT_ALWAYS_INLINE void binaryAny(QPyKernelOp op, const T* a, const T* b, T* out, qsizetype n) {
+        switch (op) {
+        case QPyKernelOp::Add: binaryLoop<QPyKernelOp::Add>(a, b, out, n); break;
+        case QPyKernelOp::Sub: binaryLoop<QPyKernelOp::Sub>(a, b, out, n); break;
+        case QPyKernelOp::Mul: binaryLoop<QPyKernelOp::Mul>(a, b, out, n); break;
+        case QPyKernelOp::Div: binaryLoop<QPyKernelOp::Div>(a, b, out, n); break;
+        case QPyKernelOp::Min: binaryLoop<QPyKernelOp::Min>(a, b, out, n); break;
+        case QPyKernelOp::Max: binaryLoop<QPyKernelOp::Max>(a, b, out, n); break;
+        }
+    }
+
+    template <typename T>
+    QTPYT_ALWAYS_INLINE void scalarAny(QPyKernelOp op, const T* a, T s, T* out, qsizetype n) {
+        switch (op) {
+        case QPyKernelOp::Add: scalarLoop<QPyKernelOp::Add>(a, s, out, n); break;
+        case QPyKernelOp::Sub: scalarLoop<QPyKernelOp::Sub>(a, s, out, n); break;
+        case QPyKernelOp::Mul: scalarLoop<QPyKernelOp::Mul>(a, s, out, n); break;
+        case QPyKernelOp::Div: scalarLoop<QPyKernelOp::Div>(a, s, out, n); break;
+        case QPyKernelOp::Min: scalarLoop<QPyKernelOp::Min>(a, s, out, n); break;
+        case QPyKernelOp::Max: scalarLoop<QPyKernelOp::Max>(a, s, out, n); break;
+        }
+    }
+
+    // Reductions keep independent lanes so the vectorizer needs no reassociation.
+    constexpr int kLanes = 16;
+
+    template <typename T>
+    QTPYT_ALWAYS_INLINE void sumLoop(const T* a, qsizetype n, double* result) {
+        using Acc = std::conditional_t<std::is_integral_v<T>, quint64, double>;
+        Acc acc[kLanes] = {};
+        qsizetype i = 0;
+        for (; i + kLanes <= n; i += kLanes)
+            for (int j = 0; j < kLanes; ++j)
+                acc[j] += Acc(a[i + j]);
+        for (; i < n; ++i)
+            acc[0] += Acc(a[i]);
+        for (int width = kLanes / 2; width > 0; width /= 2)
+            for (int j = 0; j < width; ++j)
+                acc[j] += acc[j + width];
+        if constexpr (std::is_integral_v<T>)
+            *result = double(qint64(acc[0]));
+        else
+            *result = acc[0];
+    }
+
+    template <typename T>
+    QTPYT_ALWAYS_INLINE void minMaxLoop(const T* a, qsizetype n, T* lo, T* hi) {
+        T mins[kLanes];
+        T maxs[kLanes];
+        for (int j = 0; j < kLanes; ++j) {
+            mins[j] = std::numeric_limits<T>::max();
+            maxs[j] = std::numeric_limits<T>::lowest();
+        }
+        qsizetype i = 0;
+        for (; i + kLanes <= n; i += kLanes) {
+            for (int j = 0; j < kLanes; ++j) {
+                const T x = a[i + j];
+                mins[j] = x < mins[j] ? x : mins[j];
+                maxs[j] = maxs[j] < x ? x : maxs[j];
+            }
+        }
+        for (; i < n; ++i) {
+            mins[0] = a[i] < mins[0] ? a[i] : mins[0];
+            maxs[0] = maxs[0] < a[i] ? a[i] : maxs[0];
+        }
+        for (int j = 1; j < kLanes; ++j) {
+            mins[0] = mins[j] < mins[0] ? mins[j] : mins[0];
+            maxs[0] = maxs[0] < maxs[j] ? maxs[j] : maxs[0];
+        }
+        *lo = mins[0];
+        *hi = maxs[0];
+    }
+
+    template <typename T>
+    QTPYT_ALWAYS_INLINE void squaredDeviationLoop(const T* a, qsizetype n, double mean, double* result) {
+        double acc[kLanes] = {};
+        qsizetype i = 0;
+        for (; i + kLanes <= n; i += kLanes) {
+            for (int j = 0; j < kLanes; ++j) {
+                const double d = double(a[i + j]) - mean;
+                acc[j] += d * d;
+            }
+        }
+        for (; i < n; ++i) {
+            const double d = double(a[i]) - mean;
+            acc[0] += d * d;
+        }
+        for (int width = kLanes / 2; width > 0; width /= 2)
+            for (int j = 0; j < width; ++j)
+                acc[j] += acc[j + width];
+        *result = acc[0];
+    }
+
+    template <typename T>
+    QTPYT_ALWAYS_INLINE void clampLoop(T* a, qsizetype n, T lo, T hi) {
+        for (qsizetype i = 0; i < n; ++i) {
+            const T x = a[i];
+            a[i] = x < lo ? lo : (hi < x ? hi : x);
+        }
+    }
+
+    template <typename To, typename Calc>
+    QTPYT_ALWAYS_INLINE To saturate(Calc v) {
+        if constexpr (std::is_integral_v<To>) {
+            if constexpr (std::is_floating_point_v<Calc>) {
+                constexpr Calc lo = Calc(std::numeric_limits<To>::lowest());
+                constexpr Calc hi = Calc(std::numeric_limits<To>::max());
+                if (!(v == v))
+                    return To(0);
+                if (v <= lo)
+                    return std::numeric_limits<To>::lowest();
+                if (v >= hi)
+                    return std::numeric_limits<To>::max();
+                return To(v);
+            } else {
+                // every supported integer type fits into qint64
+                const qint64 x = qint64(v);
+                constexpr qint64 lo = qint64(std::numeric_limits<To>::lowest());
+                constexpr qint64 hi = qint64(std::numeric_limits<To>::max());
+                return To(x < lo ? lo : (x > hi ? hi : x));
+            }
+        } else {
+            return To(v);
+        }
+    }
+
+    template <typename From, typename To>
+    QTPYT_ALWAYS_INLINE void convertLoop(const From* src, To* dst, qsizetype n, double scale, double offset) {
+        if (scale == 1.0 && offset == 0.0) {
+            for (qsizetype i = 0; i < n; ++i)
+                dst[i] = saturate<To>(src[i]);
+            return;
+        }
+        // 8-bit <-> float32 is the hot path for image data; keep it in single precision.
+        using Calc = std::conditional_t<(std::is_same_v<From, quint8> || std::is_same_v<From, float>) &&
+                                        (std::is_same_v<To, quint8> || std::is_same_v<To, float>), float, double>;
+        const Calc s = Calc(scale);
+        const Calc o = Calc(offset);
+        for (qsizetype i = 0; i < n; ++i)
+            dst[i] = saturate<To>(Calc(src[i]) * s + o);
+    }
+
+    QTPYT_MULTIVERSION(binaryAny)
+    QTPYT_MULTIVERSION(scalarAny)
+    QTPYT_MULTIVERSION(sumLoop)
+    QTPYT_MULTIVERSION(minMaxLoop)
+    QTPYT_MULTIVERSION(squaredDeviationLoop)
+    QTPYT_MULTIVERSION(clampLoop)
+    QTPYT_MULTIVERSION(convertLoop)
+
+    struct PartialMoments {
+        qsizetype count = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+    };
+
+} // namespace
+
+// ---- configuration ----------------------------------------------------------------------
+
+QPySimdLevel detectedSimdLevel() {
+    return detected();
+}
+
+QPySimdLevel simdLevel() {
+    return level();
+}
+
+void setSimdLevel(QPySimdLevel requested) {
+    g_level.store(int(std::min(requested, detected())), std::memory_order_relaxed);
+}
+
+const char* simdLevelName(QPySimdLevel l) {
+    switch (l) {
+    case QPySimdLevel::Scalar: return "scalar";
+    case QPySimdLevel::Neon: return "neon";
+    case QPySimdLevel::Avx2: return "avx2";
+    case QPySimdLevel::Avx512: return "avx512";
+    }
+    return "scalar";
+}
+
+void setMaxThreads(int threads) {
+    g_maxThreads.store(threads, std::memory_order_relaxed);
+}
+
+int maxThreads() {
+    const int threads = g_maxThreads.load(std::memory_order_relaxed);
+    return threads > 0 ? threads : QThreadPool::globalInstance()->maxThreadCount() + 1;
+}
+
+void setParallelThreshold(qsizetype elements) {
+    g_parallelThreshold.store(std::max<qsizetype>(elements, 1), std::memory_order_relaxed);
+}
+
+qsizetype parallelThreshold() {
+    return g_parallelThreshold.load(std::memory_order_relaxed);
+}
+
+// ---- kernels ----------------------------------------------------------------------------
+
+template <typename T>
+void binary(QPyKernelOp op, const T* a, const T* b, T* out, qsizetype n) {
+    forEachPartition(n, partitionsFor(n), [=](qsizetype begin, qsizetype end, int) {
+        binaryAnyDispatch(op, a + begin, b + begin, out + begin, end - begin);
+    });
+}
+
+template <typename T>
+void binaryScalar(QPyKernelOp op, const T* a, T s, T* out, qsizetype n) {
+    forEachPartition(n, partitionsFor(n), [=](qsizetype begin, qsizetype end, int) {
+        scalarAnyDispatch(op, a + begin, s, out + begin, end - begin);
+    });
+}
+
+template <typename T>
+double sum(const T* a, qsizetype n) {
+    const int parts = partitionsFor(n);
+    std::vector<double> partial(static_cast<size_t>(parts), 0.0);
+    forEachPartition(n, parts, [&](qsizetype begin, qsizetype end, int index) {
+        sumLoopDispatch(a + begin, end - begin, &partial[size_t(index)]);
+    });
+    double total = 0.0;
+    for (double p : partial)
+        total += p;
+    return total;
+}
+
+template <typename T>
+std::pair<T, T> minMax(const T* a, qsizetype n) {
+    if (n <= 0)
+        throw std::invalid_argument("qtpyt::kernels::minMax: empty array");
+    const int parts = partitionsFor(n);
+    std::vector<std::pair<T, T>> partial(static_cast<size_t>(parts));
+    forEachPartition(n, parts, [&](qsizetype begin, qsizetype end, int index) {
+        auto& p = partial[size_t(index)];
+        minMaxLoopDispatch(a + begin, end - begin, &p.first, &p.second);
+    });
+    std::pair<T, T> result = partial.front();
+    for (const auto& p : partial) {
+        result.first = p.first < result.first ? p.first : result.first;
+        result.second = result.second < p.second ? p.second : result.second;
+    }
+    return result;
+}
+
+template <typename T>
+QPyMoments moments(const T* a, qsizetype n) {
+    if (n <= 0)
+        throw std::invalid_argument("qtpyt::kernels::moments: empty array");
+    const int parts = partitionsFor(n);
+    std::vector<PartialMoments> partial(static_cast<size_t>(parts));
+    forEachPartition(n, parts, [&](qsizetype begin, qsizetype end, int index) {
+        PartialMoments& p = partial[size_t(index)];
+        p.count = end - begin;
+        if (p.count == 0)
+            return;
+        double s = 0.0;
+        sumLoopDispatch(a + begin, p.count, &s);
+        p.mean = s / double(p.count);
+        squaredDeviationLoopDispatch(a + begin, p.count, p.mean, &p.m2);
+    });
+    PartialMoments total;
+    for (const PartialMoments& p : partial) {
+        if (p.count == 0)
+            continue;
+        const qsizetype count = total.count + p.count;
+        const double delta = p.mean - total.mean;
+        total.mean += delta * double(p.count) / double(count);
+        total.m2 += p.m2 + delta * delta * double(total.count) * double(p.count) / double(count);
+        total.count = count;
+    }
+    return {total.mean, total.m2 / double(total.count)};
+}
+
+template <typename T>
+void inclusiveScan(const T* a, T* out, qsizetype n) {
+    using W = Wrap<T>;
+    const int parts = partitionsFor(n);
+    // Pass 1: partition totals. Pass 2: scan every partition starting from its carry.
+    std::vector<T> carry(static_cast<size_t>(parts), T(0));
+    if (parts > 1) {
+        forEachPartition(n, parts, [&](qsizetype begin, qsizetype end, int index) {
+            W acc = 0;
+            for (qsizetype i = begin; i < end; ++i)
+                acc = W(acc + W(a[i]));
+            carry[size_t(index)] = T(acc);
+        });
+        W running = 0;
+        for (T& c : carry) {
+            const W total = W(c);
+            c = T(running);
+            running = W(running + total);
+        }
+    }
+    forEachPartition(n, parts, [&](qsizetype begin, qsizetype end, int index) {
+        W acc = W(carry[size_t(index)]);
+        for (qsizetype i = begin; i < end; ++i) {
+            acc = W(acc + W(a[i]));
+            out[i] = T(acc);
+        }
+    });
+}
+
+template <typename T>
+void clamp(T* a, qsizetype n, T lo, T hi) {
+    forEachPartition(n, partitionsFor(n), [=](qsizetype begin, qsizetype end, int) {
+        clampLoopDispatch(a + begin, end - begin, lo, hi);
+    });
+}
+
+template <typename From, typename To>
+void convert(const From* src, To* dst, qsizetype n, double scale, double offset) {
+    forEachPartition(n, partitionsFor(n), [=](qsizetype begin, qsizetype end, int) {
+        convertLoopDispatch(src + begin, dst + begin, end - begin, scale, offset);
+    });
+}
+
+#define QTPYT_KERNELS_INSTANTIATE(T)                                                        \
+    template void binary<T>(QPyKernelOp, const T*, const T*, T*, qsizetype);                \
+    template void binaryScalar<T>(QPyKernelOp, const T*, T, T*, qsizetype);                 \
+    template double sum<T>(const T*, qsizetype);                                            \
+    template std::pair<T, T> minMax<T>(const T*, qsizetype);                                \
+    template QPyMoments moments<T>(const T*, qsizetype);                                    \
+    template void inclusiveScan<T>(const T*, T*, qsizetype);                                \
+    template void clamp<T>(T*, qsizetype, T, T);                                            \
+    template void convert<T, quint8>(const T*, quint8*, qsizetype, double, double);         \
+    template void convert<T, qint32>(const T*, qint32*, qsizetype, double, double);         \
+    template void convert<T, qint64>(const T*, qint64*, qsizetype, double, double);         \
+    template void convert<T, float>(const T*, float*, qsizetype, double, double);           \
+    template void convert<T, double>(const T*, double*, qsizetype, double, double);
+
+QTPYT_KERNELS_INSTANTIATE(quint8)
+QTPYT_KERNELS_INSTANTIATE(qint32)
+QTPYT_KERNELS_INSTANTIATE(qint64)
+QTPYT_KERNELS_INSTANTIATE(float)
+QTPYT_KERNELS_INSTANTIATE(double)
+#undef QTPYT_KERNELS_INSTANTIATE
+
+} // namespace kernels
+} // namespace qtpyt
@@ -4,11 +4,14 @@
 #include <qtpyt/qpythreadpool.h>
 #include <qtpyt/qpyslot.h>
 
+#include "internal/q_py_future_impl.h"
+
 
 namespace py = pybind11;
 
 namespace qtpyt {
     static py::object g_CancelledExc;
+    static py::object g_CurrentCall;
     static py::module_ qpyasync_module;
 
     bool inject_cancelled(unsigned long target_tid) {
@@ -38,21 +41,40 @@ namespace qtpyt {
         return false;
     }
 
+    py::handle cancelledErrorType() {
+        return g_CancelledExc;
+    }
+
+    py::handle currentCallVar() {
+        return g_CurrentCall;
+    }
+
     void QPyModule::makeQPyAsyncModule() {
         py::gil_scoped_acquire gil;
-        qpyasync_module= py::module_::create_extension_module("qpyasync", "", nullptr);
-        qpyasync_module.add_object("qpyasync.cancelled", g_CancelledExc, false);
+        if (qpyasync_module)
+            return;
+        static py::module_::module_def def;
+        qpyasync_module = py::module_::create_extension_module("qpyasync", "Cancellation support for qtpyt async calls", &def);
+        // BaseException, like asyncio.CancelledError, so that `except Exception` does not swallow it
+        g_CancelledExc = py::reinterpret_steal<py::object>(
+            PyErr_NewException("qpyasync.CancelledError", PyExc_BaseException, nullptr));
+        if (!g_CancelledExc)
+            throw py::error_already_set();
+        qpyasync_module.add_object("CancelledError", g_CancelledExc);
+        // awaited coroutines run as tasks interleaved on a worker loop, each in its own context
+        g_CurrentCall = py::module_::import("contextvars").attr("ContextVar")("qpyasync_current_call");
+        qpyasync_module.def("cancelled", &QPyFutureImpl::currentCancelRequested,
+                            "True if the call running on this thread has been asked to cancel.");
+        py::module_::import("sys").attr("modules")["qpyasync"] = qpyasync_module;
     }
 
     QPyModule::QPyModule(const QString& source, QPySourceType sourceType)
-        : QPyModuleBase(source, sourceType) {
-        addWantsToCancel();
-    }
+        : QPyModuleBase(source, sourceType) {}
 
     QPyModule::~QPyModule() {}
 
 
-    std::optional<QPyFuture> QPyModule::callAsyncVariant(const QSharedPointer<IQPyFutureNotifier> &notifier, const QString& functionName, const QPyRegisteredType& returnType, QVariantList&& args) const {
+    std::optional<QPyFuture> QPyModule::callAsyncVariant(const QSharedPointer<IQPyFutureNotifier> &notifier, const QString& functionName, const QPyRegisteredType& returnType, QVariantList&& args, const QPyCallOptions& options) const {
         if (functionName.isEmpty()) {
             return std::nullopt;
         }
@@ -65,7 +87,7 @@ namespace qtpyt {
             type = QMetaType(std::get<QMetaType::Type>(returnType)).name();
         }
 
-        QPyFuture me(*this, notifier, functionName, type, std::move(args));
+        QPyFuture me(*this, notifier, functionName, type, std::move(args), options);
         QPyThreadPool::instance().submit(me);
         return me;
     }
@@ -76,19 +98,8 @@ namespace qtpyt {
     }*/
 
     QPySlot QPyModule::makeSlot(const QString &slotName, const QPyRegisteredType &returnType,
-        const QSharedPointer<IQPyFutureNotifier> &notifier) {
-        return QPySlot(*this, notifier, slotName, returnType);
+        const QSharedPointer<IQPyFutureNotifier> &notifier, const QPyCallOptions &options) {
+        return QPySlot(*this, notifier, slotName, returnType, options);
     }
 
-    auto QPyModule::getThreadId() const {
-        return m_threadId;
-    }
-
-    void QPyModule::addWantsToCancel() {
-
-    }
-
-    void QPyModule::setThreadId() {
-        //m_threadId = PyThreadState_Get()->thread_id;
-    }
 } // namespace qtpyt
\ No newline at end of file
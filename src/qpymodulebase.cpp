@@ -23,8 +23,9 @@ namespace qtpyt {
 
     std::pair<std::optional<QVariant>, QString> QPyModuleBase::call(const QString &function,
                                                                     const QPyRegisteredType &returnType,
-                                                                    const QVariantList &args, const QVariantMap &kwargs) {
-        return m_internal->call(function, returnType, args, kwargs);
+                                                                    const QVariantList &args, const QVariantMap &kwargs,
+                                                                    std::chrono::microseconds timeout) {
+        return m_internal->call(function, returnType, args, kwargs, timeout);
     }
 
     void QPyModuleBase::setCallableFunction(const QString &name) {
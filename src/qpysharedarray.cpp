@@ -2,3 +2,266 @@
 
 #include <qtpyt/qpysharedarray.h>
 
+#include <QFile>
+#include <QRandomGenerator>
+
+#include <cstdlib>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace qtpyt {
+namespace detail {
+
+    ChangeTracker::ChangeTracker(qsizetype blockElements, qsizetype count) {
+        while ((qsizetype(1) << m_shift) < blockElements)
+            ++m_shift;
+        // stamps start at 0: the initial contents are reported by a query from version 0 only
+        resize(count, count);
+    }
+
+    ChangeTracker::ChangeTracker(const ChangeTracker& o)
+        : m_epoch(o.m_epoch.load(std::memory_order_acquire)), m_shift(o.m_shift), m_blocks(o.m_blocks),
+          m_stamps(new std::atomic<quint64>[size_t(o.m_blocks)]) {
+        for (qsizetype b = 0; b < m_blocks; ++b)
+            m_stamps[size_t(b)].store(o.m_stamps[size_t(b)].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    void ChangeTracker::resize(qsizetype oldCount, qsizetype count) {
+        const qsizetype blocks = (count + blockElements() - 1) >> m_shift;
+        if (blocks > m_blocks) {
+            std::unique_ptr<std::atomic<quint64>[]> stamps(new std::atomic<quint64>[size_t(blocks)]);
+            for (qsizetype b = 0; b < blocks; ++b)
+                stamps[size_t(b)].store(b < m_blocks ? m_stamps[size_t(b)].load(std::memory_order_relaxed) : 0,
+                                        std::memory_order_relaxed);
+            m_stamps = std::move(stamps);
+            m_blocks = blocks;
+        }
+        if (count > oldCount)
+            mark(oldCount, count - oldCount);
+    }
+
+    std::vector<std::pair<qsizetype, qsizetype>> ChangeTracker::ranges(quint64 since, qsizetype count, quint64* next) {
+        // Changes made from now on carry the new epoch. Accessors stamp before the caller writes,
+        // so a block stamped with the closing epoch may be scanned here before its data lands;
+        // the next call starts from the closing epoch again so that such a block is reported
+        // once more rather than lost.
+        *next = m_epoch.fetch_add(1, std::memory_order_acq_rel);
+        std::vector<std::pair<qsizetype, qsizetype>> out;
+        const qsizetype blocks = std::min(m_blocks, (count + blockElements() - 1) >> m_shift);
+        for (qsizetype b = 0; b < blocks; ++b) {
+            if (since != 0 && m_stamps[size_t(b)].load(std::memory_order_relaxed) < since)
+                continue;
+            const qsizetype begin = b << m_shift;
+            const qsizetype end = std::min(count, (b + 1) << m_shift);
+            if (!out.empty() && out.back().second == begin)
+                out.back().second = end;
+            else
+                out.emplace_back(begin, end);
+        }
+        return out;
+    }
+
+    std::shared_ptr<OwnerState> mapFileRegion(const QString& path, qint64 offset, qint64 bytes, QPyMapMode mode,
+                                              void** outPtr, qint64* outBytes) {
+        auto file = std::make_unique<QFile>(path);
+        const auto openMode = mode == QPyMapMode::ReadWrite ? QIODevice::ReadWrite : QIODevice::ReadOnly;
+        if (!file->open(openMode)) {
+            throw std::runtime_error("QPySharedArray::mapFile: failed to open " + path.toStdString() + ": " +
+                                     file->errorString().toStdString());
+        }
+        const qint64 fileSize = file->size();
+        if (offset > fileSize)
+            throw std::runtime_error("QPySharedArray::mapFile: offset is past the end of " + path.toStdString());
+        if (bytes < 0)
+            bytes = fileSize - offset;
+        if (offset + bytes > fileSize)
+            throw std::runtime_error("QPySharedArray::mapFile: region exceeds the size of " + path.toStdString());
+
+        *outPtr = nullptr;
+        *outBytes = bytes;
+        if (bytes == 0)
+            return {};
+
+        const auto flags = mode == QPyMapMode::CopyOnWrite ? QFileDevice::MapPrivateOption : QFileDevice::NoOptions;
+        uchar* mapped = file->map(offset, bytes, flags);
+        if (!mapped) {
+            throw std::runtime_error("QPySharedArray::mapFile: failed to map " + path.toStdString() + ": " +
+                                     file->errorString().toStdString());
+        }
+        *outPtr = mapped;
+        // QFile unmaps all of its regions when it is destroyed.
+        return make_owner(file.release(), [](void* f) { delete static_cast<QFile*>(f); });
+    }
+
+#if defined(Q_OS_UNIX)
+    namespace {
+        struct SharedMemoryRegion {
+            void* addr = nullptr;
+            size_t length = 0;
+            std::string unlinkName;
+        };
+
+        void releaseSharedMemoryRegion(void* p) {
+            auto* region = static_cast<SharedMemoryRegion*>(p);
+            if (region->addr)
+                ::munmap(region->addr, region->length);
+            if (!region->unlinkName.empty())
+                ::shm_unlink(region->unlinkName.c_str());
+            delete region;
+        }
+
+        std::string segmentName(const QString& name) {
+            std::string s = name.toStdString();
+            if (s.empty() || s.front() != '/')
+                s.insert(s.begin(), '/');
+            return s;
+        }
+
+        [[noreturn]] void throwErrno(const char* what, const std::string& name) {
+            throw std::runtime_error(std::string("QPySharedArray: ") + what + " " + name + ": " + std::strerror(errno));
+        }
+
+        int createAnonymousFd() {
+#if defined(Q_OS_LINUX)
+            return ::memfd_create("qtpyt-shared-array", MFD_CLOEXEC);
+#else
+            // No memfd: create a uniquely named segment and drop its name right away.
+            const std::string tmp = "/qtpyt-" + std::to_string(::getpid()) + "-" +
+                                    std::to_string(QRandomGenerator::global()->generate64());
+            const int fd = ::shm_open(tmp.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (fd >= 0)
+                ::shm_unlink(tmp.c_str());
+            return fd;
+#endif
+        }
+    } // namespace
+
+    std::shared_ptr<OwnerState> createSharedMemoryRegion(const QString& name, qint64 bytes, bool unlinkOnRelease,
+                                                         void** outPtr, int* outFd) {
+        const bool anonymous = name.isEmpty();
+        const std::string shmName = anonymous ? std::string("<anonymous>") : segmentName(name);
+        const int fd = anonymous ? createAnonymousFd() : ::shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throwErrno("failed to create shared memory", shmName);
+        if (::ftruncate(fd, off_t(bytes)) != 0) {
+            const int err = errno;
+            ::close(fd);
+            if (!anonymous)
+                ::shm_unlink(shmName.c_str());
+            errno = err;
+            throwErrno("failed to size shared memory", shmName);
+        }
+        void* addr = ::mmap(nullptr, size_t(bytes), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            const int err = errno;
+            ::close(fd);
+            if (!anonymous)
+                ::shm_unlink(shmName.c_str());
+            errno = err;
+            throwErrno("failed to map shared memory", shmName);
+        }
+        // The mapping does not need the descriptor: hand it over instead of duplicating it,
+        // which could fail (EMFILE) after the segment was already created.
+        if (outFd)
+            *outFd = fd;
+        else
+            ::close(fd);
+
+        auto* region = new SharedMemoryRegion{addr, size_t(bytes), {}};
+        if (!anonymous && unlinkOnRelease)
+            region->unlinkName = shmName;
+        *outPtr = addr;
+        return make_owner(region, releaseSharedMemoryRegion);
+    }
+
+    std::shared_ptr<OwnerState> attachSharedMemoryRegion(const QString& name, qint64 bytes, QPyMapMode mode,
+                                                         void** outPtr, qint64* outBytes) {
+        const std::string shmName = segmentName(name);
+        const int fd = ::shm_open(shmName.c_str(), mode == QPyMapMode::ReadWrite ? O_RDWR : O_RDONLY, 0);
+        if (fd < 0)
+            throwErrno("failed to open shared memory", shmName);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throwErrno("failed to query shared memory", shmName);
+        }
+        if (bytes < 0)
+            bytes = qint64(st.st_size);
+        if (bytes > qint64(st.st_size)) {
+            ::close(fd);
+            throw std::runtime_error("QPySharedArray: " + shmName + " is smaller than the requested length");
+        }
+        *outPtr = nullptr;
+        *outBytes = bytes;
+        if (bytes == 0) {
+            ::close(fd);
+            return {};
+        }
+        const int prot = mode == QPyMapMode::ReadOnly ? PROT_READ : PROT_READ | PROT_WRITE;
+        const int flags = mode == QPyMapMode::CopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+        void* addr = ::mmap(nullptr, size_t(bytes), prot, flags, fd, 0);
+        const int err = errno;
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            errno = err;
+            throwErrno("failed to map shared memory", shmName);
+        }
+        *outPtr = addr;
+        return make_owner(new SharedMemoryRegion{addr, size_t(bytes), {}}, releaseSharedMemoryRegion);
+    }
+
+    namespace {
+        struct AnonymousRegion {
+            void* addr = nullptr;
+            size_t length = 0;
+        };
+
+        void releaseAnonymousRegion(void* p) {
+            auto* region = static_cast<AnonymousRegion*>(p);
+            ::munmap(region->addr, region->length);
+            delete region;
+        }
+    } // namespace
+
+    std::shared_ptr<OwnerState> allocateAnonymousRegion(qint64 bytes, bool hugePages, void** outPtr) {
+        // Anonymous private mappings are zero-filled and only committed page by page on first write.
+        void* addr = ::mmap(nullptr, size_t(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (addr == MAP_FAILED)
+            throwErrno("failed to allocate", std::to_string(bytes) + " bytes");
+#if defined(MADV_HUGEPAGE)
+        // Advisory only: a kernel with THP disabled simply keeps regular pages.
+        if (hugePages)
+            ::madvise(addr, size_t(bytes), MADV_HUGEPAGE);
+#else
+        Q_UNUSED(hugePages);
+#endif
+        *outPtr = addr;
+        return make_owner(new AnonymousRegion{addr, size_t(bytes)}, releaseAnonymousRegion);
+    }
+#else
+    std::shared_ptr<OwnerState> allocateAnonymousRegion(qint64 bytes, bool, void** outPtr) {
+        void* addr = std::calloc(size_t(bytes), 1);
+        if (!addr)
+            throw std::runtime_error("QPySharedArray: failed to allocate " + std::to_string(bytes) + " bytes");
+        *outPtr = addr;
+        return make_owner(addr, [](void* p) { std::free(p); });
+    }
+
+    std::shared_ptr<OwnerState> createSharedMemoryRegion(const QString&, qint64, bool, void**, int*) {
+        throw std::runtime_error("QPySharedArray: POSIX shared memory is not available on this platform");
+    }
+
+    std::shared_ptr<OwnerState> attachSharedMemoryRegion(const QString&, qint64, QPyMapMode, void**, qint64*) {
+        throw std::runtime_error("QPySharedArray: POSIX shared memory is not available on this platform");
+    }
+#endif
+
+} // namespace detail
+} // namespace qtpyt
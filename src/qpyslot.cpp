@@ -104,6 +104,14 @@ namespace qtpyt {
                 return m_parameterTypes;
             }
 
+            void setCallOptions(const QPyCallOptions& options) {
+                m_options = options;
+            }
+
+            [[nodiscard]] const QPyCallOptions& callOptions() const {
+                return m_options;
+            }
+
             [[nodiscard]] QByteArray returnType() const {
                 if (std::holds_alternative<QMetaType>(m_returnType)) {
                     return std::get<QMetaType>(m_returnType).name();
@@ -123,6 +131,7 @@ namespace qtpyt {
             QSharedPointer<IQPyFutureNotifier> m_notifier;
             QPyRegisteredType m_returnType;
             AdditionalType * m_additional;
+            QPyCallOptions m_options;
         };
 
     } // namespace
@@ -166,7 +175,7 @@ namespace qtpyt {
         try {
             auto* slot = static_cast<QPySlotInternal<QPyModule, void>*>(this_);
             auto asyncModule = slot->module();
-            QPyFuture f = QPyFuture(asyncModule, slot->notifier(), slot->functionName(), slot->returnType(), slot->parameterTypes(),  a);
+            QPyFuture f = QPyFuture(asyncModule, slot->notifier(), slot->functionName(), slot->returnType(), slot->parameterTypes(),  a, slot->callOptions());
             QPyThreadPool::instance().submit(std::move(f));
             this_->destroyIfLastRef();
         } catch (const pybind11::error_already_set& e) {
@@ -174,7 +183,7 @@ namespace qtpyt {
         }
     };
 
-    QMetaObject::Connection QPySlot::connectPythonFunctionAsync(QObject* sender, const char* signal, QPyModule module, const QSharedPointer<IQPyFutureNotifier>& notifier, const QString& slot, const QPyRegisteredType& returnType) {
+    QMetaObject::Connection QPySlot::connectPythonFunctionAsync(QObject* sender, const char* signal, QPyModule module, const QSharedPointer<IQPyFutureNotifier>& notifier, const QString& slot, const QPyRegisteredType& returnType, const QPyCallOptions& options) {
         module.setCallableFunction(slot);
         const auto pyCallableInfo = module.inspectCallable();
         const auto signalMethod = findMatchingSignal(sender, signal, pyCallableInfo);
@@ -186,6 +195,7 @@ namespace qtpyt {
         //auto callableFunc = []
         auto* slotObject = new QPySlotInternal<QPyModule, void>(std::move(module), notifier, mmethod, callInThreadPool, returnType);
         slotObject->setCallableFunction(slot);
+        slotObject->setCallOptions(options);
         const int signalIndex = mmethod.methodIndex();
         return QObjectPrivate::connect(sender, signalIndex, slotObject, Qt::DirectConnection);
     }
@@ -234,13 +244,13 @@ namespace qtpyt {
     }
 
     QPySlot::QPySlot(QPyModule module, QSharedPointer<IQPyFutureNotifier> notifier,
-        const QString &slotName, const QPyRegisteredType &returnType) : m_module(std::move(module)),
-    m_notifier(std::move(notifier)), m_slotName(slotName), m_returnType(returnType)
+        const QString &slotName, const QPyRegisteredType &returnType, const QPyCallOptions &options) : m_module(std::move(module)),
+    m_notifier(std::move(notifier)), m_slotName(slotName), m_returnType(returnType), m_options(options)
     {}
 
     QMetaObject::Connection QPySlot::
     connectAsyncToSignal(QObject *sender, const char *signal, Qt::ConnectionType type) const {
-        return connectPythonFunctionAsync(sender, signal, m_module, m_notifier, m_slotName, m_returnType);
+        return connectPythonFunctionAsync(sender, signal, m_module, m_notifier, m_slotName, m_returnType, m_options);
     }
 
     QMetaObject::Connection QPySlot::
@@ -0,0 +1,417 @@
+#include <qtpyt/qpytable.h>
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+namespace qtpyt {
+namespace {
+
+    qsizetype arrowItemSize(const std::string& format) {
+        if (format.size() != 1)
+            return 0;
+        switch (format.front()) {
+            case 'c': case 'C': return 1;
+            case 's': case 'S': case 'e': return 2;
+            case 'i': case 'I': case 'f': return 4;
+            case 'l': case 'L': case 'g': return 8;
+            default: return 0;
+        }
+    }
+
+    qint64 countNulls(const quint8* validity, qsizetype rows) {
+        if (!validity)
+            return 0;
+        qint64 valid = 0;
+        const qsizetype fullBytes = rows / 8;
+        for (qsizetype i = 0; i < fullBytes; ++i)
+            valid += std::popcount(validity[i]);
+        for (qsizetype r = fullBytes * 8; r < rows; ++r)
+            valid += (validity[r >> 3] >> (r & 7)) & 1;
+        return rows - valid;
+    }
+
+    // Copies \p rows validity bits starting at bit \p from of \p src to bit \p to of \p dst;
+    // a null source marks the rows valid.
+    void copyBits(const quint8* src, qsizetype from, quint8* dst, qsizetype to, qsizetype rows) {
+        for (qsizetype r = 0; r < rows; ++r) {
+            const bool valid = !src || ((src[(from + r) >> 3] >> ((from + r) & 7)) & 1);
+            const qsizetype bit = to + r;
+            if (valid)
+                dst[bit >> 3] |= quint8(1u << (bit & 7));
+            else
+                dst[bit >> 3] &= quint8(~(1u << (bit & 7)));
+        }
+    }
+
+    // ---- export ------------------------------------------------------------------------
+
+    // Children belong to the private data of their parent and are freed with it, also when an
+    // export throws before the parent is handed out.
+    template <typename Arrow>
+    void releaseChildren(const std::vector<Arrow*>& children) {
+        for (Arrow* child : children) {
+            if (child->release)
+                child->release(child);
+            delete child;
+        }
+    }
+
+    struct SchemaPrivate {
+        std::string format;
+        std::string name;
+        std::vector<ArrowSchema*> children;
+
+        ~SchemaPrivate() { releaseChildren(children); }
+    };
+
+    void releaseSchema(ArrowSchema* schema) {
+        delete static_cast<SchemaPrivate*>(schema->private_data);
+        schema->release = nullptr;
+    }
+
+    // Takes ownership of \p p; cannot throw.
+    void fillSchema(ArrowSchema* out, int64_t flags, std::unique_ptr<SchemaPrivate> p) {
+        out->format = p->format.c_str();
+        out->name = p->name.c_str();
+        out->metadata = nullptr;
+        out->flags = flags;
+        out->n_children = int64_t(p->children.size());
+        out->children = p->children.empty() ? nullptr : p->children.data();
+        out->dictionary = nullptr;
+        out->release = &releaseSchema;
+        out->private_data = p.release();
+    }
+
+    void exportSchema(const QPyTable& table, ArrowSchema* out) {
+        auto parent = std::make_unique<SchemaPrivate>();
+        parent->format = "+s";
+        parent->children.reserve(size_t(table.columnCount()));
+        for (qsizetype i = 0; i < table.columnCount(); ++i) {
+            const QPyTableColumn& c = table.columnAt(i);
+            auto p = std::make_unique<SchemaPrivate>();
+            p->format = c.format;
+            p->name = c.name.toStdString();
+            auto child = std::make_unique<ArrowSchema>();
+            fillSchema(child.get(), c.validity ? ARROW_FLAG_NULLABLE : 0, std::move(p));
+            parent->children.push_back(child.release());   // reserved: does not throw
+        }
+        fillSchema(out, 0, std::move(parent));
+    }
+
+    struct ArrayPrivate {
+        std::shared_ptr<detail::OwnerState> anchor;
+        std::vector<const void*> buffers;
+        std::vector<ArrowArray*> children;
+
+        ~ArrayPrivate() { releaseChildren(children); }
+    };
+
+    void releaseArray(ArrowArray* array) {
+        delete static_cast<ArrayPrivate*>(array->private_data);
+        array->release = nullptr;
+    }
+
+    // Takes ownership of \p p; cannot throw.
+    void fillArray(ArrowArray* out, int64_t length, int64_t nullCount, std::unique_ptr<ArrayPrivate> p) {
+        out->length = length;
+        out->null_count = nullCount;
+        out->offset = 0;
+        out->n_buffers = int64_t(p->buffers.size());
+        out->n_children = int64_t(p->children.size());
+        out->buffers = p->buffers.data();
+        out->children = p->children.empty() ? nullptr : p->children.data();
+        out->dictionary = nullptr;
+        out->release = &releaseArray;
+        out->private_data = p.release();
+    }
+
+    void exportArray(const QPyTable& table, ArrowArray* out) {
+        auto parent = std::make_unique<ArrayPrivate>();
+        parent->buffers = {nullptr};
+        parent->children.reserve(size_t(table.columnCount()));
+        for (qsizetype i = 0; i < table.columnCount(); ++i) {
+            const QPyTableColumn& c = table.columnAt(i);
+            auto p = std::make_unique<ArrayPrivate>();
+            p->anchor = c.anchor;
+            p->buffers = {c.validity, c.data};
+            auto child = std::make_unique<ArrowArray>();
+            fillArray(child.get(), table.rowCount(), c.nullCount, std::move(p));
+            parent->children.push_back(child.release());   // reserved: does not throw
+        }
+        fillArray(out, table.rowCount(), 0, std::move(parent));
+    }
+
+    struct StreamPrivate {
+        QPyTable table;
+        bool done = false;
+        std::string error;
+    };
+
+    int streamGetSchema(ArrowArrayStream* stream, ArrowSchema* out) {
+        auto* p = static_cast<StreamPrivate*>(stream->private_data);
+        try {
+            exportSchema(p->table, out);
+            return 0;
+        } catch (const std::exception& e) {
+            p->error = e.what();
+            return ENOMEM;
+        }
+    }
+
+    int streamGetNext(ArrowArrayStream* stream, ArrowArray* out) {
+        auto* p = static_cast<StreamPrivate*>(stream->private_data);
+        if (p->done) {
+            out->release = nullptr;    // end of stream
+            return 0;
+        }
+        try {
+            exportArray(p->table, out);
+            p->done = true;
+            return 0;
+        } catch (const std::exception& e) {
+            p->error = e.what();
+            return ENOMEM;
+        }
+    }
+
+    const char* streamGetLastError(ArrowArrayStream* stream) {
+        auto* p = static_cast<StreamPrivate*>(stream->private_data);
+        return p->error.empty() ? nullptr : p->error.c_str();
+    }
+
+    void releaseStream(ArrowArrayStream* stream) {
+        delete static_cast<StreamPrivate*>(stream->private_data);
+        stream->release = nullptr;
+    }
+
+    // ---- import ------------------------------------------------------------------------
+
+    std::shared_ptr<detail::OwnerState> anchorOf(const std::shared_ptr<ArrowArray>& imported) {
+        return detail::make_owner(new std::shared_ptr<ArrowArray>(imported), [](void* p) {
+            delete static_cast<std::shared_ptr<ArrowArray>*>(p);
+        });
+    }
+
+    [[noreturn]] void throwUnsupported(const QPyTableColumn& c) {
+        throw std::runtime_error("QPyTable: unsupported Arrow type '" + c.format + "' in column '" +
+                                 c.name.toStdString() + "'");
+    }
+
+    // Name and type of a column, without data; rejects the types QPyTable cannot hold.
+    QPyTableColumn describeColumn(const ArrowSchema* schema) {
+        QPyTableColumn c;
+        c.format = schema->format ? schema->format : "";
+        c.name = QString::fromUtf8(schema->name ? schema->name : "");
+        c.itemsize = arrowItemSize(c.format);
+        if (c.itemsize == 0 || schema->dictionary)
+            throwUnsupported(c);
+        return c;
+    }
+
+    QPyTableColumn importColumn(const ArrowArray* array, const ArrowSchema* schema, int64_t offset, int64_t rows,
+                                const std::shared_ptr<ArrowArray>& imported) {
+        QPyTableColumn c = describeColumn(schema);
+        if (array->n_buffers != 2)
+            throwUnsupported(c);
+        offset += array->offset;
+        c.data = static_cast<const char*>(array->buffers[1]) + offset * c.itemsize;
+        c.anchor = anchorOf(imported);
+
+        const auto* bits = static_cast<const quint8*>(array->buffers[0]);
+        if (bits && array->null_count != 0) {
+            if (offset % 8 == 0) {
+                c.validity = bits + offset / 8;
+            } else {
+                // Unaligned slice: rebase the bitmap so that bit 0 is the first row.
+                QPySharedArray<quint8> rebased((rows + 7) / 8);
+                quint8* dst = rebased.data();
+                std::memset(dst, 0, size_t(rebased.size()));
+                copyBits(bits, offset, dst, 0, rows);
+                c.validity = rebased.constData();
+                using Holder = std::pair<std::shared_ptr<ArrowArray>, QPySharedArray<quint8>>;
+                c.anchor = detail::make_owner(new Holder(imported, rebased), [](void* p) {
+                    delete static_cast<Holder*>(p);
+                });
+            }
+        }
+        return c;
+    }
+
+    // Concatenate tables with identical columns into new owned storage.
+    QPyTable concatenate(const std::vector<QPyTable>& batches) {
+        const QPyTable& first = batches.front();
+        qsizetype rows = 0;
+        for (const QPyTable& b : batches) {
+            if (b.columnNames() != first.columnNames())
+                throw std::runtime_error("QPyTable: stream batches have different columns");
+            rows += b.rowCount();
+        }
+        QPyTable out;
+        for (qsizetype i = 0; i < first.columnCount(); ++i) {
+            const QPyTableColumn& head = first.columnAt(i);
+            QPySharedArray<quint8> bytes(rows * head.itemsize);
+            QPySharedArray<quint8> validity;
+            bool nullable = false;
+            for (const QPyTable& b : batches)
+                nullable = nullable || b.columnAt(i).validity;
+            if (nullable)
+                validity = QPySharedArray<quint8>((rows + 7) / 8);
+
+            qsizetype row = 0;
+            for (const QPyTable& b : batches) {
+                const QPyTableColumn& c = b.columnAt(i);
+                if (c.format != head.format)
+                    throw std::runtime_error("QPyTable: stream batches have different column types");
+                std::memcpy(bytes.data() + row * head.itemsize, c.data, size_t(b.rowCount() * head.itemsize));
+                if (nullable)
+                    copyBits(c.validity, 0, validity.data(), row, b.rowCount());
+                row += b.rowCount();
+            }
+
+            QPyTableColumn c = head;
+            c.data = bytes.constData();
+            c.validity = nullable ? validity.constData() : nullptr;
+            using Holder = std::pair<QPySharedArray<quint8>, QPySharedArray<quint8>>;
+            c.anchor = detail::make_owner(new Holder(bytes, validity), [](void* p) { delete static_cast<Holder*>(p); });
+            out.addColumn(std::move(c), rows);
+        }
+        return out;
+    }
+
+} // namespace
+
+QStringList QPyTable::columnNames() const {
+    QStringList names;
+    names.reserve(m_columns.size());
+    for (const QPyTableColumn& c : m_columns)
+        names.append(c.name);
+    return names;
+}
+
+qsizetype QPyTable::indexOf(const QString& name) const {
+    for (qsizetype i = 0; i < m_columns.size(); ++i) {
+        if (m_columns[i].name == name)
+            return i;
+    }
+    return -1;
+}
+
+const QPyTableColumn& QPyTable::columnAt(qsizetype index) const {
+    if (index < 0 || index >= m_columns.size())
+        throw std::out_of_range("QPyTable: column index out of range");
+    return m_columns[index];
+}
+
+void QPyTable::addColumn(QPyTableColumn column, qsizetype rows) {
+    if (indexOf(column.name) >= 0)
+        throw std::invalid_argument("QPyTable::addColumn: duplicate column name '" + column.name.toStdString() + "'");
+    if (!m_columns.isEmpty() && rows != m_rows)
+        throw std::invalid_argument("QPyTable::addColumn: column '" + column.name.toStdString() + "' has " +
+                                    std::to_string(rows) + " rows, the table has " + std::to_string(m_rows));
+    column.nullCount = countNulls(column.validity, rows);
+    if (column.nullCount == 0)
+        column.validity = nullptr;
+    m_rows = rows;
+    m_columns.append(std::move(column));
+}
+
+void QPyTable::exportToArrow(ArrowArray* outArray, ArrowSchema* outSchema) const {
+    exportSchema(*this, outSchema);
+    try {
+        exportArray(*this, outArray);
+    } catch (...) {
+        outSchema->release(outSchema);
+        throw;
+    }
+}
+
+void QPyTable::exportToArrowStream(ArrowArrayStream* out) const {
+    out->get_schema = &streamGetSchema;
+    out->get_next = &streamGetNext;
+    out->get_last_error = &streamGetLastError;
+    out->release = &releaseStream;
+    out->private_data = new StreamPrivate{*this, false, {}};
+}
+
+QPyTable QPyTable::importFromArrow(ArrowArray* array, const ArrowSchema* schema) {
+    if (!array || !array->release || !schema)
+        throw std::runtime_error("QPyTable: released or null Arrow array");
+
+    // Move the array; it is released with the last column that references it.
+    auto imported = std::shared_ptr<ArrowArray>(new ArrowArray(*array), [](ArrowArray* a) {
+        if (a->release)
+            a->release(a);
+        delete a;
+    });
+    array->release = nullptr;
+
+    QPyTable table;
+    const std::string format = schema->format ? schema->format : "";
+    if (format == "+s") {
+        if (imported->null_count != 0 && imported->n_buffers > 0 && imported->buffers[0])
+            throw std::runtime_error("QPyTable: struct arrays with top-level nulls are not supported");
+        if (schema->n_children != imported->n_children)
+            throw std::runtime_error("QPyTable: schema and array have different numbers of children");
+        for (int64_t i = 0; i < imported->n_children; ++i) {
+            const ArrowArray* child = imported->children[i];
+            if (child->length < imported->offset + imported->length)
+                throw std::runtime_error("QPyTable: child array is shorter than the struct array");
+            QPyTableColumn c = importColumn(child, schema->children[i], imported->offset, imported->length, imported);
+            // The child length may exceed the struct length; the table has the struct's rows.
+            table.addColumn(std::move(c), qsizetype(imported->length));
+        }
+    } else {
+        table.addColumn(importColumn(imported.get(), schema, 0, imported->length, imported), qsizetype(imported->length));
+    }
+    return table;
+}
+
+QPyTable QPyTable::importFromArrowStream(ArrowArrayStream* stream) {
+    if (!stream || !stream->release)
+        throw std::runtime_error("QPyTable: released or null Arrow stream");
+    struct StreamGuard {
+        ArrowArrayStream* s;
+        ~StreamGuard() { if (s->release) s->release(s); }
+    } guard{stream};
+
+    auto check = [stream](int rc) {
+        if (rc != 0) {
+            const char* msg = stream->get_last_error ? stream->get_last_error(stream) : nullptr;
+            throw std::runtime_error(std::string("QPyTable: Arrow stream error: ") +
+                                     (msg ? msg : std::strerror(rc)));
+        }
+    };
+
+    ArrowSchema schema{};
+    check(stream->get_schema(stream, &schema));
+    struct SchemaGuard {
+        ArrowSchema* s;
+        ~SchemaGuard() { if (s->release) s->release(s); }
+    } schemaGuard{&schema};
+
+    std::vector<QPyTable> batches;
+    for (;;) {
+        ArrowArray batch{};
+        check(stream->get_next(stream, &batch));
+        if (!batch.release)
+            break;
+        batches.push_back(importFromArrow(&batch, &schema));
+    }
+    if (batches.empty()) {
+        // Empty stream: columns without rows, checked like those of a batch.
+        QPyTable table;
+        if (schema.format && std::string(schema.format) != "+s") {
+            table.addColumn(describeColumn(&schema), 0);
+            return table;
+        }
+        for (int64_t i = 0; i < schema.n_children; ++i)
+            table.addColumn(describeColumn(schema.children[i]), 0);
+        return table;
+    }
+    return batches.size() == 1 ? batches.front() : concatenate(batches);
+}
+
+} // namespace qtpyt
@@ -0,0 +1,64 @@
+#include <qtpyt/qpytask.h>
+
+#include "internal/q_py_future_impl.h"
+
+#include <QAbstractEventDispatcher>
+#include <QDebug>
+#include <QObject>
+#include <QPointer>
+
+namespace qtpyt {
+    namespace {
+        // Lives in, and is destroyed with, the thread that awaits: queued continuations posted
+        // to it run on that thread.
+        QObject* resumeContext() {
+            thread_local QObject context;
+            return &context;
+        }
+    } // namespace
+
+    bool QPyFutureAwaiter::await_suspend(std::coroutine_handle<> handle) const {
+        QObject* context = QAbstractEventDispatcher::instance() != nullptr ? resumeContext() : nullptr;
+        // Resuming from here could destroy the frame, and m_future with it, while this call is
+        // still on the stack: register only if the call is pending, else do not suspend.
+        return m_future.m_impl->addContinuation([handle, target = QPointer<QObject>(context), hasContext = context != nullptr] {
+            if (!hasContext) {
+                handle.resume();
+                return;
+            }
+            if (QObject* receiver = target.data()) {
+                QMetaObject::invokeMethod(receiver, [handle] { handle.resume(); }, Qt::QueuedConnection);
+            }
+        });
+    }
+
+    QVariant QPyFutureAwaiter::await_resume() const {
+        switch (m_future.state()) {
+        case QPyFutureState::Finished:
+            return m_future.resultCount() > 0 ? m_future.resultAsVariant(0) : QVariant();
+        case QPyFutureState::Canceled:
+            throw std::runtime_error("QPyFutureAwaiter: the call was canceled");
+        default:
+            throw std::runtime_error(m_future.errorMessage().toStdString());
+        }
+    }
+
+    namespace detail {
+        void warnUnobservedTaskError(const std::exception_ptr& error) {
+            try {
+                std::rethrow_exception(error);
+            } catch (const std::exception& e) {
+                qWarning() << "QPyTask: unobserved exception:" << e.what();
+            } catch (...) {
+                qWarning() << "QPyTask: unobserved exception of unknown type";
+            }
+        }
+    } // namespace detail
+
+    QPyFutureAwaiter operator co_await(std::optional<QPyFuture> future) {
+        if (!future.has_value()) {
+            throw std::runtime_error("QPyFutureAwaiter: the call could not be scheduled");
+        }
+        return QPyFutureAwaiter(std::move(*future));
+    }
+} // namespace qtpyt
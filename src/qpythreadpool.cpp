@@ -1,38 +1,310 @@
 #include <pybind11/pybind11.h>
 #include <qtpyt/qpythreadpool.h>
-#include "internal/q_py_queue.h"
+#include "internal/q_py_event_loop.h"
+#include "internal/q_py_mpmc_queue.h"
+#include "internal/q_py_priority_lanes.h"
+#include "internal/q_py_watchdog.h"
+#include "internal/q_py_work_stealing.h"
+
+#include <deque>
 
 namespace qtpyt {
     static int _threadCount = 0;
     static bool _useSubInterpreters = false;
+    static bool _eventLoops = true;
     static bool _initialized = false;
 
-    QPyThreadPool::QPyThreadPool(size_t threadCount, bool useSubInterpreters) : stop_(false) {
+    namespace {
+        // Slots of each worker's inbox; a full inbox spills into the next one, then the overflow.
+        constexpr std::size_t InboxCapacity = 1024;
+        // Rounds an idle worker keeps looking for work before it parks on the condition variable.
+        constexpr int SpinRounds = 64;
+        // Wait after which a Background call is run ahead of Normal ones.
+        constexpr std::chrono::milliseconds BackgroundAging{100};
+        // How long an idle worker with awaited calls runs its event loop before it looks for
+        // tasks again; bounds the extra latency of a submission to such a worker.
+        constexpr std::chrono::microseconds EventLoopSlice{1000};
+
+        // Worker of the pool running on this thread, if any: submit() from a task goes to the
+        // worker's own deque.
+        thread_local const QPyThreadPool* t_pool = nullptr;
+        thread_local size_t t_workerIndex = 0;
+
+        // xorshift32, per worker: victim selection needs no quality, only spread.
+        thread_local quint32 t_random = 0;
+
+        quint32 nextRandom() {
+            quint32 x = t_random;
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            t_random = x;
+            return x;
+        }
+    } // namespace
+
+    struct QPyThreadPool::Worker {
+        detail::QPyWorkStealingDeque<QPyFuture*> local;   ///< tasks submitted by this worker
+        detail::QPyMpmcQueue<QPyFuture*> inbox{InboxCapacity};  ///< tasks submitted by other threads
+        std::unique_ptr<detail::QPyEventLoop> eventLoop;   ///< awaited calls, if event loops are on
+    };
+
+    QPyThreadPool::QPyThreadPool(size_t threadCount, bool useSubInterpreters, bool eventLoops)
+        : m_affinity(std::make_unique<detail::QPyAffinityHints>()),
+          m_lanes(std::make_unique<detail::QPyPriorityLanes<QPyFuture*>>(BackgroundAging)), stop_(false),
+          m_subInterpretersUsed(useSubInterpreters) {
         if (threadCount == 0)
             threadCount = 1;
+        // keep one worker free of background work so interactive calls never queue behind a batch
+        m_maxBackground = threadCount > 1 ? threadCount - 1 : 1;
         workers_.reserve(threadCount);
-        tasks_.resize(threadCount); // one queue per worker
-
+        m_workers.reserve(threadCount);
         for (size_t i = 0; i < threadCount; ++i) {
-            tasks_[i] = std::make_unique<::QPyQueue>();
-            workers_.emplace_back([this, i] {
-                while (!stop_.load()) {
-                        auto taskOpt = tasks_[i]->wait_and_pop();
-                        if (!taskOpt) {
-                            continue;
-                        }
-                    {
-                        pybind11::gil_scoped_acquire gil;
-                        taskOpt.value()();
-                    }
-                }
-            });
-        }
-    }
-
-    void QPyThreadPool::initialize(size_t threadCount, bool useSubInterpreters) {
+            m_workers.push_back(std::make_unique<Worker>());
+            if (eventLoops)
+                m_workers.back()->eventLoop = std::make_unique<detail::QPyEventLoop>();
+        }
+
+        for (size_t i = 0; i < threadCount; ++i)
+            workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    void QPyThreadPool::workerLoop(size_t index) {
+        t_pool = this;
+        t_workerIndex = index;
+        t_random = quint32(index) * 2654435761u + 1u;
+        detail::QPyEventLoop* eventLoop = m_workers[index]->eventLoop.get();
+        detail::QPyEventLoop::setCurrent(eventLoop);
+
+        bool background = false;
+        while (!stop_.load(std::memory_order_acquire)) {
+            if (QPyFuture* task = findTask(index, background)) {
+                runTask(index, task, background);
+                // awaited calls make progress between tasks, whatever the load
+                if (eventLoop && eventLoop->hasPending())
+                    eventLoop->runOnce();
+                continue;
+            }
+            if (eventLoop && eventLoop->hasPending()) {
+                // Idle with awaited calls: wait for their I/O instead of parking.
+                eventLoop->runOnce(EventLoopSlice);
+                continue;
+            }
+            // Spin for a short while before parking: a burst of submissions is picked up without
+            // any futex traffic, and submit() skips the notify while somebody is spinning.
+            QPyFuture* task = nullptr;
+            m_spinning.fetch_add(1, std::memory_order_seq_cst);
+            for (int round = 0; round < SpinRounds && !stop_.load(std::memory_order_relaxed); ++round) {
+                detail::cpuRelax();
+                if ((task = findTask(index, background)))
+                    break;
+            }
+            if (m_spinning.fetch_sub(1, std::memory_order_seq_cst) == 1 && task)
+                wakeSleepers(1);   // the last spinner found work; more may be behind it
+            if (task) {
+                runTask(index, task, background);
+                continue;
+            }
+            // Announce the intent to sleep, then look once more: a submit that raced with the
+            // search either is found now or has moved the epoch and wakes us.
+            const quint64 epoch = m_wakeEpoch.load(std::memory_order_seq_cst);
+            m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if ((task = findTask(index, background))) {
+                m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+                runTask(index, task, background);
+                continue;
+            }
+            {
+                std::unique_lock<std::mutex> lock(m_parkMutex);
+                m_parkCondition.wait(lock, [&] {
+                    return stop_.load(std::memory_order_relaxed) ||
+                           m_wakeEpoch.load(std::memory_order_relaxed) != epoch;
+                });
+            }
+            m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (eventLoop)
+            eventLoop->close();   // awaited calls that are still running end as Canceled
+        detail::QPyEventLoop::setCurrent(nullptr);
+        t_pool = nullptr;
+    }
+
+    QPyFuture* QPyThreadPool::findTask(size_t index, bool& background) {
+        QPyFuture* task = nullptr;
+        background = false;
+        // Deadline-ordered work first, then background work that has waited too long.
+        if (m_lanes->popUrgent(task))
+            return task;
+        if (m_lanes->backgroundSize() > 0 && acquireBackgroundSlot()) {
+            if (m_lanes->popAgedBackground(task)) {
+                m_agedPromotions.fetch_add(1, std::memory_order_relaxed);
+                background = true;
+                return task;
+            }
+            releaseBackgroundSlot();
+        }
+
+        Worker& self = *m_workers[index];
+        if (self.local.pop(task))
+            return task;
+        if (self.inbox.tryPop(task))
+            return task;
+
+        const size_t n = m_workers.size();
+        if (n >= 2) {
+            const size_t start = nextRandom() % n;
+            for (size_t k = 0; k < n; ++k) {
+                const size_t victim = (start + k) % n;
+                if (victim == index)
+                    continue;
+                Worker& other = *m_workers[victim];
+                if (other.local.steal(task))
+                    return task;
+                if (other.inbox.tryPop(task))
+                    return task;
+            }
+        }
+
+        if (m_overflowSize.load(std::memory_order_acquire) > 0) {
+            std::lock_guard<std::mutex> lock(m_overflowMutex);
+            if (!m_overflow.empty()) {
+                task = m_overflow.front();
+                m_overflow.pop_front();
+                m_overflowSize.fetch_sub(1, std::memory_order_relaxed);
+                return task;
+            }
+        }
+
+        if (m_lanes->backgroundSize() > 0 && acquireBackgroundSlot()) {
+            if (m_lanes->popBackground(task)) {
+                background = true;
+                return task;
+            }
+            releaseBackgroundSlot();
+        }
+        return nullptr;
+    }
+
+    bool QPyThreadPool::acquireBackgroundSlot() {
+        if (m_backgroundRunning.fetch_add(1, std::memory_order_acquire) < m_maxBackground)
+            return true;
+        m_backgroundRunning.fetch_sub(1, std::memory_order_release);
+        return false;
+    }
+
+    void QPyThreadPool::releaseBackgroundSlot() {
+        // A background task may be waiting for exactly this slot while its worker sleeps.
+        if (m_backgroundRunning.fetch_sub(1, std::memory_order_release) == m_maxBackground &&
+            m_lanes->backgroundSize() > 0)
+            notifySubmitted(1);
+    }
+
+    void QPyThreadPool::runTask(size_t index, QPyFuture* task, bool background) {
+        m_affinity->record(task->moduleId(), int(index));
+        {
+            pybind11::gil_scoped_acquire gil;
+            (*task)();
+            if (task->state() == QPyFutureState::Running) {
+                // awaited on this worker's event loop, counted once it ends
+                task->then([this](const QPyFuture& done) { recordCompletion(done); });
+            } else {
+                recordCompletion(*task);
+            }
+            // The task may hold the last references to Python objects.
+            delete task;
+        }
+        if (background)
+            releaseBackgroundSlot();
+    }
+
+    void QPyThreadPool::recordCompletion(const QPyFuture& task) {
+        const QPyFutureState state = task.state();
+        if (state == QPyFutureState::TimedOut)
+            m_timeouts.fetch_add(1, std::memory_order_relaxed);
+        if (state == QPyFutureState::Canceled || state == QPyFutureState::TimedOut)
+            return;
+        m_completed[size_t(task.options().priority)].fetch_add(1, std::memory_order_relaxed);
+        const auto deadline = task.deadline();
+        if (!deadline)
+            return;
+        const auto late = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - *deadline).count();
+        if (late <= 0)
+            return;
+        m_deadlineMisses.fetch_add(1, std::memory_order_relaxed);
+        qint64 worst = m_worstLatenessUs.load(std::memory_order_relaxed);
+        while (late > worst && !m_worstLatenessUs.compare_exchange_weak(worst, late, std::memory_order_relaxed)) {
+        }
+    }
+
+    QPySchedulerStats QPyThreadPool::schedulerStats() const {
+        QPySchedulerStats stats;
+        stats.background = m_completed[size_t(QPyPriority::Background)].load(std::memory_order_relaxed);
+        stats.normal = m_completed[size_t(QPyPriority::Normal)].load(std::memory_order_relaxed);
+        stats.interactive = m_completed[size_t(QPyPriority::Interactive)].load(std::memory_order_relaxed);
+        stats.agedPromotions = m_agedPromotions.load(std::memory_order_relaxed);
+        stats.deadlineMisses = m_deadlineMisses.load(std::memory_order_relaxed);
+        stats.timeouts = m_timeouts.load(std::memory_order_relaxed);
+        stats.worstLateness = std::chrono::microseconds(m_worstLatenessUs.load(std::memory_order_relaxed));
+        return stats;
+    }
+
+    void QPyThreadPool::enqueue(QPyFuture* task) {
+        const QPyCallOptions& options = task->options();
+        if (const auto deadline = task->deadline()) {
+            m_lanes->pushUrgent(task, *deadline);
+            return;
+        }
+        if (options.priority == QPyPriority::Background) {
+            m_lanes->pushBackground(task, task->createdAt());
+            return;
+        }
+        if (t_pool == this) {
+            // Nested submission: LIFO on the own deque, where idle workers can steal it.
+            m_workers[t_workerIndex]->local.push(task);
+            return;
+        }
+        const size_t n = m_workers.size();
+        int idx = m_affinity->lookup(task->moduleId());
+        if (idx < 0 || size_t(idx) >= n) {
+            idx = int(m_nextWorker.fetch_add(1, std::memory_order_relaxed) % n);
+            m_affinity->record(task->moduleId(), idx);
+        }
+        for (size_t k = 0; k < n; ++k) {
+            if (m_workers[(size_t(idx) + k) % n]->inbox.tryPush(task))
+                return;
+        }
+        // Every inbox is full: never drop a task, park it in the shared overflow list.
+        std::lock_guard<std::mutex> lock(m_overflowMutex);
+        m_overflow.push_back(task);
+        m_overflowSize.fetch_add(1, std::memory_order_release);
+    }
+
+    void QPyThreadPool::wakeSleepers(size_t count) {
+        m_wakeEpoch.fetch_add(1, std::memory_order_seq_cst);
+        const int sleepers = m_sleepers.load(std::memory_order_seq_cst);
+        if (sleepers <= 0 || count == 0)
+            return;
+        std::lock_guard<std::mutex> lock(m_parkMutex);
+        if (count >= size_t(sleepers)) {
+            m_parkCondition.notify_all();
+        } else {
+            for (size_t i = 0; i < count; ++i)
+                m_parkCondition.notify_one();
+        }
+    }
+
+    void QPyThreadPool::notifySubmitted(size_t count) {
+        // A spinning worker will find the new tasks and, being the last spinner, wake the next
+        // sleeper itself; only the remainder needs a notify.
+        const int spinning = m_spinning.load(std::memory_order_seq_cst);
+        wakeSleepers(count > size_t(spinning) ? count - size_t(spinning) : 0);
+    }
+
+    void QPyThreadPool::initialize(size_t threadCount, bool useSubInterpreters, bool eventLoops) {
         _threadCount = threadCount;
         _useSubInterpreters = useSubInterpreters;
+        _eventLoops = eventLoops;
     }
 
     QPyThreadPool& QPyThreadPool::instance() {
@@ -45,7 +317,7 @@ namespace qtpyt {
             }
             Py_Initialize();
 
-            singleton = std::unique_ptr<QPyThreadPool>(new QPyThreadPool(_threadCount, _useSubInterpreters));
+            singleton = std::unique_ptr<QPyThreadPool>(new QPyThreadPool(_threadCount, _useSubInterpreters, _eventLoops));
             _initialized = true;
         }
         return *singleton;
@@ -57,33 +329,64 @@ namespace qtpyt {
     }
 
     void QPyThreadPool::submit(QPyFuture future) {
-        auto key = future.callablePtr();
-        static std::atomic<size_t> rr{0};
-        size_t idx = rr.fetch_add(1) % tasks_.size();
-        if (m_threadCallableMap_.contains(key)) {
-            idx = m_threadCallableMap_[key];
-        } else {
-            m_threadCallableMap_[key] = static_cast<int>(idx);
-        }
-        tasks_[idx]->push(std::move(future));
+        if (stop_.load(std::memory_order_acquire))
+            return;
+        enqueue(new QPyFuture(std::move(future)));
+        notifySubmitted(1);
+    }
+
+    void QPyThreadPool::submitBatch(std::vector<QPyFuture>&& futures) {
+        if (futures.empty() || stop_.load(std::memory_order_acquire))
+            return;
+        for (auto& f : futures)
+            enqueue(new QPyFuture(std::move(f)));
+        const size_t count = futures.size();
+        futures.clear();
+        notifySubmitted(count);
     }
 
     void QPyThreadPool::shutdown() {
         if (bool expected = false; !stop_.compare_exchange_strong(expected, true))
             return;
 
-        // close all queues so workers unblock
-        for (auto& q : tasks_)
-            q->close();
+        {
+            std::lock_guard<std::mutex> lock(m_parkMutex);
+            m_parkCondition.notify_all();
+        }
 
         for (auto& t : workers_) {
             if (t.joinable())
                 t.join();
         }
         workers_.clear();
+        // no call runs any more, and the watchdog must not touch Python after finalization
+        QPyWatchdog::instance().stop();
+
+        // drop the tasks that never ran
+        for (auto& w : m_workers) {
+            QPyFuture* task = nullptr;
+            while (w->local.pop(task))
+                delete task;
+            while (w->inbox.tryPop(task))
+                delete task;
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_overflowMutex);
+            for (QPyFuture* task : m_overflow)
+                delete task;
+            m_overflow.clear();
+            m_overflowSize.store(0, std::memory_order_relaxed);
+        }
+        {
+            QPyFuture* task = nullptr;
+            while (m_lanes->popUrgent(task))
+                delete task;
+            while (m_lanes->popBackground(task))
+                delete task;
+        }
 
         if (_useSubInterpreters) {
 
         }
     }
-} // namespace qtpyt
\ No newline at end of file
+} // namespace qtpyt
@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/embed.h>
+#include <pybind11/complex.h>
 
 #include <QVariant>
 #include <QString>
@@ -15,6 +16,9 @@
 #include "../src/conversions.h"
 #include  <qtpyt/qpysharedarray.h>
 
+#include <complex>
+#include <QtCore/qfloat16.h>
+
 namespace py = pybind11;
 
 TEST(Conversions, IntRoundtrip) {
@@ -393,6 +397,102 @@ TEST(Conversions, QSharedArrayUShortRoundTrip) {
     }
 }
 
+TEST(Conversions, QSharedArrayFloatBufferIsConvertedNotReinterpreted) {
+    py::object arr = py::module_::import("array").attr("array")("f", py::make_tuple(1.5, -2.0, 300.25));
+
+    auto outOpt = qtpyt::pyObjectToQVariant(arr, QByteArray("QPySharedArray<int>"));
+    ASSERT_TRUE(outOpt.has_value());
+    auto out = outOpt->value<qtpyt::QPySharedArray<int>>();
+    ASSERT_EQ(out.size(), 3);
+    EXPECT_EQ(out[0], 1);
+    EXPECT_EQ(out[1], -2);
+    EXPECT_EQ(out[2], 300);
+}
+
+TEST(Conversions, QSharedArrayDoubleBufferToFloat) {
+    py::object arr = py::module_::import("array").attr("array")("d", py::make_tuple(0.5, 1.25));
+
+    auto outOpt = qtpyt::pyObjectToQVariant(arr, QByteArray("QPySharedArray<float>"));
+    ASSERT_TRUE(outOpt.has_value());
+    auto out = outOpt->value<qtpyt::QPySharedArray<float>>();
+    ASSERT_EQ(out.size(), 2);
+    EXPECT_FLOAT_EQ(out[0], 0.5f);
+    EXPECT_FLOAT_EQ(out[1], 1.25f);
+}
+
+TEST(Conversions, QSharedArrayComplexIsZeroCopy) {
+    qtpyt::QPySharedArray<std::complex<float>> arr(3);
+    arr[2] = {1.5f, -2.0f};
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    ASSERT_TRUE(py::isinstance<py::memoryview>(view));
+    EXPECT_EQ(view.attr("format").cast<std::string>(), "Zf");
+    EXPECT_EQ(view.attr("itemsize").cast<int>(), 8);
+    // memoryview has no unpacker for "Zf"; the documented way in is through the raw bytes.
+    EXPECT_THROW(py::object(view[py::int_(2)]), py::error_already_set);
+    py::list parts = view.attr("cast")("B").attr("cast")("f").attr("tolist")();
+    EXPECT_FLOAT_EQ(parts[4].cast<float>(), 1.5f);
+    EXPECT_FLOAT_EQ(parts[5].cast<float>(), -2.0f);
+
+    auto outOpt = qtpyt::pyObjectToQVariant(view, QByteArray("QPySharedArray<std::complex<float>>"));
+    ASSERT_TRUE(outOpt.has_value());
+    auto out = outOpt->value<qtpyt::QPySharedArray<std::complex<float>>>();
+    EXPECT_EQ(out.constData(), arr.constData());
+    EXPECT_EQ(out[2], std::complex<float>(1.5f, -2.0f));
+
+    py::list values;
+    values.append(py::cast(std::complex<double>(0.5, 1.0)));
+    auto fromList = qtpyt::pyObjectToQVariant(values, QByteArray("QPySharedArray<std::complex<double>>"));
+    ASSERT_TRUE(fromList.has_value());
+    EXPECT_EQ(fromList->value<qtpyt::QPySharedArray<std::complex<double>>>()[0], std::complex<double>(0.5, 1.0));
+}
+
+TEST(Conversions, QSharedArrayHalfFloat) {
+    qtpyt::QPySharedArray<qfloat16> arr(2);
+    arr[1] = qfloat16(0.25f);
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    EXPECT_EQ(view.attr("format").cast<std::string>(), "e");
+    EXPECT_FLOAT_EQ(view[py::int_(1)].cast<float>(), 0.25f);
+
+    auto outOpt = qtpyt::pyObjectToQVariant(py::make_tuple(1.5, 2.0), QByteArray("QPySharedArray<qfloat16>"));
+    ASSERT_TRUE(outOpt.has_value());
+    auto out = outOpt->value<qtpyt::QPySharedArray<qfloat16>>();
+    ASSERT_EQ(out.size(), 2);
+    EXPECT_EQ(float(out[0]), 1.5f);
+    EXPECT_EQ(float(out[1]), 2.0f);
+}
+
+TEST(Conversions, QSharedArrayBytesAndInt8) {
+    py::bytes raw(std::string("\x01\xff", 2));
+    auto bytesOpt = qtpyt::pyObjectToQVariant(raw, QByteArray("QPySharedArray<std::byte>"));
+    ASSERT_TRUE(bytesOpt.has_value());
+    auto bytes = bytesOpt->value<qtpyt::QPySharedArray<std::byte>>();
+    ASSERT_EQ(bytes.size(), 2);
+    EXPECT_EQ(bytes[1], std::byte{0xff});
+
+    auto int8Opt = qtpyt::pyObjectToQVariant(raw, QByteArray("QPySharedArray<signed char>"));
+    ASSERT_TRUE(int8Opt.has_value());
+    auto int8 = int8Opt->value<qtpyt::QPySharedArray<qint8>>();
+    ASSERT_EQ(int8.size(), 2);
+    EXPECT_EQ(int8[1], qint8(-1));
+    py::object view = qtpyt::qvariantToPyObject(*int8Opt);
+    EXPECT_EQ(view.attr("format").cast<std::string>(), "b");
+}
+
+TEST(Conversions, QSharedArrayCharFromBytesIsZeroCopy) {
+    py::bytes raw(std::string("abc"));
+    auto outOpt = qtpyt::pyObjectToQVariant(raw, QByteArray("QPySharedArray<char>"));
+    ASSERT_TRUE(outOpt.has_value());
+    auto out = outOpt->value<qtpyt::QPySharedArray<char>>();
+    ASSERT_EQ(out.size(), 3);
+    EXPECT_EQ(out.constData(), PyBytes_AsString(raw.ptr()));
+    EXPECT_TRUE(out.isReadOnly());
+
+    // bytes are immutable: writing detaches into owned storage
+    out.data()[0] = 'x';
+    EXPECT_NE(out.constData(), PyBytes_AsString(raw.ptr()));
+    EXPECT_EQ(std::string(raw), "abc");
+}
+
 TEST(Conversions, QVectorBoolRoundTrip) {
     qtpyt::registerContainerType<QVector<bool>>("QVector<bool>");
 
@@ -1,6 +1,18 @@
 #include <gtest/gtest.h>
 #include "qtpyt/qpymodule.h"
 #include "qtpyt/qpyfuture.h"
+#include "qtpyt/qpythreadpool.h"
+#include "qtpyt/qpytask.h"
+#include "../src/internal/q_py_watchdog.h"
+
+#include <QFuture>
+#include <QThread>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <mutex>
+#include <vector>
+
 TEST(QPyFuture, QPyFutureRun) {
     auto m = qtpyt::QPyModule("def test_func(x, y):\n"
                            "    return x + y\n", qtpyt::QPySourceType::SourceString);
@@ -12,3 +24,404 @@ TEST(QPyFuture, QPyFutureRun) {
     EXPECT_EQ(res, 6.0);
 }
 
+
+namespace {
+    struct CancelCounter : qtpyt::IQPyFutureNotifier {
+        void notifyStarted() override {}
+        void notifyFinished(const QVariant&) override {}
+        void notifyResultAvailable(const QVariant&) override {}
+        void notifyErrorOccurred(const QString&) override {}
+        void notifyCanceled() override { ++canceled; }
+        std::atomic<int> canceled{0};
+    };
+}
+
+TEST(QPyFuture, CancelBeforeStartSkipsTheCall) {
+    auto m = qtpyt::QPyModule("calls = 0\n"
+                           "def test_func():\n"
+                           "    global calls\n"
+                           "    calls += 1\n"
+                           "def get_calls():\n"
+                           "    return calls\n", qtpyt::QPySourceType::SourceString);
+    auto counter = QSharedPointer<CancelCounter>::create();
+    qtpyt::QPyFuture future(m, counter, "test_func", "void", {});
+    EXPECT_TRUE(future.cancel());
+    future.run();
+    EXPECT_EQ(future.state(), qtpyt::QPyFutureState::Canceled);
+    EXPECT_EQ(counter->canceled.load(), 1);
+    EXPECT_FALSE(future.cancel());
+    EXPECT_EQ(m.call<int>("get_calls"), 0);
+}
+
+TEST(QPyFuture, CancelInterruptsRunningCall) {
+    auto m = qtpyt::QPyModule("import time\n"
+                           "def spin():\n"
+                           "    while True:\n"
+                           "        time.sleep(0.001)\n", qtpyt::QPySourceType::SourceString);
+    auto counter = QSharedPointer<CancelCounter>::create();
+    auto f = m.callAsync<>(counter, "spin", QMetaType::Void).value();
+    for (int i = 0; i < 1000 && f.state() == qtpyt::QPyFutureState::NotStarted; ++i)
+        QThread::msleep(1);
+    ASSERT_EQ(f.state(), qtpyt::QPyFutureState::Running);
+    EXPECT_TRUE(f.cancel());
+    f.waitForFinished();
+    EXPECT_EQ(f.state(), qtpyt::QPyFutureState::Canceled);
+    EXPECT_EQ(counter->canceled.load(), 1);
+}
+
+TEST(QPyFuture, CooperativeLoopSeesCancelRequest) {
+    auto m = qtpyt::QPyModule("import qpyasync\n"
+                           "def outside():\n"
+                           "    return qpyasync.cancelled()\n"
+                           "seen = False\n"
+                           "def saw_cancel():\n"
+                           "    return seen\n"
+                           "def work():\n"
+                           "    global seen\n"
+                           "    n = 0\n"
+                           "    while True:\n"
+                           "        try:\n"
+                           "            if qpyasync.cancelled():\n"
+                           "                seen = True\n"
+                           "                return n\n"
+                           "            n += 1\n"
+                           "        except qpyasync.CancelledError:\n"
+                           "            pass\n", qtpyt::QPySourceType::SourceString);
+    EXPECT_FALSE(m.call<bool>("outside"));
+    auto f = m.callAsync<>(nullptr, "work", QMetaType::Int).value();
+    for (int i = 0; i < 1000 && f.state() == qtpyt::QPyFutureState::NotStarted; ++i)
+        QThread::msleep(1);
+    EXPECT_TRUE(f.cancel());
+    f.waitForFinished();
+    EXPECT_EQ(f.state(), qtpyt::QPyFutureState::Canceled);
+    // the injected CancelledError is swallowed, so only the poll can end the loop
+    EXPECT_TRUE(m.call<bool>("saw_cancel"));
+}
+
+TEST(QPyWatchdog, FiresInExpiryOrderAndHonoursDisarm) {
+    using namespace std::chrono_literals;
+    qtpyt::QPyWatchdog watchdog;
+    std::mutex mutex;
+    std::vector<int> fired;
+    const auto now = qtpyt::QPyWatchdog::Clock::now();
+    auto record = [&](int id) {
+        return [&, id] {
+            std::lock_guard<std::mutex> lock(mutex);
+            fired.push_back(id);
+        };
+    };
+    watchdog.arm(now + 30ms, record(3));
+    watchdog.arm(now + 10ms, record(1));
+    const auto token = watchdog.arm(now + 20ms, record(2));
+    watchdog.disarm(token);
+    for (int i = 0; i < 500 && watchdog.armed() > 0; ++i)
+        QThread::msleep(1);
+    watchdog.stop();
+    std::lock_guard<std::mutex> lock(mutex);
+    EXPECT_EQ(fired, (std::vector<int>{1, 3}));
+}
+
+TEST(QPyFuture, TimeoutInterruptsRunawayCall) {
+    using namespace std::chrono_literals;
+    auto m = qtpyt::QPyModule("def spin():\n"
+                           "    n = 0\n"
+                           "    while True:\n"
+                           "        n += 1\n", qtpyt::QPySourceType::SourceString);
+    auto& pool = qtpyt::QPyThreadPool::instance();
+    const auto before = pool.schedulerStats().timeouts;
+    auto f = m.callAsync(qtpyt::QPyCallOptions::withTimeout(50ms), nullptr, "spin", QMetaType::Void).value();
+    f.waitForFinished();
+    EXPECT_EQ(f.state(), qtpyt::QPyFutureState::TimedOut);
+    EXPECT_TRUE(f.errorMessage().contains("timed out"));
+    for (int i = 0; i < 100 && pool.schedulerStats().timeouts == before; ++i)
+        QThread::msleep(1);
+    EXPECT_EQ(pool.schedulerStats().timeouts, before + 1);
+
+    // the worker is free again
+    auto m2 = qtpyt::QPyModule("def one():\n"
+                            "    return 1\n", qtpyt::QPySourceType::SourceString);
+    auto g = m2.callAsync<>(nullptr, "one", QMetaType::Int).value();
+    g.waitForFinished();
+    EXPECT_EQ(g.resultAs<int>(0), 1);
+}
+
+TEST(QPyFuture, SynchronousCallTimesOut) {
+    using namespace std::chrono_literals;
+    auto m = qtpyt::QPyModule("def spin():\n"
+                           "    while True:\n"
+                           "        pass\n"
+                           "def quick():\n"
+                           "    return 2\n", qtpyt::QPySourceType::SourceString);
+    const auto slow = m.call("spin", QMetaType::Void, {}, {}, 50ms);
+    EXPECT_FALSE(slow.first.has_value());
+    EXPECT_TRUE(slow.second.contains("timed out"));
+    const auto fast = m.call("quick", QMetaType::Int, {}, {}, 1000ms);
+    ASSERT_TRUE(fast.first.has_value());
+    EXPECT_EQ(fast.first->toInt(), 2);
+}
+
+TEST(QPyFuture, WaitForFinishedOffTheGuiThread) {
+    auto m = qtpyt::QPyModule("def add(x, y):\n"
+                           "    return x + y\n", qtpyt::QPySourceType::SourceString);
+    auto f = m.callAsync(nullptr, "add", QMetaType::Int, 2, 3).value();
+    std::thread waiter([&f] { f.waitForFinished(); });
+    waiter.join();
+    EXPECT_EQ(f.state(), qtpyt::QPyFutureState::Finished);
+    EXPECT_EQ(f.resultAs<int>(0), 5);
+}
+
+TEST(QPyFuture, ToQFutureCarriesResultAndErrors) {
+    auto m = qtpyt::QPyModule("def add(x, y):\n"
+                           "    return x + y\n"
+                           "def boom():\n"
+                           "    raise ValueError('boom')\n", qtpyt::QPySourceType::SourceString);
+    QFuture<QVariant> ok = m.callAsync(nullptr, "add", QMetaType::Int, 20, 22).value().toQFuture();
+    ok.waitForFinished();
+    EXPECT_EQ(ok.result().toInt(), 42);
+
+    QFuture<QVariant> failed = m.callAsync(nullptr, "boom", QMetaType::Int).value().toQFuture();
+    EXPECT_THROW(failed.waitForFinished(), std::runtime_error);
+}
+
+TEST(QPyFuture, ThenPassesThePythonResultToTheNextStage) {
+    auto m = qtpyt::QPyModule("class Box:\n"
+                           "    def __init__(self, n):\n"
+                           "        self.n = n\n"
+                           "def make(n):\n"
+                           "    return Box(n)\n"
+                           "def unbox(box):\n"
+                           "    return box.n\n"
+                           "def twice(x):\n"
+                           "    return 2 * x\n"
+                           "def boom(x):\n"
+                           "    raise ValueError('boom')\n", qtpyt::QPySourceType::SourceString);
+    // Box has no Qt equivalent, so it can only reach unbox() as the raw Python object
+    auto first = m.callAsync(nullptr, "make", QMetaType::Void, 21).value();
+    auto last = first.then("unbox", QMetaType::Int).then("twice", QMetaType::Int);
+    last.waitForFinished();
+    ASSERT_EQ(last.state(), qtpyt::QPyFutureState::Finished);
+    EXPECT_EQ(last.resultAs<int>(0), 42);
+
+    // chaining onto a call that has already finished goes through the pool
+    auto late = last.then("twice", QMetaType::Int);
+    late.waitForFinished();
+    EXPECT_EQ(late.resultAs<int>(0), 84);
+
+    std::promise<QString> failure;
+    auto failed = m.callAsync(nullptr, "twice", QMetaType::Int, 1).value().then("boom", QMetaType::Int);
+    auto skipped = failed.then("twice", QMetaType::Int);
+    skipped.onFailed([&failure](const QString& message) { failure.set_value(message); });
+    auto message = failure.get_future();
+    ASSERT_EQ(message.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(failed.state(), qtpyt::QPyFutureState::Error);
+    EXPECT_EQ(skipped.state(), qtpyt::QPyFutureState::Error);
+    const QString text = message.get();
+    EXPECT_TRUE(text.startsWith("previous stage failed:"));
+    EXPECT_TRUE(text.contains("boom"));
+}
+
+TEST(QPyFuture, WhenAllAndWhenAnyFireOnce) {
+    auto m = qtpyt::QPyModule("def add(x, y):\n"
+                           "    return x + y\n", qtpyt::QPySourceType::SourceString);
+    QList<qtpyt::QPyFuture> futures;
+    for (int i = 0; i < 4; ++i) {
+        futures.append(m.callAsync(nullptr, "add", QMetaType::Int, i, i).value());
+    }
+    std::atomic<int> allCalls{0};
+    std::atomic<int> anyCalls{0};
+    std::atomic<int> sum{0};
+    qtpyt::QPyFuture::whenAll(futures, [&](const QList<qtpyt::QPyFuture>& done) {
+        for (const auto& f : done) {
+            sum += f.resultAsVariant(0).toInt();
+        }
+        ++allCalls;
+    });
+    qtpyt::QPyFuture::whenAny(futures, [&](const qtpyt::QPyFuture& f) {
+        EXPECT_EQ(f.state(), qtpyt::QPyFutureState::Finished);
+        ++anyCalls;
+    });
+    // continuations run right after completion, on the worker
+    for (int i = 0; i < 1000 && (allCalls == 0 || anyCalls == 0); ++i)
+        QThread::msleep(1);
+    QThread::msleep(10);
+    EXPECT_EQ(allCalls.load(), 1);
+    EXPECT_EQ(anyCalls.load(), 1);
+    EXPECT_EQ(sum.load(), 12);
+
+    bool emptyFired = false;
+    qtpyt::QPyFuture::whenAll({}, [&emptyFired](const QList<qtpyt::QPyFuture>&) { emptyFired = true; });
+    EXPECT_TRUE(emptyFired);
+}
+
+namespace {
+    struct ResultCounter : qtpyt::IQPyFutureNotifier {
+        void notifyStarted() override {}
+        void notifyFinished(const QVariant&) override {}
+        void notifyResultAvailable(const QVariant&) override { ++results; }
+        void notifyErrorOccurred(const QString&) override {}
+        std::atomic<int> results{0};
+    };
+}
+
+TEST(QPyFuture, GeneratorStreamsResultsWithBackpressure) {
+    auto m = qtpyt::QPyModule("produced = 0\n"
+                           "def scan(n):\n"
+                           "    global produced\n"
+                           "    for i in range(n):\n"
+                           "        produced = i + 1\n"
+                           "        yield i * 10\n", qtpyt::QPySourceType::SourceString);
+    auto f = m.callAsync(qtpyt::QPyCallOptions::streaming(2), nullptr, "scan", QMetaType::Int, 100).value();
+    for (int i = 0; i < 1000 && f.resultCount() < 2; ++i)
+        QThread::msleep(1);
+    QThread::msleep(20);
+    // two results wait in the buffer and the third is held back until one is taken
+    EXPECT_EQ(f.resultCount(), 2);
+    EXPECT_EQ(f.state(), qtpyt::QPyFutureState::Running);
+    EXPECT_EQ(m.readVariable<int>("produced"), 3);
+
+    QList<int> values;
+    while (const auto value = f.waitForResult()) {
+        values.append(value->toInt());
+    }
+    ASSERT_EQ(values.size(), 100);
+    EXPECT_EQ(values.first(), 0);
+    EXPECT_EQ(values.last(), 990);
+    EXPECT_EQ(f.state(), qtpyt::QPyFutureState::Finished);
+    EXPECT_FALSE(f.takeResult().has_value());
+
+    // a notifier takes every value: nothing is buffered and the bound never pauses the scan
+    auto counter = QSharedPointer<ResultCounter>::create();
+    auto notified = m.callAsync(qtpyt::QPyCallOptions::streaming(2), counter, "scan", QMetaType::Int, 100).value();
+    notified.waitForFinished();
+    EXPECT_EQ(notified.state(), qtpyt::QPyFutureState::Finished);
+    EXPECT_EQ(counter->results.load(), 100);
+    EXPECT_EQ(notified.resultCount(), 0);
+    EXPECT_EQ(qtpyt::QPyCallOptions().streamBuffer, qtpyt::QPyCallOptions::DefaultStreamBuffer);
+}
+
+TEST(QPyFuture, AsyncGeneratorAndCancelWhilePaused) {
+    auto m = qtpyt::QPyModule("import asyncio\n"
+                           "closed = False\n"
+                           "async def ticks(n):\n"
+                           "    for i in range(n):\n"
+                           "        await asyncio.sleep(0)\n"
+                           "        yield i\n"
+                           "def endless():\n"
+                           "    global closed\n"
+                           "    try:\n"
+                           "        while True:\n"
+                           "            yield 1\n"
+                           "    finally:\n"
+                           "        closed = True\n", qtpyt::QPySourceType::SourceString);
+    auto ticks = m.callAsync(nullptr, "ticks", QMetaType::Int, 3).value();
+    ticks.waitForFinished();
+    ASSERT_EQ(ticks.resultCount(), 3);
+    EXPECT_EQ(ticks.resultAs<int>(2), 2);
+
+    auto endless = m.callAsync(qtpyt::QPyCallOptions::streaming(1), nullptr, "endless", QMetaType::Int).value();
+    for (int i = 0; i < 1000 && endless.resultCount() < 1; ++i)
+        QThread::msleep(1);
+    EXPECT_TRUE(endless.cancel());
+    endless.waitForFinished();
+    EXPECT_EQ(endless.state(), qtpyt::QPyFutureState::Canceled);
+    EXPECT_TRUE(m.readVariable<bool>("closed"));
+}
+
+TEST(QPyFuture, AsyncGeneratorRunsOnTheWorkerLoop) {
+    auto m = qtpyt::QPyModule("import asyncio\n"
+                           "async def ticks(n):\n"
+                           "    for i in range(n):\n"
+                           "        await asyncio.sleep(0)\n"
+                           "        yield i\n"
+                           "async def ping():\n"
+                           "    await asyncio.sleep(0.01)\n"
+                           "    return 7\n"
+                           "async def count_from(n):\n"
+                           "    await asyncio.sleep(0.02)\n"
+                           "    return n\n", qtpyt::QPySourceType::SourceString);
+    // the tests run a single worker: a stream paused on a full buffer must leave it free
+    auto paused = m.callAsync(qtpyt::QPyCallOptions::streaming(1), nullptr, "ticks", QMetaType::Int, 10).value();
+    for (int i = 0; i < 1000 && paused.resultCount() < 1; ++i)
+        QThread::msleep(1);
+    auto ping = m.callAsync(nullptr, "ping", QMetaType::Int).value();
+    ping.waitForFinished();
+    ASSERT_EQ(ping.state(), qtpyt::QPyFutureState::Finished);
+    EXPECT_EQ(ping.resultAs<int>(0), 7);
+    EXPECT_EQ(paused.state(), qtpyt::QPyFutureState::Running);
+    QList<int> values;
+    while (const auto value = paused.waitForResult())
+        values.append(value->toInt());
+    EXPECT_EQ(values.size(), 10);
+    EXPECT_EQ(paused.state(), qtpyt::QPyFutureState::Finished);
+
+    // a stage chained after an awaited coroutine runs inside the loop, and streams from there
+    auto first = m.callAsync(nullptr, "count_from", QMetaType::Int, 4).value();
+    auto stage = first.then("ticks", QMetaType::Int);
+    for (int i = 0; i < 5000 && !stage.isCompleted(); ++i)
+        QThread::msleep(1);
+    ASSERT_EQ(stage.state(), qtpyt::QPyFutureState::Finished) << stage.errorMessage().toStdString();
+    ASSERT_EQ(stage.resultCount(), 4);
+    EXPECT_EQ(stage.resultAs<int>(3), 3);
+}
+
+namespace {
+    qtpyt::QPyTask<int> addTwice(qtpyt::QPyModule m) {
+        const QVariant first = co_await m.callAsync(nullptr, "add", QMetaType::Int, 1, 2);
+        const QVariant second = co_await m.callAsync(nullptr, "add", QMetaType::Int, first.toInt(), 10);
+        co_return second.toInt();
+    }
+
+    qtpyt::QPyTask<QString> catchFailure(qtpyt::QPyModule m) {
+        try {
+            co_await m.callAsync(nullptr, "boom", QMetaType::Int);
+        } catch (const std::runtime_error& e) {
+            co_return QString::fromStdString(e.what());
+        }
+        co_return QString();
+    }
+
+    qtpyt::QPyTask<> recordResumeThread(qtpyt::QPyModule m, std::promise<QThread*>& resumedOn) {
+        co_await m.callAsync(nullptr, "add", QMetaType::Int, 1, 1);
+        resumedOn.set_value(QThread::currentThread());
+    }
+
+    template <typename T>
+    bool waitUntilDone(const qtpyt::QPyTask<T>& task) {
+        for (int i = 0; i < 5000 && !task.isDone(); ++i)
+            QThread::msleep(1);
+        return task.isDone();
+    }
+}
+
+TEST(QPyTask, CoAwaitChainsCallsAndRethrowsErrors) {
+    auto m = qtpyt::QPyModule("def add(x, y):\n"
+                           "    return x + y\n"
+                           "def boom():\n"
+                           "    raise ValueError('boom')\n", qtpyt::QPySourceType::SourceString);
+    // no event loop on this thread: the coroutine resumes on the worker
+    auto sum = addTwice(m);
+    ASSERT_TRUE(waitUntilDone(sum));
+    EXPECT_EQ(sum.result(), 13);
+
+    auto failure = catchFailure(m);
+    ASSERT_TRUE(waitUntilDone(failure));
+    EXPECT_TRUE(failure.result().contains("boom"));
+}
+
+TEST(QPyTask, ResumesOnTheAwaitingThread) {
+    auto m = qtpyt::QPyModule("def add(x, y):\n"
+                           "    return x + y\n", qtpyt::QPySourceType::SourceString);
+    QThread thread;
+    thread.start();
+    QObject starter;
+    starter.moveToThread(&thread);
+    std::promise<QThread*> resumedOn;
+    QMetaObject::invokeMethod(&starter, [&m, &resumedOn] {
+        recordResumeThread(m, resumedOn);
+    }, Qt::QueuedConnection);
+    auto resumed = resumedOn.get_future();
+    ASSERT_EQ(resumed.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(resumed.get(), &thread);
+    thread.quit();
+    thread.wait();
+}
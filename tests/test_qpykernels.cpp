@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/embed.h>
+
+#include <QVariant>
+
+#include "../src/conversions.h"
+#include <qtpyt/qpykernels.h>
+
+#include <cmath>
+
+namespace py = pybind11;
+using namespace qtpyt;
+
+namespace {
+    // Large enough to be split across threads with the default threshold.
+    constexpr qsizetype kLarge = 1'000'003;
+}
+
+TEST(QPyKernels, BinaryAndScalarOps) {
+    QPySharedArray<float> a(kLarge), b(kLarge);
+    for (qsizetype i = 0; i < kLarge; ++i) {
+        a[i] = float(i % 100);
+        b[i] = 2.0f;
+    }
+    kernels::apply(QPyKernelOp::Mul, a, b);
+    kernels::apply(QPyKernelOp::Add, a, 1.0f);
+    EXPECT_FLOAT_EQ(a[0], 1.0f);
+    EXPECT_FLOAT_EQ(a[kLarge - 1], float(((kLarge - 1) % 100) * 2 + 1));
+}
+
+TEST(QPyKernels, IntegerDivisionByZeroYieldsZero) {
+    QPySharedArray<qint32> a(3);
+    a[0] = 7; a[1] = -7; a[2] = 0;
+    kernels::apply(QPyKernelOp::Div, a, qint32(0));
+    EXPECT_EQ(a[0], 0);
+    EXPECT_EQ(a[1], 0);
+}
+
+TEST(QPyKernels, Reductions) {
+    QPySharedArray<double> a(kLarge);
+    for (qsizetype i = 0; i < kLarge; ++i)
+        a[i] = double(i);
+    const double n = double(kLarge);
+    EXPECT_DOUBLE_EQ(kernels::sum(a), n * (n - 1) / 2);
+    const auto mm = kernels::minMax(a);
+    EXPECT_EQ(mm.first, 0.0);
+    EXPECT_EQ(mm.second, n - 1);
+    const QPyMoments mo = kernels::moments(a);
+    EXPECT_NEAR(mo.mean, (n - 1) / 2, 1e-6);
+    EXPECT_NEAR(mo.variance, (n * n - 1) / 12, 1e-6 * mo.variance);
+}
+
+TEST(QPyKernels, ScalarDispatchMatchesBest) {
+    QPySharedArray<quint8> a(kLarge);
+    for (qsizetype i = 0; i < kLarge; ++i)
+        a[i] = quint8(i * 31);
+    const double best = kernels::sum(a);
+    kernels::setSimdLevel(QPySimdLevel::Scalar);
+    EXPECT_EQ(kernels::sum(a), best);
+    kernels::setSimdLevel(kernels::detectedSimdLevel());
+}
+
+TEST(QPyKernels, InclusiveScanAcrossPartitions) {
+    QPySharedArray<qint64> a(kLarge);
+    for (qsizetype i = 0; i < kLarge; ++i)
+        a[i] = 1;
+    kernels::inclusiveScan(a);
+    EXPECT_EQ(a[0], 1);
+    EXPECT_EQ(a[kLarge / 2], kLarge / 2 + 1);
+    EXPECT_EQ(a[kLarge - 1], kLarge);
+}
+
+TEST(QPyKernels, ConvertScalesAndSaturates) {
+    QPySharedArray<float> f(4);
+    f[0] = -0.5f; f[1] = 0.0f; f[2] = 0.5f; f[3] = 2.0f;
+    auto u = kernels::converted<quint8>(f, 255.0);
+    EXPECT_EQ(u[0], 0);
+    EXPECT_EQ(u[2], 127);
+    EXPECT_EQ(u[3], 255);
+    auto back = kernels::converted<float>(u, 1.0 / 255.0);
+    EXPECT_FLOAT_EQ(back[3], 1.0f);
+}
+
+TEST(QPyKernels, PythonModuleRunsInPlace) {
+    py::gil_scoped_acquire gil;
+    py::module_ k = py::module_::import("qt_interop").attr("kernels");
+    QPySharedArray<double> arr(5);
+    for (int i = 0; i < 5; ++i)
+        arr[i] = i;
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    k.attr("multiply")(view, 3.0);
+    // the view shares the storage; read through constData() so the array does not detach
+    EXPECT_DOUBLE_EQ(arr.constData()[4], 12.0);
+    EXPECT_DOUBLE_EQ(k.attr("sum")(view).cast<double>(), 30.0);
+    k.attr("clip")(view, 1.0, 10.0);
+    EXPECT_DOUBLE_EQ(arr.constData()[0], 1.0);
+    EXPECT_DOUBLE_EQ(arr.constData()[4], 10.0);
+}
+
+TEST(QPyKernels, PythonModuleRejectsTypesWithoutKernels) {
+    py::gil_scoped_acquire gil;
+    py::module_ k = py::module_::import("qt_interop").attr("kernels");
+    py::module_ array = py::module_::import("array");
+    for (const char* code : {"b", "H", "I", "Q"}) {
+        py::object buf = array.attr("array")(code, py::make_tuple(1, 2, 3));
+        try {
+            k.attr("sum")(buf);
+            ADD_FAILURE() << "format " << code << " was accepted";
+        } catch (py::error_already_set& e) {
+            EXPECT_TRUE(e.matches(PyExc_TypeError)) << code;
+        }
+    }
+}
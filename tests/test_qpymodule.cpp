@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include "qtpyt/qpymodule.h"
 
+#include <QElapsedTimer>
 #include <QVector3D>
 #include <utility>
 #include <utility>
@@ -157,6 +158,139 @@ TEST(QPyModule, TestQPyFutureNotifier) {
     EXPECT_TRUE(notified);
 }
 
+TEST(QPyModule, InteractiveCallOvertakesQueuedBackgroundWork) {
+    auto m = qtpyt::QPyModule("import time\n"
+                           "order = []\n"
+                           "def batch(i):\n"
+                           "    time.sleep(0.02)\n"
+                           "    order.append(i)\n"
+                           "def urgent():\n"
+                           "    order.append(-1)\n"
+                           "    return len(order)\n", qtpyt::QPySourceType::SourceString);
+    std::vector<qtpyt::QPyFuture> batch;
+    for (int i = 0; i < 5; ++i)
+        batch.push_back(m.callAsync(qtpyt::QPyCallOptions::background(), nullptr, "batch", QMetaType::Void, i).value());
+    auto f = m.callAsync(qtpyt::QPyCallOptions::interactive(), nullptr, "urgent", QMetaType::Int).value();
+    f.waitForFinished();
+    ASSERT_EQ(f.state(), qtpyt::QPyFutureState::Finished);
+    // at most the batch call that was already running finished before it
+    EXPECT_LE(f.resultAs<int>(0), 2);
+    for (auto& b : batch)
+        b.waitForFinished();
+}
+
+TEST(QPyModule, MissedDeadlineIsCounted) {
+    using namespace std::chrono_literals;
+    auto m = qtpyt::QPyModule("import time\n"
+                           "def slow():\n"
+                           "    time.sleep(0.02)\n", qtpyt::QPySourceType::SourceString);
+    auto& pool = qtpyt::QPyThreadPool::instance();
+    const auto before = pool.schedulerStats().deadlineMisses;
+    qtpyt::QPyCallOptions options;
+    options.deadline = 1ms;
+    auto f = m.callAsync(options, nullptr, "slow", QMetaType::Void).value();
+    f.waitForFinished();
+    // the counter is updated right after the future reports completion
+    for (int i = 0; i < 100 && pool.schedulerStats().deadlineMisses == before; ++i)
+        QThread::msleep(1);
+    const auto stats = pool.schedulerStats();
+    EXPECT_EQ(stats.deadlineMisses, before + 1);
+    EXPECT_GE(stats.worstLateness.count(), 10000);
+}
+
+TEST(QPyModule, InteractiveCallOverrunningItsBudgetIsCounted) {
+    auto m = qtpyt::QPyModule("import time\n"
+                           "def slow():\n"
+                           "    time.sleep(0.02)\n", qtpyt::QPySourceType::SourceString);
+    auto& pool = qtpyt::QPyThreadPool::instance();
+    const auto before = pool.schedulerStats().deadlineMisses;
+    // no explicit deadline: the interactive budget applies
+    auto f = m.callAsync(qtpyt::QPyCallOptions::interactive(), nullptr, "slow", QMetaType::Void).value();
+    ASSERT_TRUE(f.deadline().has_value());
+    EXPECT_EQ(*f.deadline() - f.createdAt(), std::chrono::microseconds(5000));
+    f.waitForFinished();
+    for (int i = 0; i < 100 && pool.schedulerStats().deadlineMisses == before; ++i)
+        QThread::msleep(1);
+    EXPECT_EQ(pool.schedulerStats().deadlineMisses, before + 1);
+}
+
+TEST(QPyModule, CoroutinesShareTheWorkerEventLoop) {
+    auto m = qtpyt::QPyModule("import asyncio\n"
+                           "async def fetch(i):\n"
+                           "    await asyncio.sleep(0.2)\n"
+                           "    return i * 2\n"
+                           "async def hang():\n"
+                           "    await asyncio.sleep(3600)\n", qtpyt::QPySourceType::SourceString);
+    // the tests run a single worker: 20 calls sleeping 0.2 s each only fit in the limit if they overlap
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<qtpyt::QPyFuture> calls;
+    for (int i = 0; i < 20; ++i)
+        calls.push_back(m.callAsync(nullptr, "fetch", QMetaType::Int, i).value());
+    for (int i = 0; i < 20; ++i) {
+        calls[i].waitForFinished();
+        ASSERT_EQ(calls[i].state(), qtpyt::QPyFutureState::Finished);
+        EXPECT_EQ(calls[i].resultAs<int>(0), i * 2);
+    }
+    EXPECT_LT(timer.elapsed(), 2000);
+
+    auto hung = m.callAsync(nullptr, "hang", QMetaType::Void).value();
+    QThread::msleep(20);
+    EXPECT_EQ(hung.state(), qtpyt::QPyFutureState::Running);
+    // the worker is not blocked by the waiting coroutine
+    auto other = m.callAsync(nullptr, "fetch", QMetaType::Int, 5).value();
+    other.waitForFinished();
+    EXPECT_EQ(other.resultAs<int>(0), 10);
+    EXPECT_TRUE(hung.cancel());
+    hung.waitForFinished();
+    EXPECT_EQ(hung.state(), qtpyt::QPyFutureState::Canceled);
+}
+
+TEST(QPyModule, CancelingAnAwaitedCallDoesNotLeakIntoTheWorker) {
+    auto m = qtpyt::QPyModule("import asyncio, qpyasync\n"
+                           "seen = None\n"
+                           "async def big():\n"
+                           "    await asyncio.sleep(0.05)\n"
+                           "    return list(range(1000000))\n"
+                           "async def watch():\n"
+                           "    global seen\n"
+                           "    try:\n"
+                           "        await asyncio.sleep(3600)\n"
+                           "    except asyncio.CancelledError:\n"
+                           "        seen = qpyasync.cancelled()\n"
+                           "        raise\n"
+                           "def work():\n"
+                           "    s = 0\n"
+                           "    for i in range(200000):\n"
+                           "        s += i\n"
+                           "    return s\n"
+                           "def was_seen():\n"
+                           "    return bool(seen)\n", qtpyt::QPySourceType::SourceString);
+    for (int round = 0; round < 5; ++round) {
+        auto call = m.callAsync(nullptr, "big", QMetaType::QVariantList).value();
+        QThread::msleep(45);
+        // keep asking while the result is being converted, after the task has already ended
+        while (call.cancel() && !call.isCompleted()) {
+            QThread::yieldCurrentThread();
+        }
+        call.waitForFinished();
+        EXPECT_TRUE(call.state() == qtpyt::QPyFutureState::Finished ||
+                    call.state() == qtpyt::QPyFutureState::Canceled);
+        // the tests run a single worker: the next call lands on the same thread
+        auto next = m.callAsync(nullptr, "work", QMetaType::LongLong).value();
+        next.waitForFinished();
+        ASSERT_EQ(next.state(), qtpyt::QPyFutureState::Finished);
+        EXPECT_EQ(next.resultAs<qlonglong>(0), 199999LL * 200000 / 2);
+    }
+
+    auto watched = m.callAsync(nullptr, "watch", QMetaType::Void).value();
+    QThread::msleep(20);
+    EXPECT_TRUE(watched.cancel());
+    watched.waitForFinished();
+    EXPECT_EQ(watched.state(), qtpyt::QPyFutureState::Canceled);
+    EXPECT_TRUE(m.call<bool>("was_seen"));
+}
+
 TEST(QPyModule, TestAsyncReturningPySharedArray) {
     auto m = qtpyt::QPyModule("def create_array(n):\n"
                            "    arr = [i * 10 for i in range(n)]\n"
@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/embed.h>
+
+#include <QVariant>
+
+#include "../src/conversions.h"
+#include <qtpyt/qpyringbuffer.h>
+
+#include <thread>
+#include <vector>
+
+namespace py = pybind11;
+
+TEST(QPyRingBuffer, WrapsAndReportsTwoSpans) {
+    qtpyt::QPyRingBuffer<int> ring(6);
+    EXPECT_EQ(ring.capacity(), 8);
+    const int first[6] = {0, 1, 2, 3, 4, 5};
+    EXPECT_EQ(ring.push(first, 6), 6);
+    int out[4];
+    EXPECT_EQ(ring.pop(out, 4), 4);
+    EXPECT_EQ(out[3], 3);
+
+    const int more[8] = {6, 7, 8, 9, 10, 11, 12, 13};
+    EXPECT_EQ(ring.push(more, 8), 6);
+    EXPECT_EQ(ring.droppedCount(), 2u);
+
+    const auto span = ring.readable();
+    ASSERT_EQ(span.size(), 8);
+    EXPECT_EQ(span.firstSize, 4);
+    EXPECT_EQ(span.first[0], 4);
+    EXPECT_EQ(span.second[0], 8);
+    EXPECT_EQ(span.second[3], 11);
+    ring.consume(span.size());
+    EXPECT_TRUE(ring.isEmpty());
+    EXPECT_THROW(ring.consume(1), std::out_of_range);
+}
+
+TEST(QPyRingBuffer, MultipleProducersKeepPerProducerOrder) {
+    qtpyt::QPyRingBuffer<quint64> ring(256, qtpyt::QPyRingMode::MultiProducer);
+    constexpr int producers = 4;
+    constexpr quint64 perProducer = 20000;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&ring, p] {
+            for (quint64 i = 0; i < perProducer;) {
+                if (ring.push((quint64(p) << 32) | i))
+                    ++i;
+            }
+        });
+    }
+
+    std::vector<quint64> next(producers, 0);
+    quint64 received = 0;
+    while (received < producers * perProducer) {
+        ASSERT_TRUE(ring.waitForData(1, 5000));
+        quint64 v;
+        while (ring.pop(&v, 1) == 1) {
+            const int p = int(v >> 32);
+            ASSERT_EQ(v & 0xffffffffu, next[p]);
+            ++next[p];
+            ++received;
+        }
+    }
+    for (auto& t : threads)
+        t.join();
+}
+
+TEST(QPyRingBuffer, PythonReadsZeroCopyViews) {
+    qtpyt::QPyRingBuffer<float> ring(4);
+    const float a[3] = {1.f, 2.f, 3.f};
+    ring.push(a, 3);
+    float skip[2];
+    ring.pop(skip, 2);
+    const float b[3] = {4.f, 5.f, 6.f};
+    ring.push(b, 3);
+
+    py::object reader = qtpyt::qvariantToPyObject(QVariant::fromValue(ring));
+    EXPECT_EQ(reader.attr("__len__")().cast<int>(), 4);
+    EXPECT_EQ(reader.attr("capacity").cast<int>(), 4);
+
+    py::tuple views = reader.attr("read")();
+    py::object first = views[0];
+    py::object second = views[1];
+    EXPECT_EQ(first.attr("format").cast<std::string>(), "f");
+    EXPECT_EQ(py::len(first), 2);
+    EXPECT_EQ(py::len(second), 2);
+    EXPECT_FLOAT_EQ(first[py::int_(0)].cast<float>(), 3.f);
+    EXPECT_FLOAT_EQ(second[py::int_(1)].cast<float>(), 6.f);
+    EXPECT_TRUE(first.attr("readonly").cast<bool>());
+
+    // A slice of a view keeps its elements exported: consume() must not hand them back.
+    py::object part = first[py::slice(0, 1, 1)];
+    EXPECT_THROW(reader.attr("consume")(1), py::error_already_set);
+    EXPECT_EQ(ring.size(), 4);
+    part = py::none();
+
+    reader.attr("consume")(4);
+    EXPECT_TRUE(ring.isEmpty());
+    EXPECT_FALSE(reader.attr("wait")(1, 0.01).cast<bool>());
+    // consume() released the views, so the overwritten storage is no longer reachable
+    EXPECT_THROW(py::object(first[py::int_(0)]), py::error_already_set);
+    EXPECT_THROW(py::object(second[py::int_(0)]), py::error_already_set);
+}
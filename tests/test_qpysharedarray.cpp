@@ -0,0 +1,510 @@
+#include <gtest/gtest.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/embed.h>
+
+#include <QCoreApplication>
+#include <QTemporaryFile>
+#include <QVariant>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../src/conversions.h"
+#include "../src/internal/sharedarrayinternal.h"
+#include <qtpyt/qpyrecord.h>
+#include <qtpyt/qpysharedarray.h>
+
+namespace py = pybind11;
+
+struct TestTick {
+    qint64 timestamp;
+    double price;
+    qint32 volume;
+    char side;
+};
+QTPYT_RECORD(TestTick, timestamp, price, volume, side)
+
+TEST(QPySharedArray, MemoryViewOutlivesArray) {
+    py::object view;
+    {
+        qtpyt::QPySharedArray<int> arr(4);
+        for (int i = 0; i < 4; ++i) {
+            arr[i] = i * 10;
+        }
+        view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    }
+    // every C++ handle is gone, the view still owns the storage
+    ASSERT_TRUE(py::isinstance<py::memoryview>(view));
+    EXPECT_EQ(view[py::int_(0)].cast<int>(), 0);
+    EXPECT_EQ(view[py::int_(3)].cast<int>(), 30);
+}
+
+TEST(QPySharedArray, ResizeDetachesFromExport) {
+    qtpyt::QPySharedArray<double> arr(3);
+    arr[2] = 7.0;
+    EXPECT_EQ(arr.exportCount(), 0);
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    EXPECT_EQ(arr.exportCount(), 1);
+    arr.resize(10);
+    EXPECT_EQ(arr.size(), 10);
+    EXPECT_DOUBLE_EQ(arr.constData()[2], 7.0);
+    // the view keeps the storage it was created over
+    EXPECT_EQ(arr.exportCount(), 0);
+    EXPECT_EQ(py::len(view), 3);
+    EXPECT_DOUBLE_EQ(py::object(view[py::int_(2)]).cast<double>(), 7.0);
+    view.attr("release")();
+}
+
+TEST(QPySharedArray, ReadOnlyExportRejectsWrites) {
+    qtpyt::QPySharedArray<float> arr(2);
+    arr.setReadOnly(true);
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    EXPECT_TRUE(view.attr("readonly").cast<bool>());
+}
+
+TEST(QPySharedArray, TakeOwnershipSurvivesDetach) {
+    auto* raw = new int[3]{1, 2, 3};
+    auto a = qtpyt::QPySharedArray<int>::wrap(raw, 3, true);
+    auto b = a;
+    b.detach();
+    a = qtpyt::QPySharedArray<int>();
+    EXPECT_EQ(b[2], 3);
+}
+
+TEST(QPySharedArray, MapFileReadOnly) {
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    const qint32 values[] = {7, 14, 21, 28};
+    file.write(reinterpret_cast<const char*>(values), sizeof(values));
+    file.flush();
+
+    auto arr = qtpyt::QPySharedArray<qint32>::mapFile(file.fileName(), sizeof(qint32));
+    ASSERT_EQ(arr.size(), 3);
+    EXPECT_TRUE(arr.isReadOnly());
+    EXPECT_EQ(arr.constData()[0], 14);
+    EXPECT_EQ(std::as_const(arr)[2], 28);
+
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    EXPECT_TRUE(view.attr("readonly").cast<bool>());
+    EXPECT_EQ(view[py::int_(1)].cast<int>(), 21);
+
+    // the mapping has no write access: writing goes to a private copy, the file is untouched
+    arr[0] = 99;
+    EXPECT_EQ(arr.constData()[0], 99);
+    EXPECT_FALSE(arr.isReadOnly());
+    EXPECT_EQ(view[py::int_(0)].cast<int>(), 14);
+    file.seek(sizeof(qint32));
+    qint32 first = 0;
+    file.read(reinterpret_cast<char*>(&first), sizeof(first));
+    EXPECT_EQ(first, 14);
+}
+
+TEST(QPySharedArray, MapFileReadWriteWritesThrough) {
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    const double values[] = {1.0, 2.0};
+    file.write(reinterpret_cast<const char*>(values), sizeof(values));
+    file.flush();
+    {
+        auto arr = qtpyt::QPySharedArray<double>::mapFile(file.fileName(), 0, 2, qtpyt::QPyMapMode::ReadWrite);
+        py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+        view[py::int_(1)] = py::float_(4.5);
+    }
+    file.seek(sizeof(double));
+    double second = 0;
+    file.read(reinterpret_cast<char*>(&second), sizeof(second));
+    EXPECT_DOUBLE_EQ(second, 4.5);
+}
+
+TEST(QPySharedArray, SharedMemoryCreateAndAttach) {
+    const QString name = QStringLiteral("qtpyt-test-%1").arg(QCoreApplication::applicationPid());
+    auto producer = qtpyt::QPySharedArray<float>::createSharedMemory(name, 8);
+    auto consumer = qtpyt::QPySharedArray<float>::attachSharedMemory(name, -1, qtpyt::QPyMapMode::ReadOnly);
+    ASSERT_EQ(consumer.size(), 8);
+    EXPECT_TRUE(consumer.isReadOnly());
+
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(producer));
+    view[py::int_(5)] = py::float_(2.5);
+    EXPECT_FLOAT_EQ(consumer.constData()[5], 2.5f);
+}
+
+TEST(QPySharedArray, AllocateLargeIsZeroedAndExported) {
+    auto arr = qtpyt::QPySharedArray<double>::allocateLarge(1 << 20, true);
+    ASSERT_EQ(arr.size(), 1 << 20);
+    EXPECT_EQ(arr.constData()[0], 0.0);
+    EXPECT_EQ(arr.constData()[(1 << 20) - 1], 0.0);
+
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    view[py::int_(1000)] = py::float_(3.0);
+    EXPECT_DOUBLE_EQ(arr.constData()[1000], 3.0);
+}
+
+TEST(QPySharedArray, OversizedRequestThrows) {
+    qtpyt::QPySharedArray<double> arr;
+    EXPECT_THROW(arr.resize(std::numeric_limits<qsizetype>::max() / 4), std::length_error);
+}
+
+TEST(QPySharedArray, PoolRecyclesBuffers) {
+    qtpyt::QPyBufferPool::setEnabled(true);
+    qtpyt::QPyBufferPool::resetStats();
+    const float* first = nullptr;
+    {
+        qtpyt::QPySharedArray<float> arr(1000);
+        first = arr.constData();
+        EXPECT_GE(arr.capacity(), 1000);
+    }
+    for (int frame = 0; frame < 100; ++frame) {
+        qtpyt::QPySharedArray<float> arr(1000);
+        EXPECT_EQ(arr.constData(), first);
+        arr[0] = float(frame);
+    }
+    const auto stats = qtpyt::QPyBufferPool::stats();
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 100u);
+    qtpyt::QPyBufferPool::setEnabled(false);
+    qtpyt::QPyBufferPool::trim();
+}
+
+TEST(QPySharedArray, DisabledPoolLeavesBookkeepingToTheHeap) {
+    qtpyt::QPyBufferPool::setEnabled(false);
+    qtpyt::QPyBufferPool::resetStats();
+    for (int i = 0; i < 10; ++i) {
+        qtpyt::QPySharedArray<int> arr(16);
+        arr[0] = i;
+    }
+    const auto stats = qtpyt::QPyBufferPool::stats();
+    EXPECT_EQ(stats.smallHits, 0u);
+    EXPECT_EQ(stats.smallMisses, 0u);
+    EXPECT_EQ(stats.misses, 0u);
+}
+
+TEST(QPySharedArray, PooledCopiesDetach) {
+    qtpyt::QPyBufferPool::setEnabled(true);
+    qtpyt::QPySharedArray<int> a(4);
+    a[1] = 5;
+    auto b = a;
+    b[1] = 7;
+    EXPECT_EQ(a[1], 5);
+    EXPECT_EQ(b[1], 7);
+    EXPECT_NE(a.constData(), b.constData());
+    qtpyt::QPyBufferPool::setEnabled(false);
+    qtpyt::QPyBufferPool::trim();
+}
+
+namespace {
+    void registerTestTick() {
+        static const int id = qtpyt::registerRecordArray<TestTick>("QPySharedArray<TestTick>");
+        Q_UNUSED(id);
+    }
+
+    bool haveNumPy() {
+        try {
+            py::module_::import("numpy");
+            return true;
+        } catch (py::error_already_set&) {
+            return false;
+        }
+    }
+} // namespace
+
+TEST(QPySharedArray, RecordArrayExportsStructFormat) {
+    registerTestTick();
+    qtpyt::QPySharedArray<TestTick> ticks(3);
+    ticks[1] = TestTick{42, 1.5, 100, 'B'};
+
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(ticks));
+    ASSERT_TRUE(py::isinstance<py::memoryview>(view));
+    const std::string format = view.attr("format").cast<std::string>();
+    EXPECT_EQ(format.substr(1), "T{q:timestamp:d:price:i:volume:b:side:3x}");
+    EXPECT_EQ(view.attr("itemsize").cast<int>(), int(sizeof(TestTick)));
+    EXPECT_EQ(view.attr("nbytes").cast<int>(), 3 * int(sizeof(TestTick)));
+
+    // The raw bytes are the C++ objects; the same layout is accepted back without a copy.
+    py::bytes raw = view.attr("cast")("B").attr("tobytes")();
+    EXPECT_EQ(std::memcmp(std::string(raw).data() + sizeof(TestTick), &ticks.constData()[1], sizeof(TestTick)), 0);
+    const auto back = qtpyt::pyObjectToQVariant(view, QByteArray("QPySharedArray<TestTick>"));
+    ASSERT_TRUE(back.has_value() && back->isValid());
+    const auto arr = back->value<qtpyt::QPySharedArray<TestTick>>();
+    EXPECT_EQ(arr.constData(), ticks.constData());
+    EXPECT_EQ(arr[1].volume, 100);
+}
+
+TEST(QPySharedArray, ChangeTrackingReportsTouchedBlocks) {
+    qtpyt::QPySharedArray<double> arr(10000);
+    arr.enableChangeTracking(1024);
+    quint64 version = arr.changedRanges(0).version;
+
+    arr[5000] = 1.0;
+    arr.mutableRange(9990, 10)[0] = 2.0;
+    auto set = arr.changedRanges(version);
+    ASSERT_EQ(set.ranges.size(), 2u);
+    EXPECT_EQ(set.ranges[0].begin, 4096);
+    EXPECT_EQ(set.ranges[0].end, 5120);
+    EXPECT_EQ(set.ranges[1].begin, 9216);
+    EXPECT_EQ(set.ranges[1].end, 10000);
+    EXPECT_GT(set.version, version);
+
+    // The next query repeats them, as a writer may not have finished; after that it is quiet.
+    set = arr.changedRanges(set.version);
+    EXPECT_EQ(set.ranges.size(), 2u);
+    set = arr.changedRanges(set.version);
+    EXPECT_TRUE(set.ranges.empty());
+    version = set.version;
+
+    // A detached copy keeps its own stamps and versions stay comparable.
+    auto copy = arr;
+    copy[0] = 3.0;
+    auto copySet = copy.changedRanges(version);
+    ASSERT_EQ(copySet.ranges.size(), 1u);
+    EXPECT_EQ(copySet.ranges[0].end, 1024);
+    EXPECT_TRUE(arr.changedRanges(version).ranges.empty());
+}
+
+TEST(QPySharedArray, ChangeTrackingFromPython) {
+    qtpyt::QPySharedArray<float> arr(4096);
+    arr.enableChangeTracking(256);
+    const quint64 version = arr.changedRanges(0).version;
+    arr.markChanged(300, 2);
+
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    py::module_ interop = py::module_::import("qt_interop");
+    py::tuple result = interop.attr("changed_ranges")(view, version);
+    py::list ranges = result[0];
+    ASSERT_EQ(py::len(ranges), 1u);
+    py::tuple range = ranges[0];
+    EXPECT_EQ(range[0].cast<int>(), 256);
+    EXPECT_EQ(range[1].cast<int>(), 512);
+
+    interop.attr("mark_changed")(view, 4000, 10);
+    const auto set = arr.changedRanges(result[1].cast<quint64>());
+    ASSERT_EQ(set.ranges.size(), 2u); // the first block once more, see changedRanges()
+    EXPECT_EQ(set.ranges[1].begin, 3840);
+    EXPECT_EQ(set.ranges[1].end, 4096);
+
+    // element indices of a slice are not those of the array
+    py::object slice = view[py::slice(1024, 2048, 1)];
+    EXPECT_THROW(interop.attr("changed_ranges")(slice, version), py::error_already_set);
+    EXPECT_THROW(interop.attr("mark_changed")(slice, 0, 1), py::error_already_set);
+}
+
+TEST(QPySharedArray, ChangeTrackingOnMappedFileSurvivesExport) {
+    QTemporaryFile file;
+    ASSERT_TRUE(file.open());
+    const QByteArray zeros(4096 * sizeof(float), '\0');
+    file.write(zeros);
+    file.flush();
+
+    auto arr = qtpyt::QPySharedArray<float>::mapFile(file.fileName(), 0, -1, qtpyt::QPyMapMode::ReadWrite);
+    arr.enableChangeTracking(256);
+    const quint64 version = arr.changedRanges(0).version;
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+
+    // the export holds the storage, so this write detaches arr; both still map the same file
+    arr[1000] = 1.5f;
+    EXPECT_FLOAT_EQ(view[py::int_(1000)].cast<float>(), 1.5f);
+
+    py::module_ interop = py::module_::import("qt_interop");
+    py::tuple result = interop.attr("changed_ranges")(view, version);
+    py::list ranges = result[0];
+    ASSERT_EQ(py::len(ranges), 1u);
+    py::tuple range = ranges[0];
+    EXPECT_EQ(range[0].cast<int>(), 768);
+    EXPECT_EQ(range[1].cast<int>(), 1024);
+}
+
+TEST(QPySharedArray, ChangeTrackingConcurrentWriterAndReader) {
+    constexpr qsizetype n = 1 << 16;
+    qtpyt::QPySharedArray<qint64> arr(n);
+    arr.enableChangeTracking(256);
+    const qint64* source = arr.constData(); // neither resized nor copied, so it stays put
+    std::vector<qint64> mirror(size_t(n));
+    quint64 version = 0;
+    auto sync = [&] {
+        const auto set = arr.changedRanges(version);
+        for (const auto& r : set.ranges)
+            std::memcpy(&mirror[size_t(r.begin)], source + r.begin, size_t(r.end - r.begin) * sizeof(qint64));
+        version = set.version;
+    };
+    sync();
+
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (qint64 round = 1; round <= 200; ++round) {
+            for (qsizetype i = round % 97; i < n; i += 97)
+                arr[i] = round;
+        }
+        done.store(true);
+    });
+    while (!done.load())
+        sync();
+    writer.join();
+    sync();
+
+    EXPECT_EQ(std::memcmp(mirror.data(), arr.constData(), size_t(n) * sizeof(qint64)), 0);
+}
+
+TEST(QPySharedArray, DLPackRoundTripIsZeroCopy) {
+    qtpyt::QPySharedArray<float> arr(8);
+    for (int i = 0; i < 8; ++i)
+        arr[i] = float(i);
+
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    py::object exporter = view.attr("obj");
+    py::tuple device = exporter.attr("__dlpack_device__")();
+    EXPECT_EQ(device[0].cast<int>(), 1);
+
+    py::object capsule = exporter.attr("__dlpack__")(py::arg("max_version") = py::make_tuple(1, 0));
+    EXPECT_TRUE(PyCapsule_IsValid(capsule.ptr(), "dltensor_versioned"));
+    const int exportsWithCapsule = arr.exportCount();
+
+    // A producer that only implements the DLPack protocol (no buffer interface).
+    py::dict scope;
+    py::exec(R"(
+class Tensor:
+    def __init__(self, capsule):
+        self.capsule = capsule
+    def __dlpack_device__(self):
+        return (1, 0)
+    def __dlpack__(self, max_version=None):
+        return self.capsule
+)", scope);
+    py::object tensor = scope["Tensor"](capsule);
+
+    const auto v = qtpyt::pyObjectToQVariant(tensor, QByteArray("QPySharedArray<float>"));
+    ASSERT_TRUE(v.has_value());
+    auto imported = v->value<qtpyt::QPySharedArray<float>>();
+    EXPECT_EQ(imported.size(), 8);
+    EXPECT_EQ(imported.constData(), arr.constData());
+    EXPECT_FLOAT_EQ(imported[5], 5.f);
+    EXPECT_TRUE(PyCapsule_IsValid(capsule.ptr(), "used_dltensor_versioned"));
+
+    // The imported array keeps the tensor (and its export count) alive until it is dropped.
+    tensor = py::object();
+    capsule = py::object();
+    EXPECT_EQ(arr.exportCount(), exportsWithCapsule);
+    imported = qtpyt::QPySharedArray<float>();
+    EXPECT_EQ(arr.exportCount(), exportsWithCapsule - 1);
+
+    // Mismatched element types are not reinterpreted.
+    py::object ints = scope["Tensor"](exporter.attr("__dlpack__")());
+    const auto wrong = qtpyt::pyObjectToQVariant(ints, QByteArray("QPySharedArray<int>"));
+    EXPECT_FALSE(wrong.has_value() && wrong->isValid());
+}
+
+TEST(QPySharedArray, RefusedDLPackExportFallsBackToTheBuffer) {
+    // like a PyTorch tensor that requires grad: __dlpack__ raises, the buffer protocol works
+    py::dict scope;
+    py::exec(R"(
+import array
+class Grad(array.array):
+    def __dlpack_device__(self):
+        return (1, 0)
+    def __dlpack__(self, max_version=None):
+        raise RuntimeError("Can't export tensors that require gradient")
+values = Grad('f', [1.0, 2.0, 3.0])
+)", scope);
+    const auto v = qtpyt::pyObjectToQVariant(scope["values"], QByteArray("QPySharedArray<float>"));
+    ASSERT_TRUE(v.has_value());
+    const auto imported = v->value<qtpyt::QPySharedArray<float>>();
+    ASSERT_EQ(imported.size(), 3);
+    EXPECT_FLOAT_EQ(imported[2], 3.f);
+}
+
+TEST(QPySharedArray, NumPyExportModeSharesStorage) {
+    try {
+        py::module_::import("numpy");
+    } catch (py::error_already_set&) {
+        GTEST_SKIP() << "NumPy is not installed";
+    }
+    qtpyt::setSharedArrayExportMode<double>(qtpyt::QPyArrayExportMode::NumPy);
+    qtpyt::QPySharedArray<double> arr(6);
+    for (int i = 0; i < 6; ++i)
+        arr[i] = i * 1.5;
+
+    py::object a = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    qtpyt::setSharedArrayExportMode<double>(qtpyt::QPyArrayExportMode::MemoryView);
+
+    py::module_ np = py::module_::import("numpy");
+    ASSERT_TRUE(py::isinstance(a, np.attr("ndarray")));
+    EXPECT_EQ(a.attr("dtype").attr("name").cast<std::string>(), "float64");
+    EXPECT_EQ(a.attr("ctypes").attr("data").cast<std::uintptr_t>(), reinterpret_cast<std::uintptr_t>(arr.constData()));
+    EXPECT_EQ(arr.exportCount(), 1);
+
+    // ndarrays come back without copying, whatever their rank
+    py::object matrix = np.attr("arange")(6, py::arg("dtype") = "float64").attr("reshape")(2, 3);
+    const auto v = qtpyt::pyObjectToQVariant(matrix, QByteArray("QPySharedArray<double>"));
+    ASSERT_TRUE(v.has_value());
+    const auto back = v->value<qtpyt::QPySharedArray<double>>();
+    EXPECT_EQ(back.size(), 6);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(back.constData()), matrix.attr("ctypes").attr("data").cast<std::uintptr_t>());
+
+    a = py::object();
+    EXPECT_EQ(arr.exportCount(), 0);
+}
+
+TEST(QPySharedArray, NumPyExportModeComplex) {
+    if (!haveNumPy())
+        GTEST_SKIP() << "NumPy is not installed";
+    using Complex = std::complex<double>;
+    qtpyt::setSharedArrayExportMode<Complex>(qtpyt::QPyArrayExportMode::NumPy);
+    qtpyt::QPySharedArray<Complex> arr(3);
+    arr[1] = {1.5, -2.0};
+    py::object a = qtpyt::qvariantToPyObject(QVariant::fromValue(arr));
+    qtpyt::setSharedArrayExportMode<Complex>(qtpyt::QPyArrayExportMode::MemoryView);
+
+    py::module_ np = py::module_::import("numpy");
+    ASSERT_TRUE(py::isinstance(a, np.attr("ndarray")));
+    EXPECT_EQ(a.attr("dtype").attr("name").cast<std::string>(), "complex128");
+    EXPECT_EQ(py::object(a[py::int_(1)]).cast<Complex>(), Complex(1.5, -2.0));
+
+    // ndarrays of the same dtype take the zero-copy fast path
+    py::object fresh = np.attr("full")(4, Complex(0.5, 1.0), py::arg("dtype") = "complex128");
+    const auto v = qtpyt::pyObjectToQVariant(fresh, QByteArray("QPySharedArray<std::complex<double>>"));
+    ASSERT_TRUE(v.has_value());
+    const auto back = v->value<qtpyt::QPySharedArray<Complex>>();
+    ASSERT_EQ(back.size(), 4);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(back.constData()), fresh.attr("ctypes").attr("data").cast<std::uintptr_t>());
+    EXPECT_EQ(back[3], Complex(0.5, 1.0));
+}
+
+TEST(QPySharedArray, NumPyExportModeRecords) {
+    if (!haveNumPy())
+        GTEST_SKIP() << "NumPy is not installed";
+    registerTestTick();
+    qtpyt::setSharedArrayExportMode<TestTick>(qtpyt::QPyArrayExportMode::NumPy);
+    qtpyt::QPySharedArray<TestTick> ticks(2);
+    ticks[1] = TestTick{42, 1.5, 100, 'B'};
+    py::object a = qtpyt::qvariantToPyObject(QVariant::fromValue(ticks));
+    qtpyt::setSharedArrayExportMode<TestTick>(qtpyt::QPyArrayExportMode::MemoryView);
+
+    py::module_ np = py::module_::import("numpy");
+    ASSERT_TRUE(py::isinstance(a, np.attr("ndarray")));
+    py::object dtype = a.attr("dtype");
+    EXPECT_EQ(dtype.attr("itemsize").cast<int>(), int(sizeof(TestTick)));
+    EXPECT_EQ(py::len(dtype.attr("names")), 4u);
+    EXPECT_EQ(py::object(a[py::str("volume")][py::int_(1)]).cast<int>(), 100);
+    EXPECT_DOUBLE_EQ(py::object(a[py::str("price")][py::int_(1)]).cast<double>(), 1.5);
+    EXPECT_EQ(a.attr("ctypes").attr("data").cast<std::uintptr_t>(), reinterpret_cast<std::uintptr_t>(ticks.constData()));
+
+    // NumPy spells the same layout differently ("l", no trailing padding); it still comes back
+    // without a copy, both the exported array and one NumPy allocated itself.
+    const auto same = qtpyt::pyObjectToQVariant(a, QByteArray("QPySharedArray<TestTick>"));
+    ASSERT_TRUE(same.has_value() && same->isValid());
+    EXPECT_EQ(same->value<qtpyt::QPySharedArray<TestTick>>().constData(), ticks.constData());
+
+    py::object fresh = np.attr("zeros")(3, py::arg("dtype") = dtype);
+    fresh[py::str("volume")][py::int_(2)] = py::int_(7);
+    const auto v = qtpyt::pyObjectToQVariant(fresh, QByteArray("QPySharedArray<TestTick>"));
+    ASSERT_TRUE(v.has_value() && v->isValid());
+    const auto back = v->value<qtpyt::QPySharedArray<TestTick>>();
+    ASSERT_EQ(back.size(), 3);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(back.constData()), fresh.attr("ctypes").attr("data").cast<std::uintptr_t>());
+    EXPECT_EQ(back[2].volume, 7);
+
+    // a different layout is refused
+    py::object other = np.attr("zeros")(3, py::arg("dtype") = py::str("i8,f8,i4,i1"));
+    const auto refused = qtpyt::pyObjectToQVariant(other, QByteArray("QPySharedArray<TestTick>"));
+    EXPECT_FALSE(refused.has_value() && refused->isValid());
+}
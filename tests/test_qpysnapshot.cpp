@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/embed.h>
+
+#include <QVariant>
+
+#include "../src/conversions.h"
+#include <qtpyt/qpysnapshot.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace py = pybind11;
+
+TEST(QPySnapshotPublisher, ReadersSeeCompleteVersions) {
+    qtpyt::QPySnapshotPublisher<int> publisher(512);
+    std::atomic<bool> stop{false};
+    std::atomic<int> inconsistent{0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < 3; ++r) {
+        readers.emplace_back([&] {
+            quint64 last = 0;
+            while (!stop.load()) {
+                quint64 version = 0;
+                const auto snapshot = publisher.acquire(&version);
+                if (version < last || !snapshot.isReadOnly())
+                    ++inconsistent;
+                last = version;
+                for (int i = 0; i < snapshot.size(); ++i) {
+                    if (snapshot[i] != int(version)) {
+                        ++inconsistent;
+                        break;
+                    }
+                }
+            }
+        });
+    }
+
+    for (int k = 1; k <= 2000; ++k) {
+        auto& back = publisher.beginWrite();
+        int* data = back.data();
+        for (int i = 0; i < back.size(); ++i)
+            data[i] = k;
+        EXPECT_EQ(publisher.publish(), quint64(k));
+    }
+    stop = true;
+    for (auto& t : readers)
+        t.join();
+    EXPECT_EQ(inconsistent.load(), 0);
+}
+
+TEST(QPySnapshotPublisher, ExportedVersionIsNeverOverwritten) {
+    qtpyt::QPySnapshotPublisher<double> publisher(4);
+    auto& back = publisher.beginWrite();
+    back.data()[0] = 1.5;
+    publisher.publish();
+
+    py::object view = qtpyt::qvariantToPyObject(QVariant::fromValue(publisher.acquire()));
+    EXPECT_TRUE(view.attr("readonly").cast<bool>());
+
+    // Rotate through every slot several times while Python still holds version 1.
+    for (int k = 0; k < 16; ++k) {
+        auto& next = publisher.beginWrite(/*copyCurrent*/true);
+        next.data()[0] += 1.0;
+        publisher.publish();
+    }
+    EXPECT_DOUBLE_EQ(view[py::int_(0)].cast<double>(), 1.5);
+    EXPECT_DOUBLE_EQ(publisher.acquire()[0], 17.5);
+    EXPECT_EQ(publisher.version(), 17u);
+}
@@ -0,0 +1,128 @@
+#include <gtest/gtest.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/embed.h>
+
+#include <QVariant>
+
+#include "../src/conversions.h"
+#include <qtpyt/qpytable.h>
+
+namespace py = pybind11;
+
+namespace {
+
+qtpyt::QPyTable makeTable() {
+    qtpyt::QPySharedArray<qint64> ids(10);
+    qtpyt::QPySharedArray<double> values(10);
+    for (int i = 0; i < 10; ++i) {
+        ids[i] = 100 + i;
+        values[i] = i * 0.5;
+    }
+    // rows 3 and 9 are null
+    qtpyt::QPySharedArray<quint8> validity(2);
+    validity[0] = 0xF7;
+    validity[1] = 0x01;
+
+    qtpyt::QPyTable table;
+    table.addColumn("id", ids);
+    table.addColumn("value", values, validity);
+    return table;
+}
+
+} // namespace
+
+TEST(QPyTable, ArrowRoundTripIsZeroCopy) {
+    const qtpyt::QPyTable table = makeTable();
+    ASSERT_EQ(table.rowCount(), 10);
+    EXPECT_EQ(table.columnAt(0).nullCount, 0);
+    EXPECT_EQ(table.columnAt(0).validity, nullptr);
+    EXPECT_EQ(table.columnAt(1).nullCount, 2);
+    qtpyt::QPyTable copy = table;
+    EXPECT_THROW(copy.addColumn("id", qtpyt::QPySharedArray<int>(10)), std::invalid_argument);
+    EXPECT_THROW(copy.addColumn("short", qtpyt::QPySharedArray<int>(3)), std::invalid_argument);
+
+    ArrowArray array{};
+    ArrowSchema schema{};
+    table.exportToArrow(&array, &schema);
+    EXPECT_STREQ(schema.format, "+s");
+    ASSERT_EQ(schema.n_children, 2);
+    EXPECT_STREQ(schema.children[0]->format, "l");
+    EXPECT_STREQ(schema.children[1]->name, "value");
+    EXPECT_EQ(array.children[1]->null_count, 2);
+
+    const qtpyt::QPyTable imported = qtpyt::QPyTable::importFromArrow(&array, &schema);
+    EXPECT_EQ(array.release, nullptr);
+    schema.release(&schema);
+
+    EXPECT_EQ(imported.columnNames(), QStringList({"id", "value"}));
+    EXPECT_EQ(imported.columnAt(1).data, table.columnAt(1).data);
+    EXPECT_FALSE(imported.isValid(1, 3));
+    EXPECT_TRUE(imported.isValid(1, 4));
+
+    const auto values = imported.column<double>("value");
+    EXPECT_EQ(values.size(), 10);
+    EXPECT_DOUBLE_EQ(values[8], 4.0);
+    EXPECT_THROW(imported.column<float>("value"), std::invalid_argument);
+}
+
+TEST(QPyTable, StreamRoundTrip) {
+    const qtpyt::QPyTable table = makeTable();
+    ArrowArrayStream stream{};
+    table.exportToArrowStream(&stream);
+
+    const qtpyt::QPyTable imported = qtpyt::QPyTable::importFromArrowStream(&stream);
+    EXPECT_EQ(stream.release, nullptr);
+    ASSERT_EQ(imported.rowCount(), 10);
+    EXPECT_EQ(imported.column<qint64>("id")[9], 109);
+    EXPECT_EQ(imported.columnAt(0).data, table.columnAt(0).data);
+}
+
+TEST(QPyTable, EmptyStreamRejectsUnsupportedTypes) {
+    // A producer with no batches, whose schema has a string column.
+    ArrowArrayStream stream{};
+    stream.get_schema = [](ArrowArrayStream*, ArrowSchema* out) {
+        static ArrowSchema text{"u", "name", nullptr, 0, 0, nullptr, nullptr, nullptr, nullptr};
+        static ArrowSchema* children[] = {&text};
+        *out = ArrowSchema{"+s", "", nullptr, 0, 1, children, nullptr,
+                           [](ArrowSchema* s) { s->release = nullptr; }, nullptr};
+        return 0;
+    };
+    stream.get_next = [](ArrowArrayStream*, ArrowArray* out) {
+        out->release = nullptr;
+        return 0;
+    };
+    stream.get_last_error = [](ArrowArrayStream*) -> const char* { return nullptr; };
+    stream.release = [](ArrowArrayStream* s) { s->release = nullptr; };
+
+    EXPECT_THROW(qtpyt::QPyTable::importFromArrowStream(&stream), std::runtime_error);
+    EXPECT_EQ(stream.release, nullptr);
+}
+
+TEST(QPyTable, PythonCapsuleProtocol) {
+    py::object t = qtpyt::qvariantToPyObject(QVariant::fromValue(makeTable()));
+    EXPECT_EQ(t.attr("num_rows").cast<int>(), 10);
+    EXPECT_EQ(t.attr("num_columns").cast<int>(), 2);
+
+    py::object ids = t.attr("column")("id");
+    EXPECT_EQ(ids.attr("format").cast<std::string>(), "q");
+    EXPECT_EQ(ids[py::int_(2)].cast<qint64>(), 102);
+    EXPECT_TRUE(t.attr("validity")("id").is_none());
+
+    // A foreign producer that only implements __arrow_c_array__.
+    py::dict scope;
+    py::exec(R"(
+class Producer:
+    def __init__(self, table):
+        self.table = table
+    def __arrow_c_array__(self, requested_schema=None):
+        return self.table.__arrow_c_array__(requested_schema)
+)", scope);
+    py::object producer = scope["Producer"](t);
+
+    const auto v = qtpyt::pyObjectToQVariant(producer, QByteArray("QPyTable"));
+    ASSERT_TRUE(v.has_value());
+    const auto table = v->value<qtpyt::QPyTable>();
+    EXPECT_EQ(table.rowCount(), 10);
+    EXPECT_FALSE(table.isValid(1, 9));
+    EXPECT_DOUBLE_EQ(table.column<double>("value")[2], 1.0);
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include "../src/internal/q_py_mpmc_queue.h"
+#include "../src/internal/q_py_priority_lanes.h"
+#include "../src/internal/q_py_work_stealing.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using qtpyt::detail::QPyAffinityHints;
+using qtpyt::detail::QPyMpmcQueue;
+using qtpyt::detail::QPyPriorityLanes;
+using qtpyt::detail::QPyWorkStealingDeque;
+
+TEST(QPyWorkStealingDeque, OwnerIsLifoThievesAreFifo) {
+    QPyWorkStealingDeque<int> dq(2);
+    for (int i = 0; i < 10; ++i)
+        dq.push(i);     // grows past the initial capacity
+    int v = -1;
+    ASSERT_TRUE(dq.pop(v));
+    EXPECT_EQ(v, 9);
+    ASSERT_TRUE(dq.steal(v));
+    EXPECT_EQ(v, 0);
+    EXPECT_EQ(dq.size(), 8);
+}
+
+TEST(QPyWorkStealingDeque, EveryElementIsTakenExactlyOnce) {
+    QPyWorkStealingDeque<std::intptr_t> dq(4);
+    constexpr int count = 100000;
+    std::vector<std::atomic<int>> taken(count);
+    std::atomic<bool> done{false};
+
+    std::vector<std::thread> thieves;
+    for (int k = 0; k < 3; ++k) {
+        thieves.emplace_back([&] {
+            std::intptr_t v;
+            while (!done.load()) {
+                if (dq.steal(v))
+                    taken[size_t(v)]++;
+            }
+        });
+    }
+    std::intptr_t v;
+    for (int i = 0; i < count; ++i) {
+        dq.push(i);
+        if (i % 3 == 0 && dq.pop(v))
+            taken[size_t(v)]++;
+    }
+    while (dq.pop(v))
+        taken[size_t(v)]++;
+    done = true;
+    for (auto& t : thieves)
+        t.join();
+
+    for (int i = 0; i < count; ++i)
+        ASSERT_EQ(taken[size_t(i)].load(), 1) << "element " << i;
+}
+
+TEST(QPyAffinityHints, RemembersLastWorker) {
+    QPyAffinityHints hints;
+    const quintptr module = 0x7f001234;
+    EXPECT_EQ(hints.lookup(module), QPyAffinityHints::None);
+    hints.record(module, 3);
+    EXPECT_EQ(hints.lookup(module), 3);
+    hints.record(module, 0);
+    EXPECT_EQ(hints.lookup(module), 0);
+}
+
+TEST(QPyMpmcQueue, ReportsFullAndEmpty) {
+    QPyMpmcQueue<int> q(3);     // rounded up to 4
+    EXPECT_EQ(q.capacity(), 4u);
+    int v = -1;
+    EXPECT_FALSE(q.tryPop(v));
+    for (int i = 0; i < 4; ++i)
+        ASSERT_TRUE(q.tryPush(i));
+    EXPECT_FALSE(q.tryPush(4));
+    EXPECT_EQ(q.size(), 4u);
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(q.tryPop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(q.tryPop(v));
+}
+
+TEST(QPyMpmcQueue, EveryElementIsTakenExactlyOnce) {
+    QPyMpmcQueue<std::intptr_t> q(64);
+    constexpr int producers = 2;
+    constexpr int consumers = 2;
+    constexpr int perProducer = 20000;
+    std::vector<std::atomic<int>> taken(producers * perProducer);
+    std::atomic<int> consumed{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < perProducer; ++i) {
+                while (!q.tryPush(p * perProducer + i))
+                    std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < consumers; ++c) {
+        threads.emplace_back([&] {
+            std::intptr_t v;
+            while (consumed.load() < producers * perProducer) {
+                if (q.tryPop(v)) {
+                    taken[size_t(v)]++;
+                    consumed++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads)
+        t.join();
+
+    for (size_t i = 0; i < taken.size(); ++i)
+        ASSERT_EQ(taken[i].load(), 1) << "element " << i;
+}
+
+TEST(QPyPriorityLanes, UrgentLaneIsEarliestDeadlineFirst) {
+    using namespace std::chrono_literals;
+    QPyPriorityLanes<int> lanes;
+    const auto now = QPyPriorityLanes<int>::Clock::now();
+    lanes.pushUrgent(1, now + 30ms);
+    lanes.pushUrgent(2, now + 10ms);
+    lanes.pushUrgent(3, now + 20ms);
+    lanes.pushUrgent(4, now + 10ms);   // same deadline as 2: submission order
+    int v = 0;
+    for (int expected : {2, 4, 3, 1}) {
+        ASSERT_TRUE(lanes.popUrgent(v));
+        EXPECT_EQ(v, expected);
+    }
+    EXPECT_FALSE(lanes.popUrgent(v));
+}
+
+TEST(QPyPriorityLanes, BackgroundAgesAfterThreshold) {
+    using namespace std::chrono_literals;
+    QPyPriorityLanes<int> lanes(100ms);
+    const auto t0 = QPyPriorityLanes<int>::Clock::now();
+    lanes.pushBackground(7, t0);
+    lanes.pushBackground(8, t0 + 50ms);
+    int v = 0;
+    EXPECT_FALSE(lanes.popAgedBackground(v, t0 + 99ms));
+    ASSERT_TRUE(lanes.popAgedBackground(v, t0 + 100ms));
+    EXPECT_EQ(v, 7);
+    EXPECT_FALSE(lanes.popAgedBackground(v, t0 + 100ms));
+    ASSERT_TRUE(lanes.popBackground(v));
+    EXPECT_EQ(v, 8);
+    EXPECT_EQ(lanes.backgroundSize(), 0u);
+}